@@ -53,7 +53,10 @@ let package = Package(
                 "RollbarReport"
             ],
             path: "RollbarNotifier/Sources/RollbarNotifier",
-            resources: [.copy("PrivacyInfo.xcprivacy")]
+            resources: [.copy("PrivacyInfo.xcprivacy")],
+            linkerSettings: [
+                .linkedLibrary("z")
+            ]
         ),
         .target(
             name: "RollbarDeploys",
@@ -53,7 +53,10 @@ let package = Package(
                 "RollbarReport"
             ],
             path: "Sources/RollbarNotifier",
-            resources: [.copy("PrivacyInfo.xcprivacy")]
+            resources: [.copy("PrivacyInfo.xcprivacy")],
+            linkerSettings: [
+                .linkedLibrary("z")
+            ]
         ),
         .testTarget(
             name: "RollbarReportTests",
@@ -38,6 +38,7 @@
 #include "RollbarCrashMonitor_User.h"
 #include "RollbarCrashMonitor_AppState.h"
 #include "RollbarCrashMonitor_Zombie.h"
+#include "RollbarCrashArena.h"
 #include "RollbarCrashDebug.h"
 #include "RollbarCrashThread.h"
 #include "RollbarCrashSystemCapabilities.h"
@@ -220,6 +221,7 @@ bool rcm_notifyFatalExceptionCaptured(bool isAsyncSafeEnvironment)
         g_crashedDuringExceptionHandling = true;
     }
     g_handlingFatalException = true;
+    rcarena_notifyCrashHandlingStarted();
     if(g_crashedDuringExceptionHandling)
     {
         RCLOG_INFO("Detected crash in the crash reporter. Uninstalling RollbarCrash.");
@@ -248,6 +250,7 @@ void rcm_handleException(struct RollbarCrash_MonitorContext* context)
 
     if (context->currentSnapshotUserReported) {
         g_handlingFatalException = false;
+        rcarena_notifyCrashHandlingEnded();
     } else {
         if(g_handlingFatalException && !g_crashedDuringExceptionHandling) {
             RCLOG_DEBUG("Exception is fatal. Restoring original handlers.");
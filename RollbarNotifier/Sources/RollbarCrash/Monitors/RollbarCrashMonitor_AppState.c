@@ -37,8 +37,12 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
 
@@ -57,6 +61,40 @@
 #define kKeySessionsSinceLastCrash "sessionsSinceLastCrash"
 #define kKeySessionsSinceLaunch "sessionsSinceLaunch"
 
+/** Identifies a binary state record ("RCAS"). */
+#define kRecordMagic 0x53414352u
+#define kRecordVersion 1
+
+// ============================================================================
+#pragma mark - Types -
+// ============================================================================
+
+/** One copy of the persisted state.
+ *
+ * The record holds two slots. Each update fills in the slot that does not hold
+ * the latest generation and publishes it by storing its checksum last, so a
+ * process that dies mid-update leaves the previous slot intact.
+ */
+typedef struct
+{
+    uint64_t generation;
+    double activeDurationSinceLastCrash;
+    double backgroundDurationSinceLastCrash;
+    int32_t launchesSinceLastCrash;
+    int32_t sessionsSinceLastCrash;
+    uint32_t crashedLastLaunch;
+    _Atomic uint32_t checksum;
+} RollbarCrashAppStateSlot;
+
+/** Fixed layout of the memory-mapped state file. */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slotSize;
+    RollbarCrashAppStateSlot slots[2];
+} RollbarCrashAppStateRecord;
+
 
 
 // ============================================================================
@@ -69,10 +107,16 @@ static const char* g_stateFilePath;
 /** Current state. */
 static RollbarCrash_AppState g_state;
 
+/** The state file mapped into memory, or NULL if it couldn't be mapped. */
+static RollbarCrashAppStateRecord* g_record;
+
+/** Generation of the most recently written slot. */
+static _Atomic uint64_t g_generation;
+
 static volatile bool g_isEnabled = false;
 
 // ============================================================================
-#pragma mark - JSON Encoding -
+#pragma mark - JSON Decoding -
 // ============================================================================
 
 static int onBooleanElement(const char* const name, const bool value, void* const userData)
@@ -161,16 +205,6 @@ static int onEndData(__unused void* const userData)
 }
 
 
-/** Callback for adding JSON data.
- */
-static int addJSONData(const char* const data, const int length, void* const userData)
-{
-    const int fd = *((int*)userData);
-    const bool success = rcfu_writeBytesToFD(fd, data, length);
-    return success ? RollbarCrashJSON_OK : RollbarCrashJSON_ERROR_CANNOT_ADD_DATA;
-}
-
-
 // ============================================================================
 #pragma mark - Utility -
 // ============================================================================
@@ -187,13 +221,14 @@ static double timeSince(double timeInSeconds)
     return getCurrentTime() - timeInSeconds;
 }
 
-/** Load the persistent state portion of a crash context.
+/** Load the persistent state portion of a crash context from a JSON state file
+ * written by an earlier version.
  *
  * @param path The path to the file to read.
  *
  * @return true if the operation was successful.
  */
-static bool loadState(const char* const path)
+static bool loadLegacyState(const char* const path)
 {
     // Stop if the file doesn't exist.
     // This is expected on the first run of the app.
@@ -243,81 +278,147 @@ static bool loadState(const char* const path)
     return true;
 }
 
-/** Save the persistent state portion of a crash context.
+static uint32_t slotChecksum(const RollbarCrashAppStateSlot* const slot)
+{
+    // FNV-1a over everything up to the checksum field.
+    const uint8_t* bytes = (const uint8_t*)slot;
+    const size_t length = offsetof(RollbarCrashAppStateSlot, checksum);
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    // Never produce the checksum of a zero-filled (never written) slot.
+    return hash == 0 ? 1 : hash;
+}
+
+static bool isSlotValid(const RollbarCrashAppStateSlot* const slot)
+{
+    const uint32_t checksum = atomic_load_explicit(&slot->checksum, memory_order_acquire);
+    return checksum != 0 && checksum == slotChecksum(slot);
+}
+
+/** Map the binary state file into memory, creating it if necessary.
  *
- * @param path The path to the file to create.
+ * @param path The path to the state file.
  *
- * @return true if the operation was successful.
+ * @return The mapped record, or NULL on failure.
  */
-static bool saveState(const char* const path)
+static RollbarCrashAppStateRecord* mapRecord(const char* const path)
 {
-    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    const int fd = open(path, O_RDWR | O_CREAT, 0644);
     if(fd < 0)
     {
-        RCLOG_ERROR("Could not open file %s for writing: %s",
-                    path,
-                    strerror(errno));
-        return false;
+        RCLOG_ERROR("Could not open file %s: %s", path, strerror(errno));
+        return NULL;
     }
 
-    RollbarCrashJSONEncodeContext JSONContext;
-    rcjson_beginEncode(&JSONContext,
-                       true,
-                       addJSONData,
-                       &fd);
-
-    int result;
-    if((result = rcjson_beginObject(&JSONContext, NULL)) != RollbarCrashJSON_OK)
-    {
-        goto done;
-    }
-    if((result = rcjson_addIntegerElement(&JSONContext,
-                                          kKeyFormatVersion,
-                                          kFormatVersion)) != RollbarCrashJSON_OK)
+    struct stat st;
+    if(fstat(fd, &st) != 0)
     {
-        goto done;
+        RCLOG_ERROR("Could not stat file %s: %s", path, strerror(errno));
+        close(fd);
+        return NULL;
     }
-    // Record this launch crashed state into "crashed last launch" field.
-    if((result = rcjson_addBooleanElement(&JSONContext,
-                                          kKeyCrashedLastLaunch,
-                                          g_state.crashedThisLaunch)) != RollbarCrashJSON_OK)
+    if(st.st_size != (off_t)sizeof(RollbarCrashAppStateRecord) &&
+       ftruncate(fd, (off_t)sizeof(RollbarCrashAppStateRecord)) != 0)
     {
-        goto done;
+        RCLOG_ERROR("Could not resize file %s: %s", path, strerror(errno));
+        close(fd);
+        return NULL;
     }
-    if((result = rcjson_addFloatingPointElement(&JSONContext,
-                                                kKeyActiveDurationSinceLastCrash,
-                                                g_state.activeDurationSinceLastCrash)) != RollbarCrashJSON_OK)
+
+    void* const mapping = mmap(NULL,
+                               sizeof(RollbarCrashAppStateRecord),
+                               PROT_READ | PROT_WRITE,
+                               MAP_SHARED,
+                               fd,
+                               0);
+    close(fd);
+    if(mapping == MAP_FAILED)
     {
-        goto done;
+        RCLOG_ERROR("Could not map file %s: %s", path, strerror(errno));
+        return NULL;
     }
-    if((result = rcjson_addFloatingPointElement(&JSONContext,
-                                                kKeyBackgroundDurationSinceLastCrash,
-                                                g_state.backgroundDurationSinceLastCrash)) != RollbarCrashJSON_OK)
+    return mapping;
+}
+
+/** Load the persistent state portion of a crash context from the mapped record.
+ *
+ * A record with the wrong magic, version or layout is reset.
+ *
+ * @return true if a valid slot was found.
+ */
+static bool loadRecord(RollbarCrashAppStateRecord* const record)
+{
+    if(record->magic != kRecordMagic ||
+       record->version != kRecordVersion ||
+       record->slotSize != sizeof(RollbarCrashAppStateSlot))
     {
-        goto done;
+        if(record->magic != 0)
+        {
+            RCLOG_INFO("Discarding incompatible state record (version %d)", record->version);
+        }
+        memset(record, 0, sizeof(*record));
+        record->magic = kRecordMagic;
+        record->version = kRecordVersion;
+        record->slotSize = sizeof(RollbarCrashAppStateSlot);
+        return false;
     }
-    if((result = rcjson_addIntegerElement(&JSONContext,
-                                          kKeyLaunchesSinceLastCrash,
-                                          g_state.launchesSinceLastCrash)) != RollbarCrashJSON_OK)
+
+    const RollbarCrashAppStateSlot* latest = NULL;
+    for(int i = 0; i < 2; i++)
     {
-        goto done;
+        const RollbarCrashAppStateSlot* slot = &record->slots[i];
+        if(isSlotValid(slot) && (latest == NULL || slot->generation > latest->generation))
+        {
+            latest = slot;
+        }
     }
-    if((result = rcjson_addIntegerElement(&JSONContext,
-                                          kKeySessionsSinceLastCrash,
-                                          g_state.sessionsSinceLastCrash)) != RollbarCrashJSON_OK)
+    if(latest == NULL)
     {
-        goto done;
+        return false;
     }
-    result = rcjson_endEncode(&JSONContext);
 
-done:
-    close(fd);
-    if(result != RollbarCrashJSON_OK)
+    g_state.activeDurationSinceLastCrash = latest->activeDurationSinceLastCrash;
+    g_state.backgroundDurationSinceLastCrash = latest->backgroundDurationSinceLastCrash;
+    g_state.launchesSinceLastCrash = latest->launchesSinceLastCrash;
+    g_state.sessionsSinceLastCrash = latest->sessionsSinceLastCrash;
+    g_state.crashedLastLaunch = latest->crashedLastLaunch != 0;
+    atomic_store(&g_generation, latest->generation);
+    return true;
+}
+
+/** Save the persistent state portion of a crash context.
+ *
+ * This only stores into the mapped file, so it makes no system calls and is
+ * safe to call while handling a crash. The kernel writes the pages back.
+ *
+ * @return true if the operation was successful.
+ */
+static bool saveState(void)
+{
+    RollbarCrashAppStateRecord* const record = g_record;
+    if(record == NULL)
     {
-        RCLOG_ERROR("%s: %s",
-                    path, rcjson_stringForError(result));
         return false;
     }
+
+    const uint64_t generation = atomic_fetch_add(&g_generation, 1) + 1;
+    RollbarCrashAppStateSlot* const slot = &record->slots[generation & 1];
+
+    // Invalidate the slot before touching it so a torn write is never accepted.
+    atomic_store_explicit(&slot->checksum, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->generation = generation;
+    // Record this launch crashed state into "crashed last launch" field.
+    slot->crashedLastLaunch = g_state.crashedThisLaunch;
+    slot->activeDurationSinceLastCrash = g_state.activeDurationSinceLastCrash;
+    slot->backgroundDurationSinceLastCrash = g_state.backgroundDurationSinceLastCrash;
+    slot->launchesSinceLastCrash = g_state.launchesSinceLastCrash;
+    slot->sessionsSinceLastCrash = g_state.sessionsSinceLastCrash;
+    atomic_store_explicit(&slot->checksum, slotChecksum(slot), memory_order_release);
     return true;
 }
 
@@ -346,10 +447,28 @@ static void updateAppState(void)
 #pragma mark - API -
 // ============================================================================
 
-void rcstate_initialize(const char* const stateFilePath)
+void rcstate_initialize(const char* const stateFilePath, const char* const legacyStateFilePath)
 {
     g_stateFilePath = strdup(stateFilePath);
-    loadState(g_stateFilePath);
+    g_record = mapRecord(g_stateFilePath);
+    if(g_record != NULL && loadRecord(g_record))
+    {
+        return;
+    }
+
+    // One-time migration from the JSON state file.
+    if(legacyStateFilePath != NULL && loadLegacyState(legacyStateFilePath))
+    {
+        // The JSON file stored this launch's crashed state as "crashed last launch".
+        const bool crashedThisLaunch = g_state.crashedThisLaunch;
+        g_state.crashedThisLaunch = g_state.crashedLastLaunch;
+        if(saveState())
+        {
+            RCLOG_DEBUG("Migrated %s to %s", legacyStateFilePath, g_stateFilePath);
+            unlink(legacyStateFilePath);
+        }
+        g_state.crashedThisLaunch = crashedThisLaunch;
+    }
 }
 
 bool rcstate_reset(void)
@@ -373,7 +492,7 @@ bool rcstate_reset(void)
         g_state.sessionsSinceLastCrash++;
         g_state.applicationIsInForeground = true;
 
-        return saveState(g_stateFilePath);
+        return saveState();
     }
     return false;
 }
@@ -404,6 +523,7 @@ void rcstate_notifyAppActive(const bool isActive)
                         g_state.activeDurationSinceLaunch, g_state.activeDurationSinceLastCrash, duration);
             g_state.activeDurationSinceLaunch += duration;
             g_state.activeDurationSinceLastCrash += duration;
+            saveState();
         }
     }
 }
@@ -412,8 +532,6 @@ void rcstate_notifyAppInForeground(const bool isInForeground)
 {
     if(g_isEnabled)
     {
-        const char* const stateFilePath = g_stateFilePath;
-
         g_state.applicationIsInForeground = isInForeground;
         if(isInForeground)
         {
@@ -428,8 +546,8 @@ void rcstate_notifyAppInForeground(const bool isInForeground)
         else
         {
             g_state.appStateTransitionTime = getCurrentTime();
-            saveState(stateFilePath);
         }
+        saveState();
     }
 }
 
@@ -437,9 +555,11 @@ void rcstate_notifyAppTerminate(void)
 {
     if(g_isEnabled)
     {
-        const char* const stateFilePath = g_stateFilePath;
         updateAppState();
-        saveState(stateFilePath);
+        if(saveState())
+        {
+            msync(g_record, sizeof(*g_record), MS_ASYNC);
+        }
     }
 }
 
@@ -448,10 +568,9 @@ void rcstate_notifyAppCrash(void)
     RCLOG_TRACE("Trying to update AppState. g_isEnabled: %d", g_isEnabled);
     if(g_isEnabled)
     {
-        const char* const stateFilePath = g_stateFilePath;
         updateAppState();
         g_state.crashedThisLaunch = true;
-        saveState(stateFilePath);
+        saveState();
     }
 }
 
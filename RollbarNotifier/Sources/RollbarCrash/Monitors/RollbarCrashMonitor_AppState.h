@@ -89,10 +89,17 @@ typedef struct
     
 
 /** Initialize the state monitor.
+ *
+ * The state is kept in a small binary record that is memory-mapped and updated
+ * in place, so app state transitions don't touch the file system.
  *
  * @param stateFilePath Where to store on-disk representation of state.
+ *
+ * @param legacyStateFilePath A JSON state file written by an earlier version.
+ *                            It is migrated and deleted if the binary record
+ *                            doesn't exist yet. May be NULL.
  */
-void rcstate_initialize(const char* stateFilePath);
+void rcstate_initialize(const char* stateFilePath, const char* legacyStateFilePath);
 
 /** Reset the crash state.
  */
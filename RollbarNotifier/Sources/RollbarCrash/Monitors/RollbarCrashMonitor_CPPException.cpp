@@ -28,6 +28,7 @@
 #include "RollbarCrashThread.h"
 #include "RollbarCrashMachineContext.h"
 #include "RollbarCrashStackCursor_SelfThread.h"
+#include "RollbarCrashStackCursor_Backtrace.h"
 
 //#define RollbarCrashLogger_LocalLevel TRACE
 #include "RollbarCrashLogger.h"
@@ -42,7 +43,7 @@
 #include <exception>
 #include <typeinfo>
 
-#define STACKTRACE_BUFFER_LENGTH 30
+#define STACKTRACE_BUFFER_LENGTH 100
 #define DESCRIPTION_BUFFER_LENGTH 1000
 
 // Compiler hints for "if" statements
@@ -59,6 +60,9 @@ static volatile bool g_isEnabled = false;
 /** True if the handler should capture the next stack trace. */
 static bool g_captureNextStackTrace = false;
 
+/** Capture the stack of 1 in this many throws. 0 = only capture at terminate. */
+static int g_stackCaptureInterval = 1;
+
 static bool g_cxaSwapEnabled = false;
 
 static std::terminate_handler g_originalTerminateHandler;
@@ -67,10 +71,16 @@ static char g_eventID[37];
 
 static RollbarCrash_MonitorContext g_monitorContext;
 
-// TODO: Thread local storage is not supported < ios 9.
-// Find some other way to do thread local. Maybe storage with lookup by tid?
 static RollbarCrashStackCursor g_stackCursor;
 
+/** Backtrace handed to g_stackCursor when the program terminates. */
+static uintptr_t g_terminateBacktrace[STACKTRACE_BUFFER_LENGTH];
+
+/** Stack of this thread's most recent throw, if it was captured. */
+static __thread uintptr_t t_throwBacktrace[STACKTRACE_BUFFER_LENGTH];
+static __thread int t_throwBacktraceLength;
+static __thread unsigned t_throwCount;
+
 // ============================================================================
 #pragma mark - Callbacks -
 // ============================================================================
@@ -79,7 +89,16 @@ static void captureStackTrace(void*, std::type_info*, void (*)(void*))
 {
     if(g_captureNextStackTrace)
     {
-        rcsc_initSelfThread(&g_stackCursor, 2);
+        int interval = g_stackCaptureInterval;
+        t_throwCount++;
+        if(interval <= 0 || t_throwCount % (unsigned)interval != 0)
+        {
+            // Don't let terminate pick up the stack of an earlier throw.
+            t_throwBacktraceLength = 0;
+            return;
+        }
+        // Skip this function and __cxa_throw (or its decorator).
+        t_throwBacktraceLength = rcsc_captureFramePointers(t_throwBacktrace, STACKTRACE_BUFFER_LENGTH, 2);
     }
 }
 
@@ -124,6 +143,17 @@ static void CPPExceptionTerminate(void)
         RollbarCrash_MonitorContext* crashContext = &g_monitorContext;
         memset(crashContext, 0, sizeof(*crashContext));
 
+        if(t_throwBacktraceLength > 0)
+        {
+            memcpy(g_terminateBacktrace, t_throwBacktrace, sizeof(uintptr_t) * (size_t)t_throwBacktraceLength);
+            rcsc_initWithBacktrace(&g_stackCursor, g_terminateBacktrace, t_throwBacktraceLength, 0);
+        }
+        else
+        {
+            // An uncaught exception terminates before unwinding, so the throw site is still on the stack.
+            rcsc_initSelfThread(&g_stackCursor, 0);
+        }
+
         char descriptionBuff[DESCRIPTION_BUFFER_LENGTH];
         const char* description = descriptionBuff;
         descriptionBuff[0] = 0;
@@ -229,6 +259,11 @@ static bool isEnabled()
     return g_isEnabled;
 }
 
+extern "C" void rcm_cppexception_setStackCaptureInterval(int interval)
+{
+    g_stackCaptureInterval = interval < 0 ? 0 : interval;
+}
+
 extern "C" void rcm_enableSwapCxaThrow(void)
 {
     if (g_cxaSwapEnabled != true)
@@ -35,6 +35,19 @@ extern "C" {
  */
 void rcm_enableSwapCxaThrow(void);
 
+/** Choose which C++ throws capture their stack.
+ * Throw-time capture is a cheap frame-pointer walk, but code that throws and
+ * catches in hot loops may still want to sample or skip it.
+ *
+ * 1 = Capture every throw.
+ * N > 1 = Capture 1 in N throws on each thread.
+ * 0 = Never capture at throw time. The stack is taken when an uncaught
+ *     exception reaches terminate, which still includes the throw site.
+ *
+ * Default: 1
+ */
+void rcm_cppexception_setStackCaptureInterval(int interval);
+
 /** Access the Monitor API.
  */
 RollbarCrashMonitorAPI* rcm_cppexception_getAPI(void);
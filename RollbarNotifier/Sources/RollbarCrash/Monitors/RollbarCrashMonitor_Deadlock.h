@@ -37,8 +37,10 @@ extern "C" {
 
 
 #include "RollbarCrashMonitor.h"
+#include "RollbarCrashWatchdog.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
     
 /** Set the interval between watchdog checks on the main thread.
@@ -48,6 +50,23 @@ extern "C" {
  */
 void rcm_setDeadlockHandlerWatchdogInterval(double value);
 
+/** Set how long the main thread must stall before its stack gets profiled.
+ * While a stall lasts, the main thread's stack is sampled every 10ms.
+ * When it ends, the samples are reported as a non-fatal "MainThreadHang" event,
+ * with the profile as folded stacks in the custom stack trace.
+ *
+ * @param value The stall threshold in seconds (0 = disabled).
+ */
+void rcm_setHangProfilingThreshold(double value);
+
+/** Copy out how many main thread stalls of each duration have been seen.
+ * Bucket i counts stalls shorter than (32ms << i); the last bucket counts all
+ * longer stalls. Durations are measured to the watchdog's check interval.
+ *
+ * @param buckets Array of RollbarCrashWatchdog_HISTOGRAM_BUCKETS counts to fill.
+ */
+void rcm_getMainThreadStallHistogram(uint64_t* buckets);
+
 /** Access the Monitor API.
  */
 RollbarCrashMonitorAPI* rcm_deadlock_getAPI(void);
@@ -29,6 +29,9 @@
 #import "RollbarCrashID.h"
 #import "RollbarCrashThread.h"
 #import "RollbarCrashStackCursor_MachineContext.h"
+#import "RollbarCrashStackCursor_Backtrace.h"
+#import "RollbarCrashJSONCodecObjC.h"
+#import "RollbarCrashWatchdog.h"
 #import <Foundation/Foundation.h>
 
 //#define RollbarCrashLogger_LocalLevel TRACE
@@ -37,8 +40,15 @@
 
 #define kIdleInterval 5.0f
 
+/** Interval between main thread stack samples while a stall is being profiled. */
+#define kHangSampleInterval 0.01
+
+/** Maximum number of distinct stacks kept in a hang profile. */
+#define kMaxProfiledStacks 64
+
+/** Maximum depth of a profiled stack. */
+#define kMaxProfiledStackDepth 64
 
-@class RollbarCrashDeadlockMonitor;
 
 // ============================================================================
 #pragma mark - Globals -
@@ -48,64 +58,194 @@ static volatile bool g_isEnabled = false;
 
 static RollbarCrash_MonitorContext g_monitorContext;
 
-/** Thread which monitors other threads. */
-static RollbarCrashDeadlockMonitor* g_monitor;
+/** Watches the main run loop's heartbeat from its own thread. */
+static RollbarCrashWatchdog g_watchdog;
 
 static RollbarCrashThread g_mainQueueThread;
 
-/** Interval between watchdog pulses. */
+/** Main thread stalls longer than this are fatal deadlocks. */
 static NSTimeInterval g_watchdogInterval = 0;
 
+/** Main thread stalls longer than this get profiled. */
+static NSTimeInterval g_hangThreshold = 0;
 
-// ============================================================================
-#pragma mark - X -
-// ============================================================================
+typedef struct
+{
+    uint64_t hash;
+    int depth;
+    int sampleCount;
+    uintptr_t frames[kMaxProfiledStackDepth];
+} ProfiledStack;
+
+/** Main thread stacks sampled during the current stall, folded by identical stack. */
+typedef struct
+{
+    ProfiledStack stacks[kMaxProfiledStacks];
+    int stackCount;
+    int sampleCount;
+    int droppedSampleCount;
+} HangProfile;
 
-@interface RollbarCrashDeadlockMonitor: NSObject
+static HangProfile g_hangProfile;
 
-@property(nonatomic, readwrite, retain) NSThread* monitorThread;
-@property(atomic, readwrite, assign) BOOL awaitingResponse;
 
-@end
+// ============================================================================
+#pragma mark - Hang profiling -
+// ============================================================================
 
-@implementation RollbarCrashDeadlockMonitor
+static uint64_t hashFrames(const uintptr_t* frames, int depth)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(int i = 0; i < depth; i++)
+    {
+        hash = (hash ^ frames[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
 
-@synthesize monitorThread = _monitorThread;
-@synthesize awaitingResponse = _awaitingResponse;
+static void addSampleToProfile(HangProfile* profile, const uintptr_t* frames, int depth)
+{
+    profile->sampleCount++;
+    uint64_t hash = hashFrames(frames, depth);
+    for(int i = 0; i < profile->stackCount; i++)
+    {
+        ProfiledStack* stack = &profile->stacks[i];
+        if(stack->hash == hash && stack->depth == depth &&
+           memcmp(stack->frames, frames, sizeof(*frames) * (size_t)depth) == 0)
+        {
+            stack->sampleCount++;
+            return;
+        }
+    }
+    if(profile->stackCount >= kMaxProfiledStacks)
+    {
+        profile->droppedSampleCount++;
+        return;
+    }
+    ProfiledStack* stack = &profile->stacks[profile->stackCount++];
+    stack->hash = hash;
+    stack->depth = depth;
+    stack->sampleCount = 1;
+    memcpy(stack->frames, frames, sizeof(*frames) * (size_t)depth);
+}
 
-- (id) init
+/** Take one sample of the main thread's stack.
+ * The main thread is only suspended while its stack is walked. Nothing in between may allocate,
+ * since the main thread could be holding the malloc lock.
+ */
+static void sampleMainThread(void)
 {
-    if((self = [super init]))
+    if(g_mainQueueThread == 0 || thread_suspend((thread_t)g_mainQueueThread) != KERN_SUCCESS)
     {
-        // target (self) is retained until selector (runMonitor) exits.
-        self.monitorThread = [[NSThread alloc] initWithTarget:self selector:@selector(runMonitor) object:nil];
-        self.monitorThread.name = @"RollbarCrash Deadlock Detection Thread";
-        [self.monitorThread start];
+        return;
     }
-    return self;
+    uintptr_t frames[kMaxProfiledStackDepth];
+    int depth = 0;
+    RollbarCrashMC_NEW_CONTEXT(machineContext);
+    rcmc_getContextForThread(g_mainQueueThread, machineContext, false);
+    RollbarCrashStackCursor stackCursor;
+    rcsc_initWithMachineContext(&stackCursor, kMaxProfiledStackDepth, machineContext);
+    while(depth < kMaxProfiledStackDepth && stackCursor.advanceCursor(&stackCursor))
+    {
+        frames[depth++] = stackCursor.stackEntry.address;
+    }
+    thread_resume((thread_t)g_mainQueueThread);
+
+    addSampleToProfile(&g_hangProfile, frames, depth);
 }
 
-- (void) cancel
+/** Render a profiled stack in folded format: "root;...;leaf count". */
+static NSString* foldedStack(const ProfiledStack* stack)
 {
-    [self.monitorThread cancel];
+    NSMutableArray* names = [NSMutableArray arrayWithCapacity:(NSUInteger)stack->depth];
+    RollbarCrashStackCursor stackCursor;
+    rcsc_initWithBacktrace(&stackCursor, stack->frames, stack->depth, 0);
+    while(stackCursor.advanceCursor(&stackCursor))
+    {
+        NSString* name = nil;
+        if(stackCursor.symbolicate(&stackCursor) && stackCursor.stackEntry.symbolName != NULL)
+        {
+            name = [NSString stringWithFormat:@"%@`%s",
+                    stackCursor.stackEntry.imageName == NULL ? @"???" :
+                        [@(stackCursor.stackEntry.imageName) lastPathComponent],
+                    stackCursor.stackEntry.symbolName];
+        }
+        else
+        {
+            name = [NSString stringWithFormat:@"0x%lx", (unsigned long)stackCursor.stackEntry.address];
+        }
+        [names insertObject:name atIndex:0];
+    }
+    return [NSString stringWithFormat:@"%@ %d", [names componentsJoinedByString:@";"], stack->sampleCount];
 }
 
-- (void) watchdogPulse
+/** Report the profile of a stall that has ended as a non-fatal event.
+ * The heaviest stack becomes the main thread's backtrace, and the whole
+ * profile goes in the custom stack trace as folded stacks.
+ */
+static void reportHang(NSTimeInterval duration)
 {
-    __block id blockSelf = self;
-    self.awaitingResponse = YES;
-    dispatch_async(dispatch_get_main_queue(), ^
-                   {
-                       [blockSelf watchdogAnswer];
-                   });
+    HangProfile* profile = &g_hangProfile;
+    const ProfiledStack* heaviestStack = &profile->stacks[0];
+    NSMutableArray* foldedStacks = [NSMutableArray arrayWithCapacity:(NSUInteger)profile->stackCount];
+    for(int i = 0; i < profile->stackCount; i++)
+    {
+        const ProfiledStack* stack = &profile->stacks[i];
+        if(stack->sampleCount > heaviestStack->sampleCount)
+        {
+            heaviestStack = stack;
+        }
+        [foldedStacks addObject:foldedStack(stack)];
+    }
+
+    NSError* error = nil;
+    NSData* jsonData = [RollbarCrashJSONCodec encode:foldedStacks options:0 error:&error];
+    if(jsonData == nil)
+    {
+        RCLOG_ERROR(@"Could not encode hang profile: %@", error);
+    }
+    NSString* json = jsonData == nil ? nil : [[NSString alloc] initWithData:jsonData encoding:NSUTF8StringEncoding];
+    NSString* reason = [NSString stringWithFormat:@"Main thread was unresponsive for %.0f ms (%d samples, %d dropped)",
+                        duration * 1000, profile->sampleCount, profile->droppedSampleCount];
+
+    RollbarCrashMC_NEW_CONTEXT(machineContext);
+    rcmc_getContextForCapturedThread(g_mainQueueThread, machineContext);
+    RollbarCrashStackCursor stackCursor;
+    rcsc_initWithBacktrace(&stackCursor, heaviestStack->frames, heaviestStack->depth, 0);
+    char eventID[37];
+    rcid_generate(eventID);
+
+    RCLOG_DEBUG(@"Filling out context.");
+    RollbarCrash_MonitorContext context;
+    memset(&context, 0, sizeof(context));
+    // Not a crash, so don't record one in the app state.
+    context.currentSnapshotUserReported = true;
+    context.crashType = RollbarCrashMonitorTypeUserReported;
+    context.eventID = eventID;
+    context.registersAreValid = false;
+    context.offendingMachineContext = machineContext;
+    context.stackCursor = &stackCursor;
+    context.crashReason = reason.UTF8String;
+    context.userException.name = "MainThreadHang";
+    context.userException.language = "folded-stacks";
+    context.userException.customStackTrace = json.UTF8String;
+
+    rcm_handleException(&context);
 }
 
-- (void) watchdogAnswer
+static void resetHangProfile(void)
 {
-    self.awaitingResponse = NO;
+    g_hangProfile.stackCount = 0;
+    g_hangProfile.sampleCount = 0;
+    g_hangProfile.droppedSampleCount = 0;
 }
 
-- (void) handleDeadlock
+
+// ============================================================================
+#pragma mark - Watchdog -
+// ============================================================================
+
+static void handleDeadlock(void)
 {
     thread_act_array_t threads = NULL;
     mach_msg_type_number_t numThreads = 0;
@@ -135,38 +275,74 @@ static NSTimeInterval g_watchdogInterval = 0;
     abort();
 }
 
-- (void) runMonitor
+/** How often to look at the main run loop while it is healthy.
+ * If neither check is enabled, just idle until the user changes them.
+ */
+static double healthyCheckInterval(void)
+{
+    double interval = kIdleInterval;
+    if(g_watchdogInterval > 0 && g_watchdogInterval < interval)
+    {
+        interval = g_watchdogInterval;
+    }
+    if(g_hangThreshold > 0 && g_hangThreshold / 2 < interval)
+    {
+        interval = g_hangThreshold / 2;
+    }
+    return interval;
+}
+
+static double onMainThreadStalled(double stallDuration, __unused void* userData)
 {
-    BOOL cancelled = NO;
-    do
+    NSTimeInterval watchdogInterval = g_watchdogInterval;
+    NSTimeInterval hangThreshold = g_hangThreshold;
+    if(watchdogInterval > 0 && stallDuration >= watchdogInterval)
+    {
+        handleDeadlock();
+    }
+    if(hangThreshold > 0)
+    {
+        if(stallDuration < hangThreshold)
+        {
+            return hangThreshold - stallDuration;
+        }
+        sampleMainThread();
+        return kHangSampleInterval;
+    }
+    if(watchdogInterval > 0)
+    {
+        return watchdogInterval - stallDuration;
+    }
+    return 0;
+}
+
+static void onMainThreadStallEnded(double stallDuration, __unused void* userData)
+{
+    if(g_hangProfile.sampleCount > 0)
     {
-        // Only do a watchdog check if the watchdog interval is > 0.
-        // If the interval is <= 0, just idle until the user changes it.
         @autoreleasepool {
-            NSTimeInterval sleepInterval = g_watchdogInterval;
-            BOOL runWatchdogCheck = sleepInterval > 0;
-            if(!runWatchdogCheck)
-            {
-                sleepInterval = kIdleInterval;
-            }
-            [NSThread sleepForTimeInterval:sleepInterval];
-            cancelled = self.monitorThread.isCancelled;
-            if(!cancelled && runWatchdogCheck)
-            {
-                if(self.awaitingResponse)
-                {
-                    [self handleDeadlock];
-                }
-                else
-                {
-                    [self watchdogPulse];
-                }
-            }
+            reportHang(stallDuration);
         }
-    } while (!cancelled);
+        resetHangProfile();
+    }
 }
 
-@end
+/** Feeds the watchdog from the main run loop. Costs one atomic add per activity and never allocates. */
+static void onMainRunLoopActivity(__unused CFRunLoopObserverRef observer, CFRunLoopActivity activity, __unused void* info)
+{
+    switch(activity)
+    {
+        case kCFRunLoopBeforeWaiting:
+            rcwd_willWait(&g_watchdog);
+            break;
+        case kCFRunLoopAfterWaiting:
+            rcwd_didWake(&g_watchdog);
+            break;
+        default:
+            rcwd_heartbeat(&g_watchdog);
+            break;
+    }
+}
 
 // ============================================================================
 #pragma mark - API -
@@ -178,6 +354,21 @@ static void initialize(void)
     if(!isInitialized)
     {
         isInitialized = true;
+        RollbarCrashWatchdogCallbacks callbacks =
+        {
+            .onStalled = onMainThreadStalled,
+            .onStallEnded = onMainThreadStallEnded,
+            .userData = NULL
+        };
+        rcwd_init(&g_watchdog, callbacks, healthyCheckInterval());
+        CFRunLoopObserverRef observer = CFRunLoopObserverCreate(kCFAllocatorDefault,
+                                                                kCFRunLoopAllActivities,
+                                                                true,
+                                                                0,
+                                                                onMainRunLoopActivity,
+                                                                NULL);
+        CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+        CFRelease(observer);
         dispatch_async(dispatch_get_main_queue(), ^{g_mainQueueThread = rcthread_self();});
     }
 }
@@ -189,15 +380,15 @@ static void setEnabled(bool isEnabled)
         g_isEnabled = isEnabled;
         if(isEnabled)
         {
-            RCLOG_DEBUG(@"Creating new deadlock monitor.");
+            RCLOG_DEBUG(@"Starting deadlock monitor.");
             initialize();
-            g_monitor = [[RollbarCrashDeadlockMonitor alloc] init];
+            rcwd_setCheckInterval(&g_watchdog, healthyCheckInterval());
+            rcwd_start(&g_watchdog);
         }
         else
         {
             RCLOG_DEBUG(@"Stopping deadlock monitor.");
-            [g_monitor cancel];
-            g_monitor = nil;
+            rcwd_stop(&g_watchdog);
         }
     }
 }
@@ -220,4 +411,22 @@ RollbarCrashMonitorAPI* rcm_deadlock_getAPI(void)
 void rcm_setDeadlockHandlerWatchdogInterval(double value)
 {
     g_watchdogInterval = value;
+    if(g_isEnabled)
+    {
+        rcwd_setCheckInterval(&g_watchdog, healthyCheckInterval());
+    }
+}
+
+void rcm_setHangProfilingThreshold(double value)
+{
+    g_hangThreshold = value;
+    if(g_isEnabled)
+    {
+        rcwd_setCheckInterval(&g_watchdog, healthyCheckInterval());
+    }
+}
+
+void rcm_getMainThreadStallHistogram(uint64_t* buckets)
+{
+    rcwd_getStallHistogram(&g_watchdog, buckets);
 }
@@ -27,18 +27,144 @@
 #include "RollbarCrashID.h"
 #include "RollbarCrashThread.h"
 #include "RollbarCrashStackCursor_SelfThread.h"
+#include "RollbarCrashStackCursor_Backtrace.h"
+#include "RollbarCrashMemory.h"
 
 //#define RollbarCrashLogger_LocalLevel TRACE
 #include "RollbarCrashLogger.h"
 
+#include <execinfo.h>
 #include <memory.h>
+#include <pthread.h>
+#include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
 
+/** Maximum number of deferred reports waiting to be written. Reports beyond this are dropped. */
+#define MAX_PENDING_REPORTS 16
+
+/** Maximum number of frames captured for a deferred report. */
+#define MAX_BACKTRACE_LENGTH 100
+
+/** A user exception whose backtrace has been captured but whose report has not been written yet. */
+typedef struct
+{
+    char eventID[37];
+    char* name;
+    char* reason;
+    char* language;
+    char* lineOfCode;
+    char* stackTrace;
+    RollbarCrashThread thread;
+    int backtraceLength;
+    uintptr_t backtrace[MAX_BACKTRACE_LENGTH];
+} DeferredReport;
+
 /** Context to fill with crash information. */
 
 static volatile bool g_isEnabled = false;
 
+static DeferredReport g_pendingReports[MAX_PENDING_REPORTS];
+static int g_pendingReportsHead = 0;
+static int g_pendingReportsCount = 0;
+static pthread_mutex_t g_pendingReportsMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_pendingReportsCondition = PTHREAD_COND_INITIALIZER;
+static bool g_hasWriterThreadStarted = false;
+
+
+// ============================================================================
+#pragma mark - Deferred reports -
+// ============================================================================
+
+static char* copyString(const char* string)
+{
+    return string == NULL ? NULL : strdup(string);
+}
+
+static void freeDeferredReport(DeferredReport* report)
+{
+    free(report->name);
+    free(report->reason);
+    free(report->language);
+    free(report->lineOfCode);
+    free(report->stackTrace);
+}
+
+static void writeDeferredReport(DeferredReport* report)
+{
+    RollbarCrashMC_NEW_CONTEXT(machineContext);
+    rcmc_getContextForCapturedThread(report->thread, machineContext);
+    RollbarCrashStackCursor stackCursor;
+    rcsc_initWithBacktrace(&stackCursor, report->backtrace, report->backtraceLength, 0);
+
+    RCLOG_DEBUG("Filling out context.");
+    RollbarCrash_MonitorContext context;
+    memset(&context, 0, sizeof(context));
+    context.crashType = RollbarCrashMonitorTypeUserReported;
+    context.eventID = report->eventID;
+    context.offendingMachineContext = machineContext;
+    context.registersAreValid = false;
+    context.crashReason = report->reason;
+    context.userException.name = report->name;
+    context.userException.language = report->language;
+    context.userException.lineOfCode = report->lineOfCode;
+    context.userException.customStackTrace = report->stackTrace;
+    context.userException.isDeferred = true;
+    context.stackCursor = &stackCursor;
+
+    rcm_handleException(&context);
+}
+
+static void* writePendingReports(__unused void* const userData)
+{
+    pthread_setname_np("RollbarCrash User Report Writer");
+    DeferredReport report;
+    for(;;)
+    {
+        pthread_mutex_lock(&g_pendingReportsMutex);
+        while(g_pendingReportsCount == 0)
+        {
+            pthread_cond_wait(&g_pendingReportsCondition, &g_pendingReportsMutex);
+        }
+        report = g_pendingReports[g_pendingReportsHead];
+        g_pendingReportsHead = (g_pendingReportsHead + 1) % MAX_PENDING_REPORTS;
+        g_pendingReportsCount--;
+        pthread_mutex_unlock(&g_pendingReportsMutex);
+
+        writeDeferredReport(&report);
+        freeDeferredReport(&report);
+    }
+    return NULL;
+}
+
+/** Start the writer thread. Must be called with g_pendingReportsMutex held. */
+static bool startWriterThread(void)
+{
+    if(g_hasWriterThreadStarted)
+    {
+        return true;
+    }
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int error = pthread_create(&thread, &attr, &writePendingReports, NULL);
+    pthread_attr_destroy(&attr);
+    if(error != 0)
+    {
+        RCLOG_ERROR("pthread_create: %s", strerror(error));
+        return false;
+    }
+    g_hasWriterThreadStarted = true;
+    return true;
+}
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
 
 void rcm_reportUserException(const char* name,
                               const char* reason,
@@ -89,6 +215,9 @@ void rcm_reportUserException(const char* name,
 
         rcm_handleException(&context);
 
+        // The app carries on after a user report and may remap memory before
+        // the next one, so what this report learned about readable pages goes now.
+        rcmem_disablePageCache();
         if(logAllThreads)
         {
             rcmc_resumeEnvironment(threads, numThreads);
@@ -100,6 +229,47 @@ void rcm_reportUserException(const char* name,
     }
 }
 
+void rcm_reportUserExceptionDeferred(const char* name,
+                                      const char* reason,
+                                      const char* language,
+                                      const char* lineOfCode,
+                                      const char* stackTrace)
+{
+    if(!g_isEnabled)
+    {
+        RCLOG_WARN("User-reported exception monitor is not installed. Exception has not been recorded.");
+        return;
+    }
+
+    DeferredReport report;
+    report.backtraceLength = backtrace((void**)report.backtrace, MAX_BACKTRACE_LENGTH);
+    report.thread = rcthread_self();
+    rcid_generate(report.eventID);
+    report.name = copyString(name);
+    report.reason = copyString(reason);
+    report.language = copyString(language);
+    report.lineOfCode = copyString(lineOfCode);
+    report.stackTrace = copyString(stackTrace);
+
+    pthread_mutex_lock(&g_pendingReportsMutex);
+    bool isQueued = false;
+    if(g_pendingReportsCount < MAX_PENDING_REPORTS && startWriterThread())
+    {
+        int index = (g_pendingReportsHead + g_pendingReportsCount) % MAX_PENDING_REPORTS;
+        memcpy(&g_pendingReports[index], &report, offsetof(DeferredReport, backtrace) + sizeof(uintptr_t) * (size_t)report.backtraceLength);
+        g_pendingReportsCount++;
+        isQueued = true;
+        pthread_cond_signal(&g_pendingReportsCondition);
+    }
+    pthread_mutex_unlock(&g_pendingReportsMutex);
+
+    if(!isQueued)
+    {
+        RCLOG_WARN("Too many user-reported exceptions are waiting to be written. Exception has not been recorded.");
+        freeDeferredReport(&report);
+    }
+}
+
 static void setEnabled(bool isEnabled)
 {
     g_isEnabled = isEnabled;
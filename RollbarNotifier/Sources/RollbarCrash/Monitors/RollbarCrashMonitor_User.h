@@ -63,6 +63,28 @@ void rcm_reportUserException(const char* name,
                               bool logAllThreads,
                               bool terminateProgram);
 
+/** Report a non-fatal, user defined exception without stopping the world.
+ * Only the calling thread's backtrace is captured here. The report itself is
+ * symbolicated and written later on a background thread, so this returns quickly.
+ * Other threads keep running and are not included in the report.
+ *
+ * @param name The exception name (for namespacing exception types).
+ *
+ * @param reason A description of why the exception occurred.
+ *
+ * @param language A unique language identifier.
+ *
+ * @param lineOfCode A copy of the offending line of code (NULL = ignore).
+ *
+ * @param stackTrace JSON encoded array containing stack trace information (one frame per array entry).
+ *                   The frame structure can be anything you want, including bare strings.
+ */
+void rcm_reportUserExceptionDeferred(const char* name,
+                                      const char* reason,
+                                      const char* language,
+                                      const char* lineOfCode,
+                                      const char* stackTrace);
+
 /** Access the Monitor API.
  */
 RollbarCrashMonitorAPI* rcm_user_getAPI(void);
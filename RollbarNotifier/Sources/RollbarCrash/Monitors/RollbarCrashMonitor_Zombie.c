@@ -31,10 +31,24 @@
 #include "RollbarCrashLogger.h"
 
 #include <objc/runtime.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 
-#define CACHE_SIZE 0x8000
+/** 8192 sets of 3 objects, which takes 512 KiB: as much memory as the
+ * direct-mapped cache of 0x8000 objects this replaced.
+ */
+#define DEFAULT_CACHE_SIZE 0x6000
+
+/** Number of objects remembered per set. A set holds a header and this many
+ * entries, which on 64-bit fills exactly one 64 byte cache line.
+ */
+#define ZOMBIE_WAYS 3
+
+/** How often a reader retries a set that is being written before giving up. */
+#define MAX_READ_ATTEMPTS 3
 
 // Compiler hints for "if" statements
 #define likely_if(x) if(__builtin_expect(x,1))
@@ -47,8 +61,18 @@ typedef struct
     const char* className;
 } Zombie;
 
-static volatile Zombie* g_zombieCache;
-static unsigned g_zombieHashMask;
+typedef struct
+{
+    /** Even while the set is stable, odd while a writer is updating it. */
+    _Atomic(uint32_t) generation;
+    /** The way to overwrite next. Sets are replaced in FIFO order. */
+    uint32_t nextVictim;
+    Zombie zombies[ZOMBIE_WAYS];
+} __attribute__((aligned(64))) ZombieSet;
+
+static ZombieSet* volatile g_zombieSets;
+static unsigned g_zombieSetShift;
+static int g_zombieCacheSize = DEFAULT_CACHE_SIZE;
 
 static volatile bool g_isEnabled = false;
 
@@ -62,9 +86,45 @@ static struct
 
 static inline unsigned hashIndex(const void* object)
 {
-    uintptr_t objPtr = (uintptr_t)object;
-    objPtr >>= (sizeof(object)-1);
-    return objPtr & g_zombieHashMask;
+    // Objects are at least 16 byte aligned, so the low bits carry no information.
+    // Fibonacci hashing mixes all remaining bits into the top of the product.
+    uint64_t bits = (uint64_t)(uintptr_t)object >> 4;
+    return (unsigned)((bits * 0x9E3779B97F4A7C15ULL) >> g_zombieSetShift);
+}
+
+static inline void recordZombie(const void* object, const char* className)
+{
+    ZombieSet* set = g_zombieSets + hashIndex(object);
+    uint32_t generation = atomic_load_explicit(&set->generation, memory_order_relaxed);
+    // If another thread is updating this set, drop this record rather than
+    // make dealloc wait.
+    unlikely_if((generation & 1) != 0 ||
+                !atomic_compare_exchange_strong_explicit(&set->generation,
+                                                         &generation,
+                                                         generation + 1,
+                                                         memory_order_acquire,
+                                                         memory_order_relaxed))
+    {
+        return;
+    }
+
+    unsigned way = set->nextVictim;
+    for(unsigned i = 0; i < ZOMBIE_WAYS; i++)
+    {
+        unlikely_if(set->zombies[i].object == object)
+        {
+            way = i;
+            break;
+        }
+    }
+    if(way == set->nextVictim)
+    {
+        set->nextVictim = (way + 1) % ZOMBIE_WAYS;
+    }
+    set->zombies[way].object = object;
+    set->zombies[way].className = className;
+
+    atomic_store_explicit(&set->generation, generation + 2, memory_order_release);
 }
 
 static bool copyStringIvar(const void* self, const char* ivarName, char* buffer, int bufferLength)
@@ -113,13 +173,10 @@ static void storeException(const void* exception)
 
 static inline void handleDealloc(const void* self)
 {
-    volatile Zombie* cache = g_zombieCache;
-    likely_if(cache != NULL)
+    likely_if(g_zombieSets != NULL)
     {
-        Zombie* zombie = (Zombie*)cache + hashIndex(self);
-        zombie->object = self;
         Class class = object_getClass((id)self);
-        zombie->className = class_getName(class);
+        recordZombie(self, class_getName(class));
         for(; class != nil; class = class_getSuperclass(class))
         {
             unlikely_if(class == g_lastDeallocedException.class)
@@ -156,15 +213,25 @@ CREATE_ZOMBIE_HANDLER_INSTALLER(NSProxy)
 
 static void install(void)
 {
-    unsigned cacheSize = CACHE_SIZE;
-    g_zombieHashMask = cacheSize - 1;
-    g_zombieCache = calloc(cacheSize, sizeof(*g_zombieCache));
-    if(g_zombieCache == NULL)
+    // Round up to a power of two number of sets.
+    unsigned setCount = 2;
+    unsigned setBits = 1;
+    while(setCount * ZOMBIE_WAYS < (unsigned)g_zombieCacheSize)
+    {
+        setCount <<= 1;
+        setBits++;
+    }
+    g_zombieSetShift = 64 - setBits;
+
+    void* sets = NULL;
+    size_t cacheBytes = setCount * sizeof(ZombieSet);
+    if(posix_memalign(&sets, sizeof(ZombieSet), cacheBytes) != 0)
     {
-        RCLOG_ERROR("Error: Could not allocate %u bytes of memory. RollbarCrashZombie NOT installed!",
-              cacheSize * sizeof(*g_zombieCache));
+        RCLOG_ERROR("Error: Could not allocate %zu bytes of memory. RollbarCrashZombie NOT installed!", cacheBytes);
         return;
     }
+    memset(sets, 0, cacheBytes);
+    g_zombieSets = sets;
 
     g_lastDeallocedException.class = objc_getClass("NSException");
     g_lastDeallocedException.address = NULL;
@@ -181,8 +248,8 @@ static void install(void)
 //    uninstallDealloc_NSObject();
 //    uninstallDealloc_NSProxy();
 //
-//    void* ptr = (void*)g_zombieCache;
-//    g_zombieCache = NULL;
+//    void* ptr = (void*)g_zombieSets;
+//    g_zombieSets = NULL;
 //    dispatch_time_t tenSeconds = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(10.0 * NSEC_PER_SEC));
 //    dispatch_after(tenSeconds, dispatch_get_main_queue(), ^
 //    {
@@ -192,20 +259,46 @@ static void install(void)
 
 const char* rczombie_className(const void* object)
 {
-    volatile Zombie* cache = g_zombieCache;
-    if(cache == NULL || object == NULL)
+    ZombieSet* sets = g_zombieSets;
+    if(sets == NULL || object == NULL)
     {
         return NULL;
     }
 
-    Zombie* zombie = (Zombie*)cache + hashIndex(object);
-    if(zombie->object == object)
+    ZombieSet* set = sets + hashIndex(object);
+    for(int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
     {
-        return zombie->className;
+        uint32_t generation = atomic_load_explicit(&set->generation, memory_order_acquire);
+        const char* className = NULL;
+        for(unsigned i = 0; i < ZOMBIE_WAYS; i++)
+        {
+            if(set->zombies[i].object == object)
+            {
+                className = set->zombies[i].className;
+                break;
+            }
+        }
+        atomic_thread_fence(memory_order_acquire);
+        // Only trust what we read if no writer touched the set meanwhile.
+        likely_if((generation & 1) == 0 &&
+                  atomic_load_explicit(&set->generation, memory_order_relaxed) == generation)
+        {
+            return className;
+        }
     }
     return NULL;
 }
 
+void rczombie_setCacheSize(int cacheSize)
+{
+    if(g_zombieSets != NULL)
+    {
+        RCLOG_WARN("Zombie cache is already installed. New size %d will not take effect.", cacheSize);
+        return;
+    }
+    g_zombieCacheSize = cacheSize > 0 ? cacheSize : DEFAULT_CACHE_SIZE;
+}
+
 static void setEnabled(bool isEnabled)
 {
     if(isEnabled != g_isEnabled)
@@ -57,6 +57,14 @@ extern "C" {
  */
 const char* rczombie_className(const void* object);
 
+/** Set how many deallocated objects to remember. The cache is rounded up to
+ * a power of two number of 64 byte sets of 3 objects, so the default takes 512 KiB
+ * and 65536 objects would take 2 MiB. Must be called before the monitor is enabled.
+ *
+ * @param cacheSize The number of objects to track. 0 = use the default (24576).
+ */
+void rczombie_setCacheSize(int cacheSize);
+
 /** Access the Monitor API.
  */
 RollbarCrashMonitorAPI* rcm_zombie_getAPI(void);
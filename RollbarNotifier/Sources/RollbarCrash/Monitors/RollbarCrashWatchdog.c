@@ -0,0 +1,200 @@
+//
+//  RollbarCrashWatchdog.c
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "RollbarCrashWatchdog.h"
+
+//#define RollbarCrashLogger_LocalLevel TRACE
+#include "RollbarCrashLogger.h"
+
+#include <string.h>
+#include <time.h>
+
+
+static double monotonicNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int histogramBucket(double stallDuration)
+{
+    double upperBound = 0.032;
+    int bucket = 0;
+    while(bucket < RollbarCrashWatchdog_HISTOGRAM_BUCKETS - 1 && stallDuration >= upperBound)
+    {
+        bucket++;
+        upperBound *= 2;
+    }
+    return bucket;
+}
+
+/** Wait on the watchdog's condition for up to `seconds`. Must be called with the mutex held. */
+static void waitFor(RollbarCrashWatchdog* watchdog, double seconds)
+{
+#if defined(__APPLE__)
+    struct timespec relative;
+    relative.tv_sec = (time_t)seconds;
+    relative.tv_nsec = (long)((seconds - (double)relative.tv_sec) * 1e9);
+    pthread_cond_timedwait_relative_np(&watchdog->condition, &watchdog->mutex, &relative);
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    double nanoseconds = (double)deadline.tv_nsec + (seconds - (double)(time_t)seconds) * 1e9;
+    deadline.tv_sec += (time_t)seconds + (time_t)(nanoseconds / 1e9);
+    deadline.tv_nsec = (long)nanoseconds % 1000000000L;
+    pthread_cond_timedwait(&watchdog->condition, &watchdog->mutex, &deadline);
+#endif
+}
+
+static void* monitorLoop(void* userData)
+{
+    RollbarCrashWatchdog* watchdog = userData;
+#if defined(__APPLE__)
+    pthread_setname_np("RollbarCrash Watchdog");
+#endif
+    uint64_t lastHeartbeat = atomic_load_explicit(&watchdog->heartbeat, memory_order_relaxed);
+    double lastProgressTime = monotonicNow();
+    bool isStalled = false;
+    double nextCheck = 0;
+
+    pthread_mutex_lock(&watchdog->mutex);
+    while(watchdog->isRunning)
+    {
+        waitFor(watchdog, nextCheck > 0 ? nextCheck : watchdog->checkInterval);
+        if(!watchdog->isRunning)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&watchdog->mutex);
+
+        nextCheck = 0;
+        double now = monotonicNow();
+        uint64_t heartbeat = atomic_load_explicit(&watchdog->heartbeat, memory_order_relaxed);
+        bool isWaiting = atomic_load_explicit(&watchdog->isWaiting, memory_order_relaxed);
+        if(heartbeat != lastHeartbeat || isWaiting)
+        {
+            if(isStalled)
+            {
+                double stallDuration = now - lastProgressTime;
+                atomic_fetch_add_explicit(&watchdog->histogram[histogramBucket(stallDuration)], 1, memory_order_relaxed);
+                if(watchdog->callbacks.onStallEnded != NULL)
+                {
+                    watchdog->callbacks.onStallEnded(stallDuration, watchdog->callbacks.userData);
+                }
+                isStalled = false;
+            }
+            lastHeartbeat = heartbeat;
+            lastProgressTime = now;
+        }
+        else if(heartbeat != 0)
+        {
+            // A loop that has never beaten may just be asleep since before we started watching.
+            isStalled = true;
+            if(watchdog->callbacks.onStalled != NULL)
+            {
+                nextCheck = watchdog->callbacks.onStalled(now - lastProgressTime, watchdog->callbacks.userData);
+            }
+        }
+
+        pthread_mutex_lock(&watchdog->mutex);
+    }
+    pthread_mutex_unlock(&watchdog->mutex);
+    return NULL;
+}
+
+void rcwd_init(RollbarCrashWatchdog* watchdog, RollbarCrashWatchdogCallbacks callbacks, double checkInterval)
+{
+    memset(watchdog, 0, sizeof(*watchdog));
+    watchdog->callbacks = callbacks;
+    watchdog->checkInterval = checkInterval;
+    pthread_mutex_init(&watchdog->mutex, NULL);
+#if defined(__APPLE__)
+    pthread_cond_init(&watchdog->condition, NULL);
+#else
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&watchdog->condition, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
+}
+
+bool rcwd_start(RollbarCrashWatchdog* watchdog)
+{
+    pthread_mutex_lock(&watchdog->mutex);
+    if(watchdog->isRunning)
+    {
+        pthread_mutex_unlock(&watchdog->mutex);
+        return true;
+    }
+    watchdog->isRunning = true;
+    int error = pthread_create(&watchdog->thread, NULL, monitorLoop, watchdog);
+    if(error != 0)
+    {
+        RCLOG_ERROR("pthread_create: %s", strerror(error));
+        watchdog->isRunning = false;
+    }
+    pthread_mutex_unlock(&watchdog->mutex);
+    return error == 0;
+}
+
+void rcwd_stop(RollbarCrashWatchdog* watchdog)
+{
+    pthread_mutex_lock(&watchdog->mutex);
+    if(!watchdog->isRunning)
+    {
+        pthread_mutex_unlock(&watchdog->mutex);
+        return;
+    }
+    watchdog->isRunning = false;
+    pthread_cond_signal(&watchdog->condition);
+    pthread_t thread = watchdog->thread;
+    pthread_mutex_unlock(&watchdog->mutex);
+
+    if(pthread_equal(thread, pthread_self()))
+    {
+        pthread_detach(thread);
+    }
+    else
+    {
+        pthread_join(thread, NULL);
+    }
+}
+
+void rcwd_setCheckInterval(RollbarCrashWatchdog* watchdog, double checkInterval)
+{
+    pthread_mutex_lock(&watchdog->mutex);
+    watchdog->checkInterval = checkInterval;
+    pthread_cond_signal(&watchdog->condition);
+    pthread_mutex_unlock(&watchdog->mutex);
+}
+
+void rcwd_getStallHistogram(RollbarCrashWatchdog* watchdog, uint64_t* buckets)
+{
+    for(int i = 0; i < RollbarCrashWatchdog_HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] = atomic_load_explicit(&watchdog->histogram[i], memory_order_relaxed);
+    }
+}
@@ -0,0 +1,139 @@
+//
+//  RollbarCrashWatchdog.h
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Watchdog core for the main run loop.
+ *
+ * The watched loop reports progress through an atomic heartbeat counter, which
+ * costs one relaxed atomic add per call and never allocates or blocks. A
+ * monitor thread wakes on a timed condition and compares the counter with what
+ * it saw last time. If the loop is busy (not waiting for events) and the
+ * counter has not moved, the loop is stalled.
+ *
+ * The core uses only pthreads and a monotonic clock, so it can be driven by
+ * any loop, not just a CFRunLoop.
+ */
+
+#ifndef HDR_RollbarCrashWatchdog_h
+#define HDR_RollbarCrashWatchdog_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Number of stall duration histogram buckets.
+ * Bucket i counts stalls shorter than (32ms << i). The last bucket counts all longer stalls.
+ */
+#define RollbarCrashWatchdog_HISTOGRAM_BUCKETS 10
+
+typedef struct
+{
+    /** Called on the monitor thread at each check that finds the loop stalled.
+     *
+     * @param stallDuration Seconds since the loop last made progress.
+     * @param userData The watchdog's user data.
+     *
+     * @return Seconds until the next check, or 0 to use the check interval.
+     */
+    double (*onStalled)(double stallDuration, void* userData);
+
+    /** Called on the monitor thread when the loop makes progress after a stall.
+     *
+     * @param stallDuration How long the loop was stalled, in seconds.
+     * @param userData The watchdog's user data.
+     */
+    void (*onStallEnded)(double stallDuration, void* userData);
+
+    void* userData;
+} RollbarCrashWatchdogCallbacks;
+
+typedef struct
+{
+    /** Bumped by the watched loop. Only ever read by the monitor thread. */
+    _Atomic(uint64_t) heartbeat;
+    /** True while the watched loop is waiting for events. Waiting is not stalling. */
+    _Atomic(bool) isWaiting;
+    _Atomic(uint64_t) histogram[RollbarCrashWatchdog_HISTOGRAM_BUCKETS];
+
+    RollbarCrashWatchdogCallbacks callbacks;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    pthread_t thread;
+    double checkInterval;
+    bool isRunning;
+} RollbarCrashWatchdog;
+
+/** Initialize a watchdog. It does not monitor anything until started.
+ *
+ * @param watchdog The watchdog to initialize.
+ * @param callbacks What to call when stalls are detected.
+ * @param checkInterval Seconds between checks while the loop is healthy.
+ */
+void rcwd_init(RollbarCrashWatchdog* watchdog, RollbarCrashWatchdogCallbacks callbacks, double checkInterval);
+
+/** Start the monitor thread.
+ *
+ * @return true if the monitor thread is running.
+ */
+bool rcwd_start(RollbarCrashWatchdog* watchdog);
+
+/** Stop the monitor thread and wait for it to exit, unless called from it. */
+void rcwd_stop(RollbarCrashWatchdog* watchdog);
+
+/** Change the interval between checks. Takes effect immediately. */
+void rcwd_setCheckInterval(RollbarCrashWatchdog* watchdog, double checkInterval);
+
+/** Note that the watched loop made progress. Safe to call from any context. */
+static inline void rcwd_heartbeat(RollbarCrashWatchdog* watchdog)
+{
+    atomic_fetch_add_explicit(&watchdog->heartbeat, 1, memory_order_relaxed);
+}
+
+/** Note that the watched loop is about to wait for events. */
+static inline void rcwd_willWait(RollbarCrashWatchdog* watchdog)
+{
+    atomic_store_explicit(&watchdog->isWaiting, true, memory_order_relaxed);
+    atomic_fetch_add_explicit(&watchdog->heartbeat, 1, memory_order_relaxed);
+}
+
+/** Note that the watched loop has stopped waiting for events. */
+static inline void rcwd_didWake(RollbarCrashWatchdog* watchdog)
+{
+    atomic_store_explicit(&watchdog->isWaiting, false, memory_order_relaxed);
+    atomic_fetch_add_explicit(&watchdog->heartbeat, 1, memory_order_relaxed);
+}
+
+/** Copy out the stall duration histogram.
+ *
+ * @param buckets Array of RollbarCrashWatchdog_HISTOGRAM_BUCKETS counts to fill.
+ */
+void rcwd_getStallHistogram(RollbarCrashWatchdog* watchdog, uint64_t* buckets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_RollbarCrashWatchdog_h
@@ -35,6 +35,8 @@
 #include "RollbarCrashMonitor_Deadlock.h"
 #include "RollbarCrashMonitor_User.h"
 #include "RollbarCrashFileUtils.h"
+#include "RollbarCrashArena.h"
+#include "RollbarCrashID.h"
 #include "RollbarCrashObjC.h"
 #include "RollbarCrashString.h"
 #include "RollbarCrashMonitor_System.h"
@@ -70,6 +72,7 @@ static volatile bool g_installed = 0;
 
 static bool g_shouldAddConsoleLogToReport = false;
 static bool g_shouldPrintPreviousLog = false;
+static bool g_deferUserReports = false;
 static char g_consoleLogPath[RollbarCrashFU_MAX_PATH_LENGTH];
 static RollbarCrashMonitorType g_monitoring = RollbarCrashMonitorTypeProductionSafeMinimal;
 static char g_lastCrashReportFilePath[RollbarCrashFU_MAX_PATH_LENGTH];
@@ -141,6 +144,10 @@ static void onCrash(struct RollbarCrash_MonitorContext* monitorContext)
         strncpy(g_lastCrashReportFilePath, crashReportFilePath, sizeof(g_lastCrashReportFilePath));
         rcreport_writeStandardReport(monitorContext, crashReportFilePath);
 
+        if(monitorContext->userException.isDeferred && g_shouldAddConsoleLogToReport)
+        {
+            rclog_clearLogFile();
+        }
         if(g_reportWrittenCallback)
         {
             g_reportWrittenCallback(reportID);
@@ -164,6 +171,9 @@ RollbarCrashMonitorType rc_install(const char* appName, const char* const instal
     }
     g_installed = 1;
 
+    rcid_initialize();
+    rcarena_initialize(RollbarCrashArena_DEFAULT_SIZE);
+
     char path[RollbarCrashFU_MAX_PATH_LENGTH];
     snprintf(path, sizeof(path), "%s/Reports", installPath);
     rcfu_makePath(path);
@@ -171,8 +181,10 @@ RollbarCrashMonitorType rc_install(const char* appName, const char* const instal
 
     snprintf(path, sizeof(path), "%s/Data", installPath);
     rcfu_makePath(path);
-    snprintf(path, sizeof(path), "%s/Data/CrashState.json", installPath);
-    rcstate_initialize(path);
+    char legacyStatePath[RollbarCrashFU_MAX_PATH_LENGTH];
+    snprintf(legacyStatePath, sizeof(legacyStatePath), "%s/Data/CrashState.json", installPath);
+    snprintf(path, sizeof(path), "%s/Data/CrashState.bin", installPath);
+    rcstate_initialize(path, legacyStatePath);
 
     snprintf(g_consoleLogPath, sizeof(g_consoleLogPath), "%s/Data/ConsoleLog.txt", installPath);
     if(g_shouldPrintPreviousLog)
@@ -218,6 +230,13 @@ void rc_setDeadlockWatchdogInterval(double deadlockWatchdogInterval)
 #endif
 }
 
+void rc_setHangProfilingThreshold(double hangProfilingThreshold)
+{
+#if RollbarCrashCRASH_HAS_OBJC
+    rcm_setHangProfilingThreshold(hangProfilingThreshold);
+#endif
+}
+
 void rc_setSearchQueueNames(bool searchQueueNames)
 {
     rcccd_setSearchQueueNames(searchQueueNames);
@@ -228,6 +247,18 @@ void rc_setIntrospectMemory(bool introspectMemory)
     rcreport_setIntrospectMemory(introspectMemory);
 }
 
+void rc_setZombieCacheSize(int zombieCacheSize)
+{
+#if RollbarCrashCRASH_HAS_OBJC
+    rczombie_setCacheSize(zombieCacheSize);
+#endif
+}
+
+void rc_setTrapsAllocationsDuringCrashHandling(bool trapsAllocations)
+{
+    rcarena_setTrapsAllocations(trapsAllocations);
+}
+
 void rc_setDoNotIntrospectClasses(const char** doNotIntrospectClasses, int length)
 {
     rcreport_setDoNotIntrospectClasses(doNotIntrospectClasses, length);
@@ -258,6 +289,11 @@ void rc_setMaxReportCount(int maxReportCount)
     rccrs_setMaxReportCount(maxReportCount);
 }
 
+void rc_setDeferUserReports(bool deferUserReports)
+{
+    g_deferUserReports = deferUserReports;
+}
+
 void rc_reportUserException(const char* name,
                                  const char* reason,
                                  const char* language,
@@ -266,6 +302,12 @@ void rc_reportUserException(const char* name,
                                  bool logAllThreads,
                                  bool terminateProgram)
 {
+    if(g_deferUserReports && !logAllThreads && !terminateProgram)
+    {
+        // The console log is cleared once the deferred report has been written.
+        rcm_reportUserExceptionDeferred(name, reason, language, lineOfCode, stackTrace);
+        return;
+    }
     rcm_reportUserException(name,
                              reason,
                              language,
@@ -284,6 +326,11 @@ void enableSwapCxaThrow(void)
     rcm_enableSwapCxaThrow();
 }
 
+void rc_setCPPExceptionStackCaptureInterval(int interval)
+{
+    rcm_cppexception_setStackCaptureInterval(interval);
+}
+
 void rc_notifyObjCLoad(void)
 {
     rcstate_notifyObjCLoad();
@@ -335,6 +382,11 @@ int rc_getReportIDs(int64_t* reportIDs, int count)
     return rccrs_getReportIDs(reportIDs, count);
 }
 
+int rc_getReportIDsAfter(int64_t afterID, int64_t* reportIDs, int count)
+{
+    return rccrs_getReportIDsAfter(afterID, reportIDs, count);
+}
+
 char* rc_readReport(int64_t reportID)
 {
     if(reportID <= 0)
@@ -25,132 +25,391 @@
 
 #include "RollbarCrashCachedData.h"
 
+#include "RollbarCrashSystemCapabilities.h"
+
 //#define RollbarCrashLogger_LocalLevel TRACE
 #include "RollbarCrashLogger.h"
 
+#if RollbarCrashCRASH_HOST_APPLE
 #include <mach/mach.h>
+#endif
+#if RollbarCrashCRASH_HAS_PTHREAD_INTROSPECTION
+#include <pthread/introspection.h>
+#endif
+#if RollbarCrashCRASH_HAS_PROCFS
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#endif
 #include <errno.h>
 #include <memory.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
 
 
-#define SWAP_POINTERS(A, B) \
-{ \
-    void* temp = A; \
-    A = B; \
-    B = temp; \
-}
+#define RollbarCrashCCD_MAX_NAME_LENGTH 128
+
+/** How long to wait after a thread event before rebuilding. This coalesces
+ * bursts of thread pool activity and gives new threads time to name themselves.
+ */
+#define RollbarCrashCCD_SETTLE_MICROSECONDS 10000
+
+typedef struct
+{
+    char threadName[RollbarCrashCCD_MAX_NAME_LENGTH];
+    char queueName[RollbarCrashCCD_MAX_NAME_LENGTH];
+} CachedNames;
+
+/** An immutable view of all threads. Once published it is never modified,
+ * only retired and eventually freed by the cache thread.
+ */
+typedef struct CachedSnapshot
+{
+    int threadCount;
+    int threadCapacity;
+    /** Open-addressed hash index. Always a power of two in size. Each slot
+     * holds a thread index + 1, or 0 if the slot is empty.
+     */
+    int indexCapacity;
+    int* index;
+    RollbarCrashThread* threads;
+    CachedNames* names;
+    struct CachedSnapshot* nextRetired;
+} CachedSnapshot;
 
 static int g_pollingIntervalInSeconds;
 static pthread_t g_cacheThread;
-static RollbarCrashThread* g_allMachThreads;
-static RollbarCrashThread* g_allPThreads;
-static const char** g_allThreadNames;
-static const char** g_allQueueNames;
-static int g_allThreadsCount;
+static _Atomic(CachedSnapshot*) g_currentSnapshot;
+/** Snapshots that readers might still be looking at. Only touched by the cache thread. */
+static CachedSnapshot* g_retiredSnapshots;
+/** Number of readers that have frozen the cache. */
 static _Atomic(int) g_semaphoreCount;
 static bool g_searchQueueNames = false;
 static bool g_hasThreadStarted = false;
 
-static void updateThreadList(void)
+#if RollbarCrashCRASH_HAS_PTHREAD_INTROSPECTION
+static semaphore_t g_threadEventSemaphore = SEMAPHORE_NULL;
+static _Atomic(bool) g_threadEventPending;
+static pthread_introspection_hook_t g_previousIntrospectionHook;
+#endif
+
+
+// ============================================================================
+#pragma mark - Snapshots -
+// ============================================================================
+
+static inline uint32_t hashThread(RollbarCrashThread thread)
 {
-    const task_t thisTask = mach_task_self();
-    int oldThreadsCount = g_allThreadsCount;
-    RollbarCrashThread* allMachThreads = NULL;
-    RollbarCrashThread* allPThreads = NULL;
-    static const char** allThreadNames;
-    static const char** allQueueNames;
+    // Thread ports and IDs are small, mostly sequential numbers.
+    // Fibonacci hashing spreads them over the whole index.
+    return (uint32_t)(((uint64_t)thread * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static CachedSnapshot* allocateSnapshot(int threadCapacity)
+{
+    int indexCapacity = 8;
+    while(indexCapacity < threadCapacity * 2)
+    {
+        indexCapacity <<= 1;
+    }
 
+    // One allocation per snapshot: header, then threads, names and index.
+    size_t threadsOffset = sizeof(CachedSnapshot);
+    size_t namesOffset = threadsOffset + sizeof(RollbarCrashThread) * (size_t)threadCapacity;
+    size_t indexOffset = namesOffset + sizeof(CachedNames) * (size_t)threadCapacity;
+    size_t totalSize = indexOffset + sizeof(int) * (size_t)indexCapacity;
+
+    uint8_t* block = calloc(1, totalSize);
+    if(block == NULL)
+    {
+        RCLOG_ERROR("Could not allocate %zu bytes for thread cache", totalSize);
+        return NULL;
+    }
+    CachedSnapshot* snapshot = (CachedSnapshot*)block;
+    snapshot->threadCapacity = threadCapacity;
+    snapshot->indexCapacity = indexCapacity;
+    snapshot->threads = (RollbarCrashThread*)(block + threadsOffset);
+    snapshot->names = (CachedNames*)(block + namesOffset);
+    snapshot->index = (int*)(block + indexOffset);
+    return snapshot;
+}
+
+static int indexOfThread(const CachedSnapshot* const snapshot, RollbarCrashThread thread)
+{
+    if(snapshot == NULL || snapshot->threadCount == 0)
+    {
+        return -1;
+    }
+    const uint32_t mask = (uint32_t)snapshot->indexCapacity - 1;
+    uint32_t slot = hashThread(thread) & mask;
+    for(int probes = 0; probes < snapshot->indexCapacity; probes++)
+    {
+        int entry = snapshot->index[slot];
+        if(entry == 0)
+        {
+            return -1;
+        }
+        if(snapshot->threads[entry - 1] == thread)
+        {
+            return entry - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+/** Add a thread to a snapshot that has not been published yet.
+ *
+ * @return The name storage for the thread, or NULL if the snapshot is full.
+ */
+static CachedNames* addThread(CachedSnapshot* const snapshot, RollbarCrashThread thread)
+{
+    if(snapshot->threadCount >= snapshot->threadCapacity)
+    {
+        return NULL;
+    }
+    int threadIndex = snapshot->threadCount++;
+    snapshot->threads[threadIndex] = thread;
+
+    const uint32_t mask = (uint32_t)snapshot->indexCapacity - 1;
+    uint32_t slot = hashThread(thread) & mask;
+    while(snapshot->index[slot] != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+    snapshot->index[slot] = threadIndex + 1;
+    return &snapshot->names[threadIndex];
+}
+
+static void publishSnapshot(CachedSnapshot* snapshot)
+{
+    CachedSnapshot* oldSnapshot = atomic_exchange(&g_currentSnapshot, snapshot);
+    if(oldSnapshot != NULL)
+    {
+        oldSnapshot->nextRetired = g_retiredSnapshots;
+        g_retiredSnapshots = oldSnapshot;
+    }
+
+    // Readers bump the semaphore count before loading the current snapshot.
+    // If no reader is registered after the exchange above, none of them can
+    // still be holding a retired snapshot.
+    if(atomic_load(&g_semaphoreCount) <= 0)
+    {
+        while(g_retiredSnapshots != NULL)
+        {
+            CachedSnapshot* next = g_retiredSnapshots->nextRetired;
+            free(g_retiredSnapshots);
+            g_retiredSnapshots = next;
+        }
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Thread Enumeration -
+// ============================================================================
+
+#if RollbarCrashCRASH_HOST_APPLE
+
+static CachedSnapshot* createSnapshotOfAllThreads(void)
+{
+    const task_t thisTask = mach_task_self();
     mach_msg_type_number_t allThreadsCount;
     thread_act_array_t threads;
     kern_return_t kr;
     if((kr = task_threads(thisTask, &threads, &allThreadsCount)) != KERN_SUCCESS)
     {
         RCLOG_ERROR("task_threads: %s", mach_error_string(kr));
-        return;
+        return NULL;
     }
 
-    allMachThreads = calloc(allThreadsCount, sizeof(*allMachThreads));
-    allPThreads = calloc(allThreadsCount, sizeof(*allPThreads));
-    allThreadNames = calloc(allThreadsCount, sizeof(*allThreadNames));
-    allQueueNames = calloc(allThreadsCount, sizeof(*allQueueNames));
-    
-    for(mach_msg_type_number_t i = 0; i < allThreadsCount; i++)
+    CachedSnapshot* snapshot = allocateSnapshot((int)allThreadsCount);
+    const bool searchQueueNames = g_searchQueueNames;
+    for(mach_msg_type_number_t i = 0; snapshot != NULL && i < allThreadsCount; i++)
     {
-        char buffer[1000];
         thread_t thread = threads[i];
+        CachedNames* names = addThread(snapshot, (RollbarCrashThread)thread);
         pthread_t pthread = pthread_from_mach_thread_np(thread);
-        allMachThreads[i] = (RollbarCrashThread)thread;
-        allPThreads[i] = (RollbarCrashThread)pthread;
-        if(pthread != 0 && pthread_getname_np(pthread, buffer, sizeof(buffer)) == 0 && buffer[0] != 0)
+        if(pthread != 0 && pthread_getname_np(pthread, names->threadName, sizeof(names->threadName)) != 0)
         {
-            allThreadNames[i] = strdup(buffer);
+            names->threadName[0] = 0;
         }
-        if(g_searchQueueNames && rcthread_getQueueName((RollbarCrashThread)thread, buffer, sizeof(buffer)) && buffer[0] != 0)
+        if(searchQueueNames && !rcthread_getQueueName((RollbarCrashThread)thread, names->queueName, sizeof(names->queueName)))
         {
-            allQueueNames[i] = strdup(buffer);
+            names->queueName[0] = 0;
         }
     }
-    
-    g_allThreadsCount = g_allThreadsCount < (int)allThreadsCount ? g_allThreadsCount : (int)allThreadsCount;
-    SWAP_POINTERS(g_allMachThreads, allMachThreads);
-    SWAP_POINTERS(g_allPThreads, allPThreads);
-    SWAP_POINTERS(g_allThreadNames, allThreadNames);
-    SWAP_POINTERS(g_allQueueNames, allQueueNames);
-    g_allThreadsCount = (int)allThreadsCount;
 
-    if(allMachThreads != NULL)
+    for(mach_msg_type_number_t i = 0; i < allThreadsCount; i++)
+    {
+        mach_port_deallocate(thisTask, threads[i]);
+    }
+    vm_deallocate(thisTask, (vm_address_t)threads, sizeof(thread_t) * allThreadsCount);
+    return snapshot;
+}
+
+#elif RollbarCrashCRASH_HAS_PROCFS
+
+static void readThreadName(const char* const threadID, char* const buffer, int bufLength)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%s/comm", threadID);
+    int fd = open(path, O_RDONLY);
+    if(fd < 0)
     {
-        free(allMachThreads);
+        return;
     }
-    if(allPThreads != NULL)
+    ssize_t bytesRead = read(fd, buffer, (size_t)bufLength - 1);
+    close(fd);
+    if(bytesRead <= 0)
     {
-        free(allPThreads);
+        buffer[0] = 0;
+        return;
     }
-    if(allThreadNames != NULL)
+    if(buffer[bytesRead - 1] == '\n')
     {
-        for(int i = 0; i < oldThreadsCount; i++)
+        bytesRead--;
+    }
+    buffer[bytesRead] = 0;
+}
+
+static CachedSnapshot* createSnapshotOfAllThreads(void)
+{
+    DIR* dir = opendir("/proc/self/task");
+    if(dir == NULL)
+    {
+        RCLOG_ERROR("opendir /proc/self/task: %s", strerror(errno));
+        return NULL;
+    }
+
+    int threadCount = 0;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] != '.')
         {
-            const char* name = allThreadNames[i];
-            if(name != NULL)
-            {
-                free((void*)name);
-            }
+            threadCount++;
         }
-        free(allThreadNames);
     }
-    if(allQueueNames != NULL)
+    rewinddir(dir);
+
+    CachedSnapshot* snapshot = allocateSnapshot(threadCount);
+    while(snapshot != NULL && (entry = readdir(dir)) != NULL)
     {
-        for(int i = 0; i < oldThreadsCount; i++)
+        if(entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        RollbarCrashThread thread = (RollbarCrashThread)strtoul(entry->d_name, NULL, 10);
+        CachedNames* names = addThread(snapshot, thread);
+        if(names == NULL)
         {
-            const char* name = allQueueNames[i];
-            if(name != NULL)
-            {
-                free((void*)name);
-            }
+            // Threads started since we counted will be picked up on the next scan.
+            break;
         }
-        free(allQueueNames);
+        readThreadName(entry->d_name, names->threadName, sizeof(names->threadName));
     }
-    
-    for(mach_msg_type_number_t i = 0; i < allThreadsCount; i++)
+    closedir(dir);
+    return snapshot;
+}
+
+#else
+
+static CachedSnapshot* createSnapshotOfAllThreads(void)
+{
+    return NULL;
+}
+
+#endif
+
+static void updateThreadList(void)
+{
+    CachedSnapshot* snapshot = createSnapshotOfAllThreads();
+    if(snapshot != NULL)
     {
-        mach_port_deallocate(thisTask, threads[i]);
+        publishSnapshot(snapshot);
     }
-    vm_deallocate(thisTask, (vm_address_t)threads, sizeof(thread_t) * allThreadsCount);
 }
 
+
+// ============================================================================
+#pragma mark - Thread Events -
+// ============================================================================
+
+#if RollbarCrashCRASH_HAS_PTHREAD_INTROSPECTION
+
+static void onThreadEvent(unsigned int event, pthread_t thread, void* addr, size_t size)
+{
+    // This runs on the thread that is starting or exiting, so keep it cheap:
+    // just wake the cache thread, and only once per batch of events.
+    if((event == PTHREAD_INTROSPECTION_THREAD_START || event == PTHREAD_INTROSPECTION_THREAD_TERMINATE) &&
+       !pthread_equal(thread, g_cacheThread) &&
+       !atomic_exchange(&g_threadEventPending, true))
+    {
+        semaphore_signal(g_threadEventSemaphore);
+    }
+    if(g_previousIntrospectionHook != NULL)
+    {
+        g_previousIntrospectionHook(event, thread, addr, size);
+    }
+}
+
+static void installThreadEventHook(void)
+{
+    kern_return_t kr = semaphore_create(mach_task_self(), &g_threadEventSemaphore, SYNC_POLICY_FIFO, 0);
+    if(kr != KERN_SUCCESS)
+    {
+        RCLOG_ERROR("semaphore_create: %s. Falling back to polling.", mach_error_string(kr));
+        g_threadEventSemaphore = SEMAPHORE_NULL;
+        return;
+    }
+    g_previousIntrospectionHook = pthread_introspection_hook_install(onThreadEvent);
+}
+
+static bool hasThreadEvents(void)
+{
+    return g_threadEventSemaphore != SEMAPHORE_NULL;
+}
+
+static void waitForThreadEvents(void)
+{
+    semaphore_wait(g_threadEventSemaphore);
+    usleep(RollbarCrashCCD_SETTLE_MICROSECONDS);
+    atomic_store(&g_threadEventPending, false);
+}
+
+#else
+
+static void installThreadEventHook(void)
+{
+}
+
+static bool hasThreadEvents(void)
+{
+    return false;
+}
+
+static void waitForThreadEvents(void)
+{
+}
+
+#endif
+
 static void* monitorCachedData(__unused void* const userData)
 {
     static int quickPollCount = 4;
     usleep(1);
     for(;;)
     {
-        if(g_semaphoreCount <= 0)
+        updateThreadList();
+        if(hasThreadEvents())
         {
-            updateThreadList();
+            waitForThreadEvents();
+            continue;
         }
         unsigned pollintInterval = (unsigned)g_pollingIntervalInSeconds;
         if(quickPollCount > 0)
@@ -164,6 +423,11 @@ static void* monitorCachedData(__unused void* const userData)
     return NULL;
 }
 
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
 void rcccd_init(int pollingIntervalInSeconds)
 {
     if (g_hasThreadStarted == true) {
@@ -171,6 +435,7 @@ void rcccd_init(int pollingIntervalInSeconds)
     }
     g_hasThreadStarted = true;
     g_pollingIntervalInSeconds = pollingIntervalInSeconds;
+    installThreadEventHook();
     pthread_attr_t attr;
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
@@ -187,19 +452,15 @@ void rcccd_init(int pollingIntervalInSeconds)
 
 void rcccd_freeze(void)
 {
-    if(g_semaphoreCount++ <= 0)
-    {
-        // Sleep just in case the cached data thread is in the middle of an update.
-        usleep(1);
-    }
+    atomic_fetch_add(&g_semaphoreCount, 1);
 }
 
 void rcccd_unfreeze(void)
 {
-    if(--g_semaphoreCount < 0)
+    if(atomic_fetch_sub(&g_semaphoreCount, 1) <= 0)
     {
         // Handle extra calls to unfreeze somewhat gracefully.
-        g_semaphoreCount++;
+        atomic_fetch_add(&g_semaphoreCount, 1);
     }
 }
 
@@ -210,39 +471,32 @@ void rcccd_setSearchQueueNames(bool searchQueueNames)
 
 RollbarCrashThread* rcccd_getAllThreads(int* threadCount)
 {
+    CachedSnapshot* snapshot = atomic_load(&g_currentSnapshot);
     if(threadCount != NULL)
     {
-        *threadCount = g_allThreadsCount;
+        *threadCount = snapshot != NULL ? snapshot->threadCount : 0;
     }
-    return g_allMachThreads;
+    return snapshot != NULL ? snapshot->threads : NULL;
 }
 
 const char* rcccd_getThreadName(RollbarCrashThread thread)
 {
-    if(g_allThreadNames != NULL)
+    CachedSnapshot* snapshot = atomic_load(&g_currentSnapshot);
+    int threadIndex = indexOfThread(snapshot, thread);
+    if(threadIndex >= 0 && snapshot->names[threadIndex].threadName[0] != 0)
     {
-        for(int i = 0; i < g_allThreadsCount; i++)
-        {
-            if(g_allMachThreads[i] == thread)
-            {
-                return g_allThreadNames[i];
-            }
-        }
+        return snapshot->names[threadIndex].threadName;
     }
     return NULL;
 }
 
 const char* rcccd_getQueueName(RollbarCrashThread thread)
 {
-    if(g_allQueueNames != NULL)
+    CachedSnapshot* snapshot = atomic_load(&g_currentSnapshot);
+    int threadIndex = indexOfThread(snapshot, thread);
+    if(threadIndex >= 0 && snapshot->names[threadIndex].queueName[0] != 0)
     {
-        for(int i = 0; i < g_allThreadsCount; i++)
-        {
-            if(g_allMachThreads[i] == thread)
-            {
-                return g_allQueueNames[i];
-            }
-        }
+        return snapshot->names[threadIndex].queueName;
     }
     return NULL;
 }
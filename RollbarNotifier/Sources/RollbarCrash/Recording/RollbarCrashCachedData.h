@@ -24,18 +24,36 @@
 
 
 /* Maintains a cache of difficult-to-retrieve data.
+ *
+ * Thread and queue names are kept in an immutable, hash-indexed snapshot that
+ * is rebuilt on a background thread whenever threads start or exit (pthread
+ * introspection hooks on Apple platforms, /proc/self/task scans elsewhere).
+ * Readers access the published snapshot without taking any locks, so the
+ * accessors below are safe to call from a crash handler.
  */
 
 
 #include "RollbarCrashThread.h"
 
+/** Start maintaining the cache.
+ *
+ * @param pollingIntervalInSeconds How often to rescan threads on hosts that
+ *                                 cannot be notified of thread start and exit.
+ *                                 Ignored where thread events are available.
+ */
 void rcccd_init(int pollingIntervalInSeconds);
 
+/** Pin the currently published snapshot. Until the matching call to
+ * rcccd_unfreeze(), no snapshot handed out by the accessors will be freed.
+ */
 void rcccd_freeze(void);
 void rcccd_unfreeze(void);
 
 void rcccd_setSearchQueueNames(bool searchQueueNames);
 
+/** Get all threads known to the cache.
+ * The returned array is only guaranteed to stay valid while frozen.
+ */
 RollbarCrashThread* rcccd_getAllThreads(int* threadCount);
 
 const char* rcccd_getThreadName(RollbarCrashThread thread);
@@ -0,0 +1,1026 @@
+//
+//  RollbarCrashDiagnosis.c
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "RollbarCrashDiagnosis.h"
+
+#include "RollbarCrashReportFields.h"
+#include "RollbarCrashJSONCodec.h"
+
+//#define RollbarCrashLogger_LocalLevel TRACE
+#include "RollbarCrashLogger.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DEPTH 100
+#define MAX_NAME_LENGTH 100
+#define MAX_STRING_LENGTH 500
+#define MAX_DIAGNOSIS_LENGTH 2000
+#define MAX_OBJECT_NAMES 32
+#define PARAM_COUNT 4
+#define REGISTER_COUNT (PARAM_COUNT * 3)
+
+
+// ============================================================================
+#pragma mark - Types -
+// ============================================================================
+
+typedef enum
+{
+    CPUFamilyUnknown,
+    CPUFamilyArm,
+    CPUFamilyX86,
+    CPUFamilyX86_64
+} CPUFamily;
+
+/** Registers holding the first four call parameters, for each CPU family.
+ * The CPU family may only be known after the registers have been decoded, so
+ * all of them are collected.
+ */
+static const char* const g_paramRegisterNames[REGISTER_COUNT] =
+{
+    "r0", "r1", "r2", "r3",
+    "edi", "esi", "edx", "ecx",
+    "rdi", "rsi", "rdx", "rcx",
+};
+
+typedef struct
+{
+    bool hasObjectName;
+    char objectName[MAX_NAME_LENGTH];
+    bool hasSymbolName;
+    char symbolName[MAX_STRING_LENGTH];
+} StackEntry;
+
+typedef struct
+{
+    uintptr_t address;
+    bool isNotable;
+    bool hasType;
+    char type[MAX_NAME_LENGTH];
+    bool hasClassName;
+    char className[MAX_NAME_LENGTH];
+    bool hasPreviousClassName;
+    char previousClassName[MAX_NAME_LENGTH];
+    bool hasValue;
+    char value[MAX_STRING_LENGTH];
+} RegisterInfo;
+
+typedef struct
+{
+    bool isCrashed;
+    bool isStackOverflow;
+    bool isMemoryCorrupted;
+    int entryCount;
+    StackEntry firstEntry;
+    bool hasInAppEntry;
+    StackEntry inAppEntry;
+    /** First entry for each object, kept only while the process name is not
+     * yet known (the report info may come after the threads).
+     */
+    int objectEntryCount;
+    StackEntry objectEntries[MAX_OBJECT_NAMES];
+    RegisterInfo registers[REGISTER_COUNT];
+} ThreadInfo;
+
+/** The fields of one report (the main report or the recrash report). */
+typedef struct
+{
+    bool hasProcessName;
+    char processName[MAX_NAME_LENGTH];
+    char cpuArch[MAX_NAME_LENGTH];
+
+    bool hasError;
+    char errorType[MAX_NAME_LENGTH];
+    bool hasErrorReason;
+    char errorReason[MAX_STRING_LENGTH];
+    uintptr_t errorAddress;
+    bool hasMach;
+    char machExceptionName[MAX_NAME_LENGTH];
+    char signalName[MAX_NAME_LENGTH];
+    bool hasNSExceptionName;
+    char nsexceptionName[MAX_NAME_LENGTH];
+    bool hasNSExceptionReason;
+    char nsexceptionReason[MAX_STRING_LENGTH];
+
+    /** The thread currently being decoded. */
+    ThreadInfo thread;
+    bool hasCrashedThread;
+    bool crashedThreadIsExplicit;
+    ThreadInfo crashedThread;
+
+    /** The backtrace entry currently being decoded. */
+    StackEntry entry;
+
+    /** The notable address currently being decoded. */
+    int notableRegister;
+    RegisterInfo notable;
+} ReportInfo;
+
+typedef struct
+{
+    char names[MAX_DEPTH][MAX_NAME_LENGTH];
+    int depth;
+    ReportInfo report;
+    ReportInfo recrashReport;
+} DiagnosisContext;
+
+typedef struct
+{
+    const char* type;
+    const char* className;
+    const char* previousClassName;
+    const char* value;
+    bool isInstance;
+    char addressString[24];
+} Param;
+
+typedef struct
+{
+    char buffer[MAX_DIAGNOSIS_LENGTH];
+    int length;
+} Diagnosis;
+
+
+// ============================================================================
+#pragma mark - Utility -
+// ============================================================================
+
+static void copyString(char* dst, const char* src, size_t size)
+{
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+#define COPY_STRING(DST, SRC) copyString(DST, SRC, sizeof(DST))
+
+static bool isEqual(const char* a, const char* b)
+{
+    return a != NULL && b != NULL && strcmp(a, b) == 0;
+}
+
+static const char* orNull(const char* string)
+{
+    return string != NULL ? string : "(null)";
+}
+
+static void append(Diagnosis* diagnosis, const char* fmt, ...)
+{
+    int remaining = (int)sizeof(diagnosis->buffer) - diagnosis->length;
+    if(remaining <= 1)
+    {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(diagnosis->buffer + diagnosis->length, (size_t)remaining, fmt, args);
+    va_end(args);
+    if(written > 0)
+    {
+        diagnosis->length += written < remaining ? written : remaining - 1;
+    }
+}
+
+static int registerIndex(const char* name)
+{
+    for(int i = 0; i < REGISTER_COUNT; i++)
+    {
+        if(isEqual(name, g_paramRegisterNames[i]))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static CPUFamily cpuFamily(const char* cpuArch)
+{
+    if(strncmp(cpuArch, "arm", 3) == 0)
+    {
+        return CPUFamilyArm;
+    }
+    const char* x86 = strstr(cpuArch, "86");
+    if(cpuArch[0] == 'i' && x86 == cpuArch + 2)
+    {
+        return CPUFamilyX86;
+    }
+    for(const char* ch = cpuArch; *ch != '\0'; ch++)
+    {
+        if(strncasecmp(ch, "x86_64", 6) == 0)
+        {
+            return CPUFamilyX86_64;
+        }
+    }
+    return CPUFamilyUnknown;
+}
+
+
+// ============================================================================
+#pragma mark - Paths -
+// ============================================================================
+
+/** Get the report that the current element belongs to.
+ *
+ * @param offset Receives the depth where that report's own fields start.
+ */
+static ReportInfo* currentReport(DiagnosisContext* context, int* offset)
+{
+    if(context->depth >= 2 && strcmp(context->names[1], RollbarCrashField_RecrashReport) == 0)
+    {
+        *offset = 2;
+        return &context->recrashReport;
+    }
+    *offset = 1;
+    return &context->report;
+}
+
+/** Check if the current path, from depth "offset" on, is exactly "path".
+ * NULL in "path" matches any name (array elements have an empty name).
+ */
+static bool isAtPath(const DiagnosisContext* context, int offset, const char* const* path, int pathLength)
+{
+    if(offset < 0 || context->depth > MAX_DEPTH || context->depth - offset != pathLength)
+    {
+        return false;
+    }
+    for(int i = 0; i < pathLength; i++)
+    {
+        if(path[i] != NULL && strcmp(context->names[offset + i], path[i]) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#define IS_AT_PATH(CONTEXT, OFFSET, ...) \
+    isAtPath(CONTEXT, OFFSET, (const char* const[]){__VA_ARGS__}, \
+             (int)(sizeof((const char* const[]){__VA_ARGS__}) / sizeof(const char*)))
+
+/** Get the depth where the fields of the thread being decoded start, or -1 if
+ * not inside a thread.
+ */
+static int threadOffset(const DiagnosisContext* context, int offset)
+{
+    if(context->depth > MAX_DEPTH || context->depth < offset + 2 ||
+       strcmp(context->names[offset], RollbarCrashField_Crash) != 0)
+    {
+        return -1;
+    }
+    if(strcmp(context->names[offset + 1], RollbarCrashField_CrashedThread) == 0)
+    {
+        return offset + 2;
+    }
+    if(strcmp(context->names[offset + 1], RollbarCrashField_Threads) == 0 && context->depth >= offset + 3)
+    {
+        return offset + 3;
+    }
+    return -1;
+}
+
+
+// ============================================================================
+#pragma mark - Collection -
+// ============================================================================
+
+static bool isMemoryCorruptionSymbol(const StackEntry* entry)
+{
+    const char* symbolName = entry->hasSymbolName ? entry->symbolName : NULL;
+    const char* objectName = entry->hasObjectName ? entry->objectName : NULL;
+    return isEqual(symbolName, "objc_autoreleasePoolPush") ||
+           isEqual(symbolName, "free_list_checksum_botch") ||
+           isEqual(symbolName, "szone_malloc_should_clear") ||
+           (isEqual(symbolName, "lookUpMethod") && isEqual(objectName, "libobjc.A.dylib"));
+}
+
+static void onStackEntryEnded(ReportInfo* report)
+{
+    ThreadInfo* thread = &report->thread;
+    const StackEntry* entry = &report->entry;
+
+    if(thread->entryCount++ == 0)
+    {
+        thread->firstEntry = *entry;
+    }
+    if(isMemoryCorruptionSymbol(entry))
+    {
+        thread->isMemoryCorrupted = true;
+    }
+    if(thread->hasInAppEntry || !entry->hasObjectName)
+    {
+        return;
+    }
+
+    if(report->hasProcessName)
+    {
+        if(strcmp(entry->objectName, report->processName) == 0)
+        {
+            thread->inAppEntry = *entry;
+            thread->hasInAppEntry = true;
+        }
+        return;
+    }
+
+    for(int i = 0; i < thread->objectEntryCount; i++)
+    {
+        if(strcmp(thread->objectEntries[i].objectName, entry->objectName) == 0)
+        {
+            return;
+        }
+    }
+    if(thread->objectEntryCount < MAX_OBJECT_NAMES)
+    {
+        thread->objectEntries[thread->objectEntryCount++] = *entry;
+    }
+}
+
+static void onNotableAddressEnded(ReportInfo* report)
+{
+    ThreadInfo* thread = &report->thread;
+    const RegisterInfo* notable = &report->notable;
+
+    if(isEqual(notable->type, "string") && notable->hasValue)
+    {
+        const char* value = notable->value;
+        if((strstr(value, "autorelease pool page") != NULL && strstr(value, "corrupted") != NULL) ||
+           strstr(value, "incorrect checksum for freed object") != NULL)
+        {
+            thread->isMemoryCorrupted = true;
+        }
+    }
+
+    if(report->notableRegister >= 0)
+    {
+        RegisterInfo* reg = &thread->registers[report->notableRegister];
+        uintptr_t address = reg->address;
+        *reg = *notable;
+        reg->address = address;
+        reg->isNotable = true;
+    }
+}
+
+static void onThreadEnded(ReportInfo* report, bool isExplicitCrashedThread)
+{
+    ThreadInfo* thread = &report->thread;
+
+    // An explicit "crashed_thread" wins over a crashed entry in "threads".
+    if(isExplicitCrashedThread || (thread->isCrashed && !report->crashedThreadIsExplicit))
+    {
+        report->crashedThread = *thread;
+        report->hasCrashedThread = true;
+        report->crashedThreadIsExplicit = isExplicitCrashedThread;
+    }
+}
+
+static void setUnsignedValue(DiagnosisContext* context, const char* name, uint64_t value)
+{
+    int offset;
+    ReportInfo* report = currentReport(context, &offset);
+
+    if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error) &&
+       isEqual(name, RollbarCrashField_Address))
+    {
+        report->errorAddress = (uintptr_t)value;
+        return;
+    }
+
+    int thread = threadOffset(context, offset);
+    if(IS_AT_PATH(context, thread, RollbarCrashField_Registers, RollbarCrashField_Basic))
+    {
+        int index = registerIndex(name);
+        if(index >= 0)
+        {
+            report->thread.registers[index].address = (uintptr_t)value;
+        }
+    }
+}
+
+
+// ============================================================================
+#pragma mark - Callbacks -
+// ============================================================================
+
+static int onBooleanElement(const char* const name, const bool value, void* const userData)
+{
+    DiagnosisContext* context = userData;
+    int offset;
+    ReportInfo* report = currentReport(context, &offset);
+    int thread = threadOffset(context, offset);
+
+    if(thread == context->depth && isEqual(name, RollbarCrashField_Crashed))
+    {
+        report->thread.isCrashed = value;
+    }
+    else if(IS_AT_PATH(context, thread, RollbarCrashField_Stack) && isEqual(name, RollbarCrashField_Overflow))
+    {
+        report->thread.isStackOverflow = value;
+    }
+    return RollbarCrashJSON_OK;
+}
+
+static int onFloatingPointElement(const char* const name, const double value, void* const userData)
+{
+    setUnsignedValue(userData, name, (uint64_t)value);
+    return RollbarCrashJSON_OK;
+}
+
+static int onIntegerElement(const char* const name, const int64_t value, void* const userData)
+{
+    setUnsignedValue(userData, name, (uint64_t)value);
+    return RollbarCrashJSON_OK;
+}
+
+static int onNullElement(__unused const char* const name, __unused void* const userData)
+{
+    return RollbarCrashJSON_OK;
+}
+
+static int onStringElement(const char* const name, const char* const value, void* const userData)
+{
+    DiagnosisContext* context = userData;
+    int offset;
+    ReportInfo* report = currentReport(context, &offset);
+    if(name == NULL)
+    {
+        return RollbarCrashJSON_OK;
+    }
+
+    if(IS_AT_PATH(context, offset, RollbarCrashField_Report))
+    {
+        if(strcmp(name, RollbarCrashField_ProcessName) == 0)
+        {
+            COPY_STRING(report->processName, value);
+            report->hasProcessName = true;
+        }
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_System))
+    {
+        if(strcmp(name, RollbarCrashField_CPUArch) == 0)
+        {
+            COPY_STRING(report->cpuArch, value);
+        }
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error))
+    {
+        if(strcmp(name, RollbarCrashField_Type) == 0)
+        {
+            COPY_STRING(report->errorType, value);
+        }
+        else if(strcmp(name, RollbarCrashField_Reason) == 0)
+        {
+            COPY_STRING(report->errorReason, value);
+            report->hasErrorReason = true;
+        }
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error, RollbarCrashField_Mach))
+    {
+        if(strcmp(name, RollbarCrashField_ExceptionName) == 0)
+        {
+            COPY_STRING(report->machExceptionName, value);
+        }
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error, RollbarCrashField_Signal))
+    {
+        if(strcmp(name, RollbarCrashField_Name) == 0)
+        {
+            COPY_STRING(report->signalName, value);
+        }
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error, RollbarCrashField_NSException))
+    {
+        if(strcmp(name, RollbarCrashField_Name) == 0)
+        {
+            COPY_STRING(report->nsexceptionName, value);
+            report->hasNSExceptionName = true;
+        }
+        else if(strcmp(name, RollbarCrashField_Reason) == 0)
+        {
+            COPY_STRING(report->nsexceptionReason, value);
+            report->hasNSExceptionReason = true;
+        }
+    }
+    else
+    {
+        int thread = threadOffset(context, offset);
+        if(IS_AT_PATH(context, thread, RollbarCrashField_Backtrace, RollbarCrashField_Contents, NULL))
+        {
+            StackEntry* entry = &report->entry;
+            if(strcmp(name, RollbarCrashField_ObjectName) == 0)
+            {
+                COPY_STRING(entry->objectName, value);
+                entry->hasObjectName = true;
+            }
+            else if(strcmp(name, RollbarCrashField_SymbolName) == 0)
+            {
+                COPY_STRING(entry->symbolName, value);
+                entry->hasSymbolName = true;
+            }
+        }
+        else if(IS_AT_PATH(context, thread, RollbarCrashField_NotableAddresses, NULL))
+        {
+            RegisterInfo* notable = &report->notable;
+            if(strcmp(name, RollbarCrashField_Type) == 0)
+            {
+                COPY_STRING(notable->type, value);
+                notable->hasType = true;
+            }
+            else if(strcmp(name, RollbarCrashField_Class) == 0)
+            {
+                COPY_STRING(notable->className, value);
+                notable->hasClassName = true;
+            }
+            else if(strcmp(name, RollbarCrashField_LastDeallocObject) == 0)
+            {
+                COPY_STRING(notable->previousClassName, value);
+                notable->hasPreviousClassName = true;
+            }
+            else if(strcmp(name, RollbarCrashField_Value) == 0)
+            {
+                COPY_STRING(notable->value, value);
+                notable->hasValue = true;
+            }
+        }
+    }
+    return RollbarCrashJSON_OK;
+}
+
+static int beginContainer(DiagnosisContext* context, const char* name, bool isObject)
+{
+    int offset;
+    ReportInfo* report = currentReport(context, &offset);
+
+    if(isObject)
+    {
+        int thread = threadOffset(context, offset);
+        if((IS_AT_PATH(context, offset, RollbarCrashField_Crash) && isEqual(name, RollbarCrashField_CrashedThread)) ||
+           IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Threads))
+        {
+            memset(&report->thread, 0, sizeof(report->thread));
+        }
+        else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Error) &&
+                isEqual(name, RollbarCrashField_Mach))
+        {
+            report->hasMach = true;
+        }
+        else if(IS_AT_PATH(context, thread, RollbarCrashField_Backtrace, RollbarCrashField_Contents))
+        {
+            memset(&report->entry, 0, sizeof(report->entry));
+        }
+        else if(IS_AT_PATH(context, thread, RollbarCrashField_NotableAddresses))
+        {
+            memset(&report->notable, 0, sizeof(report->notable));
+            report->notableRegister = registerIndex(name);
+        }
+    }
+
+    if(context->depth < MAX_DEPTH)
+    {
+        COPY_STRING(context->names[context->depth], name != NULL ? name : "");
+    }
+    context->depth++;
+    return RollbarCrashJSON_OK;
+}
+
+static int onBeginObject(const char* const name, void* const userData)
+{
+    return beginContainer(userData, name, true);
+}
+
+static int onBeginArray(const char* const name, void* const userData)
+{
+    return beginContainer(userData, name, false);
+}
+
+static int onEndContainer(void* const userData)
+{
+    DiagnosisContext* context = userData;
+    if(context->depth <= 0)
+    {
+        return RollbarCrashJSON_ERROR_INVALID_DATA;
+    }
+    context->depth--;
+    if(context->depth >= MAX_DEPTH)
+    {
+        return RollbarCrashJSON_OK;
+    }
+
+    const char* endedName = context->names[context->depth];
+    int offset;
+    ReportInfo* report = currentReport(context, &offset);
+    int thread = threadOffset(context, offset);
+
+    if(IS_AT_PATH(context, offset, RollbarCrashField_Crash) && strcmp(endedName, RollbarCrashField_CrashedThread) == 0)
+    {
+        onThreadEnded(report, true);
+    }
+    else if(IS_AT_PATH(context, offset, RollbarCrashField_Crash, RollbarCrashField_Threads))
+    {
+        onThreadEnded(report, false);
+    }
+    else if(IS_AT_PATH(context, thread, RollbarCrashField_Backtrace, RollbarCrashField_Contents))
+    {
+        onStackEntryEnded(report);
+    }
+    else if(IS_AT_PATH(context, thread, RollbarCrashField_NotableAddresses))
+    {
+        onNotableAddressEnded(report);
+    }
+    return RollbarCrashJSON_OK;
+}
+
+static int onEndData(__unused void* const userData)
+{
+    return RollbarCrashJSON_OK;
+}
+
+
+// ============================================================================
+#pragma mark - Diagnosis -
+// ============================================================================
+
+static void describeParam(Diagnosis* diagnosis, const Param* param)
+{
+    if(param->value != NULL)
+    {
+        if(isEqual(param->type, RollbarCrashMemType_String))
+        {
+            append(diagnosis, "\"%s\"", param->value);
+        }
+        else
+        {
+            append(diagnosis, "%s", param->value);
+        }
+    }
+    else if(param->previousClassName != NULL)
+    {
+        append(diagnosis, "%s", param->previousClassName);
+    }
+    else if(param->className != NULL)
+    {
+        append(diagnosis, "%s (%s)", param->className, param->isInstance ? "instance" : "class");
+    }
+    else
+    {
+        append(diagnosis, "?");
+    }
+}
+
+static bool describeObjCCall(Diagnosis* diagnosis, const char* functionName, const Param* params, int paramCount)
+{
+    if(!isEqual(functionName, "objc_msgSend") || paramCount < 2)
+    {
+        return false;
+    }
+    const Param* receiverParam = &params[0];
+    const char* receiver = receiverParam->previousClassName;
+    if(receiver == NULL)
+    {
+        receiver = receiverParam->className;
+        if(receiver == NULL)
+        {
+            receiver = "id";
+        }
+    }
+
+    const Param* selectorParam = &params[1];
+    if(!isEqual(selectorParam->type, RollbarCrashMemType_String))
+    {
+        return false;
+    }
+    const char* selector = selectorParam->value;
+    int selectorParamCount = 0;
+    if(selector != NULL)
+    {
+        for(const char* ch = selector; *ch != '\0'; ch++)
+        {
+            if(*ch == ':')
+            {
+                selectorParamCount++;
+            }
+        }
+    }
+
+    if(selector == NULL)
+    {
+        append(diagnosis, "-[%s (null)", receiver);
+    }
+    else
+    {
+        append(diagnosis, "-[%s %.*s", receiver, (int)strcspn(selector, ":"), selector);
+    }
+    for(int paramNum = 0; paramNum < selectorParamCount; paramNum++)
+    {
+        append(diagnosis, ":");
+        if(paramNum < 2 && paramNum + 2 < paramCount)
+        {
+            describeParam(diagnosis, &params[paramNum + 2]);
+        }
+        else
+        {
+            append(diagnosis, "?");
+        }
+        if(paramNum < selectorParamCount - 1)
+        {
+            append(diagnosis, " ");
+        }
+    }
+    append(diagnosis, "]");
+    return true;
+}
+
+static void describeCall(Diagnosis* diagnosis, const char* functionName, const Param* params, int paramCount, int maxParams)
+{
+    if(describeObjCCall(diagnosis, functionName, params, paramCount))
+    {
+        return;
+    }
+
+    if(maxParams > paramCount)
+    {
+        maxParams = paramCount;
+    }
+    append(diagnosis, "Function: %s\n", orNull(functionName));
+    for(int i = 0; i < maxParams; i++)
+    {
+        const Param* param = &params[i];
+        append(diagnosis, "Param %d:  ", i + 1);
+        if(param->className != NULL)
+        {
+            append(diagnosis, "%s (%s) ", param->className, param->isInstance ? "instance" : "class");
+        }
+        if(param->value != NULL)
+        {
+            append(diagnosis, "%s ", param->value);
+        }
+        if(param->previousClassName != NULL)
+        {
+            append(diagnosis, "(was %s)", param->previousClassName);
+        }
+        if(i < maxParams - 1)
+        {
+            append(diagnosis, "\n");
+        }
+    }
+}
+
+/** Fill in the parameters of the last function called on the crashed thread.
+ *
+ * @return The number of parameters (0 if the CPU family is unknown).
+ */
+static int getLastCallParams(const ThreadInfo* thread, CPUFamily family, Param* params)
+{
+    if(family == CPUFamilyUnknown)
+    {
+        return 0;
+    }
+    const RegisterInfo* registers = &thread->registers[(family - CPUFamilyArm) * PARAM_COUNT];
+    for(int i = 0; i < PARAM_COUNT; i++)
+    {
+        const RegisterInfo* reg = &registers[i];
+        Param* param = &params[i];
+        memset(param, 0, sizeof(*param));
+        if(!reg->isNotable)
+        {
+            snprintf(param->addressString, sizeof(param->addressString), "0x%" PRIxPTR, reg->address);
+            param->value = param->addressString;
+            continue;
+        }
+
+        param->type = reg->hasType ? reg->type : NULL;
+        const char* className = reg->hasClassName ? reg->className : NULL;
+        if(isEqual(param->type, RollbarCrashMemType_String))
+        {
+            param->value = reg->hasValue ? reg->value : NULL;
+        }
+        else if(isEqual(param->type, RollbarCrashMemType_Object))
+        {
+            param->className = className;
+            param->isInstance = true;
+        }
+        else if(isEqual(param->type, RollbarCrashMemType_Class))
+        {
+            param->className = className;
+            param->isInstance = false;
+        }
+        param->previousClassName = reg->hasPreviousClassName ? reg->previousClassName : NULL;
+    }
+    return PARAM_COUNT;
+}
+
+static void appendOriginatingCall(Diagnosis* diagnosis, const char* callName)
+{
+    if(callName != NULL && strcmp(callName, "main") != 0)
+    {
+        append(diagnosis, "\nOriginated at or in a subcall of %s", callName);
+    }
+}
+
+/** Get the first stack entry of a thread that is in the process' own binary. */
+static const StackEntry* findInAppEntry(const ReportInfo* report, const ThreadInfo* thread)
+{
+    if(thread->hasInAppEntry)
+    {
+        return &thread->inAppEntry;
+    }
+    if(!report->hasProcessName)
+    {
+        return NULL;
+    }
+    for(int i = 0; i < thread->objectEntryCount; i++)
+    {
+        if(strcmp(thread->objectEntries[i].objectName, report->processName) == 0)
+        {
+            return &thread->objectEntries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool isInvalidAddress(const ReportInfo* report)
+{
+    if(report->hasMach)
+    {
+        return strcmp(report->machExceptionName, "EXC_BAD_ACCESS") == 0;
+    }
+    return strcmp(report->signalName, "SIGSEGV") == 0;
+}
+
+static bool isMathError(const ReportInfo* report)
+{
+    if(report->hasMach)
+    {
+        return strcmp(report->machExceptionName, "EXC_ARITHMETIC") == 0;
+    }
+    return strcmp(report->signalName, "SIGFPE") == 0;
+}
+
+/** Apply the diagnosis rules to a report's collected fields.
+ *
+ * @param report The report.
+ * @param defaultCPUArch CPU architecture to use if the report has none.
+ *
+ * @return The diagnosis, or NULL if there is none.
+ */
+static char* diagnose(const ReportInfo* report, const char* defaultCPUArch)
+{
+    Diagnosis diagnosis = {.length = 0};
+    const ThreadInfo* crashedThread = report->hasCrashedThread ? &report->crashedThread : NULL;
+    const StackEntry* inAppEntry = crashedThread != NULL ? findInAppEntry(report, crashedThread) : NULL;
+    const char* lastFunctionName = inAppEntry != NULL && inAppEntry->hasSymbolName ? inAppEntry->symbolName : NULL;
+
+    if(strcmp(report->errorType, RollbarCrashExcType_Deadlock) == 0)
+    {
+        append(&diagnosis, "Main thread deadlocked in %s", orNull(lastFunctionName));
+        return strdup(diagnosis.buffer);
+    }
+
+    if(crashedThread != NULL && crashedThread->isStackOverflow)
+    {
+        append(&diagnosis, "Stack overflow in %s", orNull(lastFunctionName));
+        return strdup(diagnosis.buffer);
+    }
+
+    if(strcmp(report->errorType, RollbarCrashExcType_NSException) == 0)
+    {
+        const char* name = report->hasNSExceptionName ? report->nsexceptionName : NULL;
+        const char* reason = report->hasNSExceptionReason ? report->nsexceptionReason
+                           : report->hasErrorReason ? report->errorReason : NULL;
+        append(&diagnosis, "Application threw exception %s: %s", orNull(name), orNull(reason));
+        appendOriginatingCall(&diagnosis, lastFunctionName);
+        return strdup(diagnosis.buffer);
+    }
+
+    if(crashedThread != NULL && crashedThread->isMemoryCorrupted)
+    {
+        return strdup("Rogue memory write has corrupted memory.");
+    }
+
+    if(isMathError(report))
+    {
+        append(&diagnosis, "Math error (usually caused from division by 0).");
+        appendOriginatingCall(&diagnosis, lastFunctionName);
+        return strdup(diagnosis.buffer);
+    }
+
+    if(crashedThread != NULL && crashedThread->entryCount > 0 && crashedThread->firstEntry.hasSymbolName)
+    {
+        const char* functionName = crashedThread->firstEntry.symbolName;
+        const char* cpuArch = report->cpuArch[0] != '\0' ? report->cpuArch : defaultCPUArch;
+        Param params[PARAM_COUNT];
+        int paramCount = getLastCallParams(crashedThread, cpuFamily(cpuArch), params);
+        if(paramCount > 0 && params[0].previousClassName != NULL)
+        {
+            int maxParams = 0;
+            if(strcmp(functionName, "objc_msgSend") == 0)
+            {
+                maxParams = 4;
+            }
+            else if(strcmp(functionName, "objc_retain") == 0)
+            {
+                maxParams = 1;
+            }
+            if(maxParams > 0)
+            {
+                append(&diagnosis, "Possible zombie in call: ");
+                describeCall(&diagnosis, functionName, params, paramCount, maxParams);
+                appendOriginatingCall(&diagnosis, lastFunctionName);
+                return strdup(diagnosis.buffer);
+            }
+        }
+    }
+
+    if(isInvalidAddress(report))
+    {
+        if(report->errorAddress == 0)
+        {
+            append(&diagnosis, "Attempted to dereference null pointer.");
+        }
+        else
+        {
+            append(&diagnosis, "Attempted to dereference garbage pointer 0x%" PRIxPTR ".", report->errorAddress);
+        }
+        appendOriginatingCall(&diagnosis, lastFunctionName);
+        return strdup(diagnosis.buffer);
+    }
+
+    return NULL;
+}
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+bool rcdiag_diagnoseReport(const char* const report,
+                           const int reportLength,
+                           char** const diagnosis,
+                           char** const recrashDiagnosis)
+{
+    *diagnosis = NULL;
+    if(recrashDiagnosis != NULL)
+    {
+        *recrashDiagnosis = NULL;
+    }
+
+    RollbarCrashJSONDecodeCallbacks callbacks =
+    {
+        .onBeginArray = onBeginArray,
+        .onBeginObject = onBeginObject,
+        .onBooleanElement = onBooleanElement,
+        .onEndContainer = onEndContainer,
+        .onEndData = onEndData,
+        .onFloatingPointElement = onFloatingPointElement,
+        .onIntegerElement = onIntegerElement,
+        .onNullElement = onNullElement,
+        .onStringElement = onStringElement,
+    };
+    int stringBufferLength = RCMAX_STRINGBUFFERSIZE;
+    char* stringBuffer = malloc((unsigned)stringBufferLength);
+    DiagnosisContext* context = calloc(1, sizeof(*context));
+    if(stringBuffer == NULL || context == NULL)
+    {
+        free(stringBuffer);
+        free(context);
+        return false;
+    }
+
+    int errorOffset = 0;
+    int result = rcjson_decode(report, reportLength, stringBuffer, stringBufferLength, &callbacks, context, &errorOffset);
+    free(stringBuffer);
+    if(result != RollbarCrashJSON_OK)
+    {
+        // Diagnose whatever was decoded, the same way a partial report is kept.
+        RCLOG_ERROR("Could not decode report at offset %d: %s", errorOffset, rcjson_stringForError(result));
+    }
+
+    *diagnosis = diagnose(&context->report, "");
+    if(recrashDiagnosis != NULL)
+    {
+        *recrashDiagnosis = diagnose(&context->recrashReport, context->report.cpuArch);
+    }
+    free(context);
+    return result == RollbarCrashJSON_OK;
+}
@@ -0,0 +1,65 @@
+//
+//  RollbarCrashDiagnosis.h
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Works out a human readable cause for a crash from a JSON crash report.
+ *
+ * The report is streamed through the JSON decoder once, keeping only the
+ * fields that the diagnosis rules look at, so no object tree is built.
+ */
+
+#ifndef HDR_RollbarCrashDiagnosis_h
+#define HDR_RollbarCrashDiagnosis_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+
+/** Diagnose a crash report, and the recrash report embedded in it (if any).
+ *
+ * @param report The JSON encoded crash report.
+ *
+ * @param reportLength The length of the report in bytes.
+ *
+ * @param diagnosis Receives the report's diagnosis, or NULL if there is none.
+ *                  MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ *
+ * @param recrashDiagnosis Receives the recrash report's diagnosis, or NULL if
+ *                         there is none (NULL = ignore).
+ *                         MEMORY MANAGEMENT WARNING: User is responsible for calling free() on the returned value.
+ *
+ * @return true if the whole report could be decoded. A partially decoded
+ *         report is still diagnosed from the fields that were read.
+ */
+bool rcdiag_diagnoseReport(const char* report,
+                           int reportLength,
+                           char** diagnosis,
+                           char** recrashDiagnosis);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_RollbarCrashDiagnosis_h
@@ -14,4 +14,12 @@
 
 - (NSString*) diagnoseCrash:(NSDictionary*) crashReport;
 
+/** Diagnose a JSON encoded crash report without decoding it into objects.
+ *
+ * @param reportJSON The crash report as JSON.
+ *
+ * @return The diagnosis, or nil if there is none.
+ */
+- (NSString*) diagnoseCrashJSON:(NSData*) reportJSON;
+
 @end
@@ -28,7 +28,7 @@
 #import "RollbarCrashHandler.h"
 
 #import "RollbarCrashC.h"
-#import "RollbarCrashDoctor.h"
+#import "RollbarCrashDiagnosis.h"
 #import "RollbarCrashReportFields.h"
 #import "RollbarCrashMonitor_AppState.h"
 #import "RollbarCrashJSONCodecObjC.h"
@@ -55,6 +55,17 @@
 @property(nonatomic,readwrite,retain) NSString* bundleName;
 @property(nonatomic,readwrite,retain) NSString* basePath;
 
+- (NSDictionary*) reportWithIntID:(int64_t) reportID;
+
+@end
+
+
+@interface RollbarCrashReportEnumerator ()
+
+@property(nonatomic,readwrite,retain) NSArray* lastPageReportIDs;
+
+- (id) initWithHandler:(RollbarCrashHandler*) handler pageSize:(NSUInteger) pageSize;
+
 @end
 
 
@@ -100,6 +111,7 @@ static NSString* getBasePath(void)
 @synthesize deleteBehaviorAfterSendAll = _deleteBehaviorAfterSendAll;
 @synthesize monitoring = _monitoring;
 @synthesize deadlockWatchdogInterval = _deadlockWatchdogInterval;
+@synthesize hangProfilingThreshold = _hangProfilingThreshold;
 @synthesize searchQueueNames = _searchQueueNames;
 @synthesize onCrash = _onCrash;
 @synthesize bundleName = _bundleName;
@@ -109,6 +121,10 @@ static NSString* getBasePath(void)
 @synthesize addConsoleLogToReport = _addConsoleLogToReport;
 @synthesize printPreviousLog = _printPreviousLog;
 @synthesize maxReportCount = _maxReportCount;
+@synthesize deferUserReports = _deferUserReports;
+@synthesize cppExceptionStackCaptureInterval = _cppExceptionStackCaptureInterval;
+@synthesize reportPageSize = _reportPageSize;
+@synthesize zombieCacheSize = _zombieCacheSize;
 @synthesize uncaughtExceptionHandler = _uncaughtExceptionHandler;
 @synthesize currentSnapshotUserReportedExceptionHandler = _currentSnapshotUserReportedExceptionHandler;
 
@@ -157,8 +173,12 @@ static NSString* getBasePath(void)
         }
         self.deleteBehaviorAfterSendAll = RollbarCrashDeleteAlways;
         self.introspectMemory = YES;
+        self.zombieCacheSize = 0x6000;
         self.catchZombies = NO;
         self.maxReportCount = 5;
+        self.deferUserReports = NO;
+        self.cppExceptionStackCaptureInterval = 1;
+        self.reportPageSize = 10;
         self.searchQueueNames = NO;
         self.monitoring = RollbarCrashMonitorTypeProductionSafeMinimal;
     }
@@ -209,6 +229,12 @@ static NSString* getBasePath(void)
     rc_setDeadlockWatchdogInterval(deadlockWatchdogInterval);
 }
 
+- (void) setHangProfilingThreshold:(double) hangProfilingThreshold
+{
+    _hangProfilingThreshold = hangProfilingThreshold;
+    rc_setHangProfilingThreshold(hangProfilingThreshold);
+}
+
 - (void) setSearchQueueNames:(BOOL) searchQueueNames
 {
     _searchQueueNames = searchQueueNames;
@@ -244,6 +270,12 @@ static NSString* getBasePath(void)
     }
 }
 
+- (void) setZombieCacheSize:(int)zombieCacheSize
+{
+    _zombieCacheSize = zombieCacheSize;
+    rc_setZombieCacheSize(zombieCacheSize);
+}
+
 - (void) setDoNotIntrospectClasses:(NSArray *)doNotIntrospectClasses
 {
     _doNotIntrospectClasses = doNotIntrospectClasses;
@@ -270,6 +302,18 @@ static NSString* getBasePath(void)
     rc_setMaxReportCount(maxReportCount);
 }
 
+- (void) setDeferUserReports:(BOOL) deferUserReports
+{
+    _deferUserReports = deferUserReports;
+    rc_setDeferUserReports(deferUserReports);
+}
+
+- (void) setCppExceptionStackCaptureInterval:(int) cppExceptionStackCaptureInterval
+{
+    _cppExceptionStackCaptureInterval = cppExceptionStackCaptureInterval;
+    rc_setCPPExceptionStackCaptureInterval(cppExceptionStackCaptureInterval);
+}
+
 - (NSDictionary*) systemInfo
 {
     RollbarCrash_MonitorContext fakeEvent = {0};
@@ -327,25 +371,97 @@ static NSString* getBasePath(void)
 
 - (void) sendAllReportsWithCompletion:(RollbarCrashReportFilterCompletion) onCompletion
 {
-    NSArray* reports = [self allReports];
-    
-    RCLOG_INFO(@"Sending %d crash reports", [reports count]);
-    
-    [self sendReports:reports
-         onCompletion:^(NSArray* filteredReports, BOOL completed, NSError* error)
-     {
-         RCLOG_DEBUG(@"Process finished with completion: %d", completed);
-         if(error != nil)
-         {
-             RCLOG_ERROR(@"Failed to send reports: %@", error);
-         }
-         if((self.deleteBehaviorAfterSendAll == RollbarCrashDeleteOnSucess && completed) ||
-            self.deleteBehaviorAfterSendAll == RollbarCrashDeleteAlways)
-         {
-             rc_deleteAllReports();
-         }
-         rc_callCompletion(onCompletion, filteredReports, completed, error);
-     }];
+    RollbarCrashReportEnumerator* enumerator = [self reportEnumeratorWithPageSize:(NSUInteger)MAX(self.reportPageSize, 1)];
+    RollbarCrashDeleteBehavior deleteBehavior = self.deleteBehaviorAfterSendAll;
+
+    RCLOG_INFO(@"Sending %d crash reports", rc_getReportCount());
+
+    __block NSArray* lastFilteredReports = @[];
+    __block dispatch_block_t sendNextPage;
+    void (^finish)(NSArray*, BOOL, NSError*) = ^(NSArray* filteredReports, BOOL completed, NSError* error)
+    {
+        RCLOG_DEBUG(@"Process finished with completion: %d", completed);
+        if(error != nil)
+        {
+            RCLOG_ERROR(@"Failed to send reports: %@", error);
+        }
+        if(deleteBehavior == RollbarCrashDeleteAlways)
+        {
+            rc_deleteAllReports();
+        }
+        rc_callCompletion(onCompletion, filteredReports, completed, error);
+        // Release self-reference on the main thread.
+        dispatch_async(dispatch_get_main_queue(), ^
+                       {
+                           sendNextPage = nil;
+                       });
+    };
+
+    // Sinks may complete synchronously or asynchronously. Pages that complete
+    // synchronously are sent from this loop rather than recursively, so a
+    // large backlog doesn't grow the stack.
+    sendNextPage = [^
+                    {
+                        for(;;)
+                        {
+                            NSArray* reports = [enumerator nextPage];
+                            if(reports == nil)
+                            {
+                                finish(lastFilteredReports, YES, nil);
+                                return;
+                            }
+
+                            NSArray* pageReportIDs = enumerator.lastPageReportIDs;
+                            __block BOOL sendReturned = NO;
+                            __block BOOL completedSynchronously = NO;
+                            [self sendReports:reports
+                                 onCompletion:^(NSArray* filteredReports, BOOL completed, NSError* error)
+                             {
+                                 if((deleteBehavior == RollbarCrashDeleteOnSucess && completed) ||
+                                    deleteBehavior == RollbarCrashDeleteAlways)
+                                 {
+                                     for(NSNumber* reportID in pageReportIDs)
+                                     {
+                                         rc_deleteReportWithID([reportID longLongValue]);
+                                     }
+                                 }
+                                 if(!completed)
+                                 {
+                                     finish(filteredReports, completed, error);
+                                     return;
+                                 }
+                                 lastFilteredReports = filteredReports;
+
+                                 BOOL continueHere;
+                                 @synchronized(enumerator)
+                                 {
+                                     continueHere = sendReturned;
+                                     completedSynchronously = !sendReturned;
+                                 }
+                                 if(continueHere)
+                                 {
+                                     sendNextPage();
+                                 }
+                             }];
+
+                            BOOL continueLoop;
+                            @synchronized(enumerator)
+                            {
+                                sendReturned = YES;
+                                continueLoop = completedSynchronously;
+                            }
+                            if(!continueLoop)
+                            {
+                                return;
+                            }
+                        }
+                    } copy];
+    sendNextPage();
+}
+
+- (RollbarCrashReportEnumerator*) reportEnumeratorWithPageSize:(NSUInteger) pageSize
+{
+    return [[RollbarCrashReportEnumerator alloc] initWithHandler:self pageSize:pageSize];
 }
 
 - (void) deleteAllReports
@@ -458,16 +574,18 @@ SYNTHESIZE_CRASH_STATE_PROPERTY(BOOL, crashedLastLaunch)
 }
 
 - (void) finalizeReport:(NSMutableDictionary*) report
+               diagnosis:(NSString*) diagnosis
+        recrashDiagnosis:(NSString*) recrashDiagnosis
 {
     NSMutableDictionary* crashReport;
 
     if ((crashReport = report[@RollbarCrashField_Crash]) != NULL) {
         [self cleanupReport:crashReport];
-        crashReport[@RollbarCrashField_Diagnosis] = [[RollbarCrashDoctor doctor] diagnoseCrash:report];
+        crashReport[@RollbarCrashField_Diagnosis] = diagnosis;
     }
 
     if ((crashReport = report[@RollbarCrashField_RecrashReport][@RollbarCrashField_Crash]) != NULL) {
-        crashReport[@RollbarCrashField_Diagnosis] = [[RollbarCrashDoctor doctor] diagnoseCrash:report];
+        crashReport[@RollbarCrashField_Diagnosis] = recrashDiagnosis;
     }
 }
 
@@ -523,13 +641,17 @@ SYNTHESIZE_CRASH_STATE_PROPERTY(BOOL, crashedLastLaunch)
 
 - (NSArray*)reportIDs
 {
-    int reportCount = rc_getReportCount();
-    int64_t reportIDsC[reportCount];
-    reportCount = rc_getReportIDs(reportIDsC, reportCount);
-    NSMutableArray* reportIDs = [NSMutableArray arrayWithCapacity:(NSUInteger)reportCount];
-    for(int i = 0; i < reportCount; i++)
+    NSMutableArray* reportIDs = [NSMutableArray array];
+    int64_t reportIDsC[64];
+    int64_t lastReportID = 0;
+    int reportCount;
+    while((reportCount = rc_getReportIDsAfter(lastReportID, reportIDsC, 64)) > 0)
     {
-        [reportIDs addObject:[NSNumber numberWithLongLong:reportIDsC[i]]];
+        for(int i = 0; i < reportCount; i++)
+        {
+            [reportIDs addObject:[NSNumber numberWithLongLong:reportIDsC[i]]];
+        }
+        lastReportID = reportIDsC[reportCount - 1];
     }
     return reportIDs;
 }
@@ -547,6 +669,16 @@ SYNTHESIZE_CRASH_STATE_PROPERTY(BOOL, crashedLastLaunch)
         return nil;
     }
 
+    // Diagnose straight from the JSON bytes so the rules don't have to walk
+    // the decoded object tree.
+    char* diagnosisC = NULL;
+    char* recrashDiagnosisC = NULL;
+    rcdiag_diagnoseReport(jsonData.bytes, (int)jsonData.length, &diagnosisC, &recrashDiagnosisC);
+    NSString* diagnosis = diagnosisC != NULL ? [NSString stringWithUTF8String:diagnosisC] : nil;
+    NSString* recrashDiagnosis = recrashDiagnosisC != NULL ? [NSString stringWithUTF8String:recrashDiagnosisC] : nil;
+    free(diagnosisC);
+    free(recrashDiagnosisC);
+
     NSError* error = nil;
     NSMutableDictionary* crashReport = [RollbarCrashJSONCodec decode:jsonData
                                                    options:RollbarCrashJSONDecodeOptionIgnoreNullInArray |
@@ -562,26 +694,18 @@ SYNTHESIZE_CRASH_STATE_PROPERTY(BOOL, crashedLastLaunch)
         RCLOG_ERROR(@"Could not load crash report");
         return nil;
     }
-    [self finalizeReport:crashReport];
+    [self finalizeReport:crashReport diagnosis:diagnosis recrashDiagnosis:recrashDiagnosis];
 
     return crashReport;
 }
 
 - (NSArray*) allReports
 {
-    int reportCount = rc_getReportCount();
-    int64_t reportIDs[reportCount];
-    reportCount = rc_getReportIDs(reportIDs, reportCount);
-    NSMutableArray* reports = [NSMutableArray arrayWithCapacity:(NSUInteger)reportCount];
-    for(int i = 0; i < reportCount; i++)
+    NSMutableArray* reports = [NSMutableArray array];
+    for(NSDictionary* report in [self reportEnumeratorWithPageSize:16])
     {
-        NSDictionary* report = [self reportWithIntID:reportIDs[i]];
-        if(report != nil)
-        {
-            [reports addObject:report];
-        }
+        [reports addObject:report];
     }
-    
     return reports;
 }
 
@@ -697,6 +821,84 @@ SYNTHESIZE_CRASH_STATE_PROPERTY(BOOL, crashedLastLaunch)
 @end
 
 
+@implementation RollbarCrashReportEnumerator
+{
+    RollbarCrashHandler* _handler;
+    int64_t* _reportIDs;
+    int64_t _lastReportID;
+    NSArray* _pageReports;
+    NSUInteger _pageIndex;
+}
+
+@synthesize pageSize = _pageSize;
+@synthesize lastPageReportIDs = _lastPageReportIDs;
+
+- (id) initWithHandler:(RollbarCrashHandler*) handler pageSize:(NSUInteger) pageSize
+{
+    if((self = [super init]))
+    {
+        _handler = handler;
+        _pageSize = MIN(MAX(pageSize, (NSUInteger)1), (NSUInteger)INT_MAX);
+        _reportIDs = calloc(_pageSize, sizeof(*_reportIDs));
+        if(_reportIDs == NULL)
+        {
+            return nil;
+        }
+        _lastPageReportIDs = @[];
+    }
+    return self;
+}
+
+- (void) dealloc
+{
+    free(_reportIDs);
+}
+
+- (NSArray*) nextPage
+{
+    int count = rc_getReportIDsAfter(_lastReportID, _reportIDs, (int)_pageSize);
+    if(count <= 0)
+    {
+        self.lastPageReportIDs = @[];
+        return nil;
+    }
+    _lastReportID = _reportIDs[count - 1];
+
+    NSMutableArray* reportIDs = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+    NSMutableArray* reports = [NSMutableArray arrayWithCapacity:(NSUInteger)count];
+    for(int i = 0; i < count; i++)
+    {
+        [reportIDs addObject:[NSNumber numberWithLongLong:_reportIDs[i]]];
+        @autoreleasepool
+        {
+            NSDictionary* report = [_handler reportWithIntID:_reportIDs[i]];
+            if(report != nil)
+            {
+                [reports addObject:report];
+            }
+        }
+    }
+    self.lastPageReportIDs = reportIDs;
+    return reports;
+}
+
+- (id) nextObject
+{
+    while(_pageIndex >= [_pageReports count])
+    {
+        _pageReports = [self nextPage];
+        _pageIndex = 0;
+        if(_pageReports == nil)
+        {
+            return nil;
+        }
+    }
+    return _pageReports[_pageIndex++];
+}
+
+@end
+
+
 //! Project version number for RollbarCrashFramework.
 const double RollbarCrashFrameworkVersionNumber = 1.1527;
 
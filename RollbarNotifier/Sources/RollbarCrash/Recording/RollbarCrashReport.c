@@ -26,6 +26,7 @@
 
 
 #include "RollbarCrashReport.h"
+#include "RollbarCrashArena.h"
 
 #include "RollbarCrashReportFields.h"
 #include "RollbarCrashReportWriter.h"
@@ -77,6 +78,12 @@
 /** The minimum length for a valid string. */
 #define kMinStringLength 4
 
+/** How much of the report is buffered between writes to its file. */
+#define kReportWriteBufferSize (16 * 1024)
+
+/** The buffer to use when the crash arena has no room for a bigger one. */
+#define kFallbackWriteBufferSize 1024
+
 
 // ============================================================================
 #pragma mark - JSON Encoding -
@@ -960,9 +967,11 @@ static void writeStackContents(const RollbarCrashReportWriter* const writer,
         writer->addUIntegerElement(writer, RollbarCrashField_DumpEnd, highAddress);
         writer->addUIntegerElement(writer, RollbarCrashField_StackPtr, sp);
         writer->addBooleanElement(writer, RollbarCrashField_Overflow, isStackOverflow);
-        uint8_t stackBuffer[kStackContentsTotalDistance * sizeof(sp)];
+        // off the stack, which may be the one that overflowed:
+        rcarena_begin();
         int copyLength = (int)(highAddress - lowAddress);
-        if(rcmem_copySafely((void*)lowAddress, stackBuffer, copyLength))
+        uint8_t* stackBuffer = rcarena_alloc(kStackContentsTotalDistance * sizeof(sp));
+        if(stackBuffer != NULL && rcmem_copySafely((void*)lowAddress, stackBuffer, copyLength))
         {
             writer->addDataElement(writer, RollbarCrashField_Contents, (void*)stackBuffer, copyLength);
         }
@@ -970,6 +979,7 @@ static void writeStackContents(const RollbarCrashReportWriter* const writer,
         {
             writer->addStringElement(writer, RollbarCrashField_Error, "Stack contents not accessible");
         }
+        rcarena_end();
     }
     writer->endContainer(writer);
 }
@@ -1003,14 +1013,29 @@ static void writeNotableStackContents(const RollbarCrashReportWriter* const writ
         lowAddress = highAddress;
         highAddress = tmp;
     }
-    uintptr_t contentsAsPointer;
+
+    // Fetch every candidate pointer up front, in as few reads as possible.
+    uintptr_t contents[kStackNotableSearchBackDistance + kStackNotableSearchForwardDistance];
+    RollbarCrashMemoryCopy copies[kStackNotableSearchBackDistance + kStackNotableSearchForwardDistance];
+    int copyCount = 0;
+    for(uintptr_t address = lowAddress;
+        address < highAddress && copyCount < (int)(sizeof(copies) / sizeof(*copies));
+        address += sizeof(address))
+    {
+        copies[copyCount].src = (const void*)address;
+        copies[copyCount].dst = &contents[copyCount];
+        copies[copyCount].byteCount = sizeof(*contents);
+        copyCount++;
+    }
+    rcmem_copySafelyBatch(copies, copyCount);
+
     char nameBuffer[40];
-    for(uintptr_t address = lowAddress; address < highAddress; address += sizeof(address))
+    for(int i = 0; i < copyCount; i++)
     {
-        if(rcmem_copySafely((void*)address, &contentsAsPointer, sizeof(contentsAsPointer)))
+        if(copies[i].wasCopied)
         {
-            sprintf(nameBuffer, "stack@%p", (void*)address);
-            writeMemoryContentsIfNotable(writer, nameBuffer, contentsAsPointer);
+            sprintf(nameBuffer, "stack@%p", copies[i].src);
+            writeMemoryContentsIfNotable(writer, nameBuffer, contents[i]);
         }
     }
 }
@@ -1596,7 +1621,15 @@ static void prepareReportWriter(RollbarCrashReportWriter* const writer, RollbarC
 
 void rcreport_writeRecrashReport(const RollbarCrash_MonitorContext* const monitorContext, const char* const path)
 {
-    char writeBuffer[1024];
+    rcarena_begin();
+    char fallbackBuffer[kFallbackWriteBufferSize];
+    int writeBufferSize = kReportWriteBufferSize;
+    char* writeBuffer = rcarena_alloc((size_t)writeBufferSize);
+    if(writeBuffer == NULL)
+    {
+        writeBuffer = fallbackBuffer;
+        writeBufferSize = sizeof(fallbackBuffer);
+    }
     RollbarCrashBufferedWriter bufferedWriter;
     static char tempPath[RollbarCrashFU_MAX_PATH_LENGTH];
     strncpy(tempPath, path, sizeof(tempPath) - 10);
@@ -1607,8 +1640,9 @@ void rcreport_writeRecrashReport(const RollbarCrash_MonitorContext* const monito
     {
         RCLOG_ERROR("Could not rename %s to %s: %s", path, tempPath, strerror(errno));
     }
-    if(!rcfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer)))
+    if(!rcfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, writeBufferSize))
     {
+        rcarena_end();
         return;
     }
 
@@ -1658,6 +1692,7 @@ void rcreport_writeRecrashReport(const RollbarCrash_MonitorContext* const monito
     rcjson_endEncode(getJsonContext(writer));
     rcfu_closeBufferedWriter(&bufferedWriter);
     rcccd_unfreeze();
+    rcarena_end();
 }
 
 static void writeSystemInfo(const RollbarCrashReportWriter* const writer,
@@ -1720,11 +1755,20 @@ static void writeDebugInfo(const RollbarCrashReportWriter* const writer,
 void rcreport_writeStandardReport(const RollbarCrash_MonitorContext* const monitorContext, const char* const path)
 {
     RCLOG_INFO("Writing crash report to %s", path);
-    char writeBuffer[1024];
+    rcarena_begin();
+    char fallbackBuffer[kFallbackWriteBufferSize];
+    int writeBufferSize = kReportWriteBufferSize;
+    char* writeBuffer = rcarena_alloc((size_t)writeBufferSize);
+    if(writeBuffer == NULL)
+    {
+        writeBuffer = fallbackBuffer;
+        writeBufferSize = sizeof(fallbackBuffer);
+    }
     RollbarCrashBufferedWriter bufferedWriter;
 
-    if(!rcfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, sizeof(writeBuffer)))
+    if(!rcfu_openBufferedWriter(&bufferedWriter, path, writeBuffer, writeBufferSize))
     {
+        rcarena_end();
         return;
     }
 
@@ -1794,6 +1838,7 @@ void rcreport_writeStandardReport(const RollbarCrash_MonitorContext* const monit
     rcjson_endEncode(getJsonContext(writer));
     rcfu_closeBufferedWriter(&bufferedWriter);
     rcccd_unfreeze();
+    rcarena_end();
 }
 
 
@@ -128,7 +128,44 @@ static int getReportIDs(int64_t* reportIDs, int count)
         }
     }
 
-    qsort(reportIDs, (unsigned)count, sizeof(reportIDs[0]), compareInt64);
+    qsort(reportIDs, (unsigned)index, sizeof(reportIDs[0]), compareInt64);
+
+done:
+    if(dir != NULL)
+    {
+        closedir(dir);
+    }
+    return index;
+}
+
+static int getReportIDsAfter(int64_t afterID, int64_t* reportIDs, int count)
+{
+    int index = 0;
+    DIR* dir = opendir(g_reportsPath);
+    if(dir == NULL)
+    {
+        RCLOG_ERROR("Could not open directory %s", g_reportsPath);
+        goto done;
+    }
+
+    // Keep the lowest "count" IDs above afterID, sorted, so that memory use
+    // is bounded by the page size rather than by the number of reports.
+    struct dirent* ent;
+    while((ent = readdir(dir)) != NULL)
+    {
+        int64_t reportID = getReportIDFromFilename(ent->d_name);
+        if(reportID <= afterID || (index == count && reportID >= reportIDs[count - 1]))
+        {
+            continue;
+        }
+        int insertAt = index < count ? index++ : count - 1;
+        while(insertAt > 0 && reportIDs[insertAt - 1] > reportID)
+        {
+            reportIDs[insertAt] = reportIDs[insertAt - 1];
+            insertAt--;
+        }
+        reportIDs[insertAt] = reportID;
+    }
 
 done:
     if(dir != NULL)
@@ -210,6 +247,18 @@ int rccrs_getReportIDs(int64_t* reportIDs, int count)
     return count;
 }
 
+int rccrs_getReportIDsAfter(int64_t afterID, int64_t* reportIDs, int count)
+{
+    if(count <= 0)
+    {
+        return 0;
+    }
+    pthread_mutex_lock(&g_mutex);
+    count = getReportIDsAfter(afterID, reportIDs, count);
+    pthread_mutex_unlock(&g_mutex);
+    return count;
+}
+
 char* rccrs_readReport(int64_t reportID)
 {
     pthread_mutex_lock(&g_mutex);
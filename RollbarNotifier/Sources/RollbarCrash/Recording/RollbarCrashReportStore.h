@@ -65,6 +65,17 @@ int rccrs_getReportCount(void);
  */
 int rccrs_getReportIDs(int64_t* reportIDs, int count);
 
+/** Get a page of report IDs, in ascending order, that come after a given ID.
+ * Pass the last ID of the previous page to fetch the next page.
+ *
+ * @param afterID Only IDs greater than this are returned (0 = from the start).
+ * @param reportIDs An array to hold the report IDs.
+ * @param count How many reports the array can hold.
+ *
+ * @return The number of report IDs that were placed in the array.
+ */
+int rccrs_getReportIDsAfter(int64_t afterID, int64_t* reportIDs, int count);
+
 /** Read a report.
  *
  * @param reportID The report's ID.
@@ -35,6 +35,10 @@
 #define RollbarCrashCRASH_HOST_ANDROID 1
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#define RollbarCrashCRASH_HOST_LINUX 1
+#endif
+
 #define RollbarCrashCRASH_HOST_IOS (RollbarCrashCRASH_HOST_APPLE && TARGET_OS_IOS)
 #define RollbarCrashCRASH_HOST_TV (RollbarCrashCRASH_HOST_APPLE && TARGET_OS_TV)
 #define RollbarCrashCRASH_HOST_WATCH (RollbarCrashCRASH_HOST_APPLE && TARGET_OS_WATCH)
@@ -151,4 +155,16 @@
 #define RollbarCrashCRASH_HAS_REACHABILITY 0
 #endif
 
+#if RollbarCrashCRASH_HOST_APPLE
+#define RollbarCrashCRASH_HAS_PTHREAD_INTROSPECTION 1
+#else
+#define RollbarCrashCRASH_HAS_PTHREAD_INTROSPECTION 0
+#endif
+
+#if RollbarCrashCRASH_HOST_LINUX || RollbarCrashCRASH_HOST_ANDROID
+#define RollbarCrashCRASH_HAS_PROCFS 1
+#else
+#define RollbarCrashCRASH_HAS_PROCFS 0
+#endif
+
 #endif // HDR_RollbarCrashSystemCapabilities_h
@@ -238,9 +238,21 @@
 @end
 
 
+static uint64_t getCurrentNanoseconds(void)
+{
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+
 @implementation RollbarCrashReportFilterPipeline
+{
+    NSMutableArray* _filterNanoseconds;
+    NSMutableArray* _filterCalls;
+    NSMapTable* _serialQueues;
+}
 
 @synthesize filters = _filters;
+@synthesize maxConcurrentReports = _maxConcurrentReports;
 
 + (RollbarCrashReportFilterPipeline*) filterWithFilters:(id) firstFilter, ...
 {
@@ -271,6 +283,12 @@
             }
         }
         self.filters = expandedFilters;
+        self.maxConcurrentReports = 1;
+        _filterNanoseconds = [NSMutableArray array];
+        _filterCalls = [NSMutableArray array];
+        _serialQueues = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                              valueOptions:NSPointerFunctionsStrongMemory];
+        [self resetFilterTimings];
     }
     return self;
 }
@@ -278,13 +296,90 @@
 - (void) addFilter:(id<RollbarCrashReportFilter>) filter
 {
     NSMutableArray* mutableFilters = (NSMutableArray*)self.filters; // Shh! Don't tell anyone!
-    [mutableFilters insertObject:filter atIndex:0];
+    @synchronized(self)
+    {
+        [mutableFilters insertObject:filter atIndex:0];
+        [_filterNanoseconds insertObject:@0 atIndex:0];
+        [_filterCalls insertObject:@0 atIndex:0];
+    }
+}
+
+// ----------------------------------------------------------------------------
+#pragma mark Timing
+// ----------------------------------------------------------------------------
+
+- (void) resetFilterTimings
+{
+    @synchronized(self)
+    {
+        [_filterNanoseconds removeAllObjects];
+        [_filterCalls removeAllObjects];
+        for(NSUInteger i = 0; i < [self.filters count]; i++)
+        {
+            [_filterNanoseconds addObject:@0];
+            [_filterCalls addObject:@0];
+        }
+    }
+}
+
+- (NSArray*) filterDurations
+{
+    @synchronized(self)
+    {
+        NSMutableArray* durations = [NSMutableArray arrayWithCapacity:[_filterNanoseconds count]];
+        for(NSNumber* nanoseconds in _filterNanoseconds)
+        {
+            [durations addObject:@([nanoseconds unsignedLongLongValue] / 1e9)];
+        }
+        return durations;
+    }
 }
 
+- (NSArray*) filterCallCounts
+{
+    @synchronized(self)
+    {
+        return [_filterCalls copy];
+    }
+}
+
+- (void) recordCallToFilter:(id<RollbarCrashReportFilter>) filter startTime:(uint64_t) startTime
+{
+    uint64_t elapsed = getCurrentNanoseconds() - startTime;
+    @synchronized(self)
+    {
+        // Look the filter up rather than trusting an index, in case a filter
+        // was added while reports were being filtered.
+        NSUInteger index = [self.filters indexOfObjectIdenticalTo:filter];
+        if(index != NSNotFound)
+        {
+            _filterNanoseconds[index] = @([_filterNanoseconds[index] unsignedLongLongValue] + elapsed);
+            _filterCalls[index] = @([_filterCalls[index] unsignedLongLongValue] + 1);
+        }
+    }
+}
+
+- (void) callFilter:(id<RollbarCrashReportFilter>) filter
+        withReports:(NSArray*) reports
+       onCompletion:(RollbarCrashReportFilterCompletion) onCompletion
+{
+    uint64_t startTime = getCurrentNanoseconds();
+    [filter filterReports:reports
+             onCompletion:^(NSArray* filteredReports, BOOL completed, NSError* error)
+     {
+         [self recordCallToFilter:filter startTime:startTime];
+         rc_callCompletion(onCompletion, filteredReports, completed, error);
+     }];
+}
+
+// ----------------------------------------------------------------------------
+#pragma mark Filtering
+// ----------------------------------------------------------------------------
+
 - (void) filterReports:(NSArray*) reports
           onCompletion:(RollbarCrashReportFilterCompletion) onCompletion
 {
-    NSArray* filters = self.filters;
+    NSArray* filters = [self.filters copy];
     NSUInteger filterCount = [filters count];
 
     if(filterCount == 0)
@@ -293,6 +388,12 @@
         return;
     }
 
+    if(self.maxConcurrentReports > 1 && [reports count] > 1)
+    {
+        [self filterReportsConcurrently:reports filters:filters onCompletion:onCompletion];
+        return;
+    }
+
     __block NSUInteger iFilter = 0;
     __block RollbarCrashReportFilterCompletion filterCompletion;
     __block __weak RollbarCrashReportFilterCompletion weakFilterCompletion = nil;
@@ -333,7 +434,7 @@
                             if(++iFilter < filterCount)
                             {
                                 id<RollbarCrashReportFilter> filter = [filters objectAtIndex:iFilter];
-                                [filter filterReports:filteredReports onCompletion:weakFilterCompletion];
+                                [self callFilter:filter withReports:filteredReports onCompletion:weakFilterCompletion];
                                 return;
                             }
 
@@ -345,7 +446,167 @@
 
     // Initial call with first filter to start everything going.
     id<RollbarCrashReportFilter> filter = [filters objectAtIndex:iFilter];
-    [filter filterReports:reports onCompletion:filterCompletion];
+    [self callFilter:filter withReports:reports onCompletion:filterCompletion];
+}
+
+/** Get the queue that serializes calls to a filter that isn't thread-safe, or
+ * nil if the filter can be called concurrently.
+ */
+- (dispatch_queue_t) serialQueueForFilter:(id<RollbarCrashReportFilter>) filter
+{
+    if(![filter respondsToSelector:@selector(supportsConcurrentFiltering)] ||
+       [filter supportsConcurrentFiltering])
+    {
+        return nil;
+    }
+    @synchronized(self)
+    {
+        dispatch_queue_t queue = [_serialQueues objectForKey:filter];
+        if(queue == nil)
+        {
+            queue = dispatch_queue_create("com.rollbar.crash.filter.serial", DISPATCH_QUEUE_SERIAL);
+            [_serialQueues setObject:queue forKey:filter];
+        }
+        return queue;
+    }
+}
+
+/** Send one report's worth of reports through the filters, starting at iFilter.
+ */
+- (void) filterReports:(NSArray*) reports
+               filters:(NSArray*) filters
+           filterIndex:(NSUInteger) iFilter
+             workQueue:(dispatch_queue_t) workQueue
+          onCompletion:(RollbarCrashReportFilterCompletion) onCompletion
+{
+    if(iFilter >= [filters count])
+    {
+        rc_callCompletion(onCompletion, reports, YES, nil);
+        return;
+    }
+
+    id<RollbarCrashReportFilter> filter = [filters objectAtIndex:iFilter];
+    dispatch_queue_t serialQueue = [self serialQueueForFilter:filter];
+    RollbarCrashReportFilterCompletion next = ^(NSArray* filteredReports, BOOL completed, NSError* error)
+    {
+        if(!completed)
+        {
+            rc_callCompletion(onCompletion, filteredReports, completed, error);
+            return;
+        }
+        if(filteredReports == nil)
+        {
+            rc_callCompletion(onCompletion, filteredReports, NO,
+                              [NSError errorWithDomain:[[self class] description]
+                                                  code:0
+                                           description:@"filteredReports was nil"]);
+            return;
+        }
+        dispatch_block_t continueFiltering = ^
+        {
+            [self filterReports:filteredReports
+                        filters:filters
+                    filterIndex:iFilter + 1
+                      workQueue:workQueue
+                   onCompletion:onCompletion];
+        };
+        if(serialQueue != nil)
+        {
+            // Don't hold up the serial queue with the rest of the chain.
+            dispatch_async(workQueue, continueFiltering);
+        }
+        else
+        {
+            continueFiltering();
+        }
+    };
+
+    if(serialQueue != nil)
+    {
+        dispatch_async(serialQueue, ^
+                       {
+                           [self callFilter:filter withReports:reports onCompletion:next];
+                       });
+    }
+    else
+    {
+        [self callFilter:filter withReports:reports onCompletion:next];
+    }
+}
+
+- (void) filterReportsConcurrently:(NSArray*) reports
+                           filters:(NSArray*) filters
+                      onCompletion:(RollbarCrashReportFilterCompletion) onCompletion
+{
+    NSUInteger reportCount = [reports count];
+    NSUInteger maxInFlight = MIN(self.maxConcurrentReports, reportCount);
+
+    NSMutableArray* results = [NSMutableArray arrayWithCapacity:reportCount];
+    NSMutableArray* errors = [NSMutableArray arrayWithCapacity:reportCount];
+    for(NSUInteger i = 0; i < reportCount; i++)
+    {
+        [results addObject:[NSNull null]];
+        [errors addObject:[NSNull null]];
+    }
+
+    dispatch_queue_t workQueue = dispatch_queue_create("com.rollbar.crash.filter.workers", DISPATCH_QUEUE_CONCURRENT);
+    dispatch_queue_t feedQueue = dispatch_queue_create("com.rollbar.crash.filter.feeder", DISPATCH_QUEUE_SERIAL);
+    dispatch_semaphore_t slots = dispatch_semaphore_create((long)maxInFlight);
+    dispatch_group_t group = dispatch_group_create();
+
+    // The feeder only hands out a report when a slot is free, so at most
+    // maxInFlight reports are being filtered at any time.
+    dispatch_async(feedQueue, ^
+                   {
+                       for(NSUInteger iReport = 0; iReport < reportCount; iReport++)
+                       {
+                           dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+                           dispatch_group_enter(group);
+                           dispatch_async(workQueue, ^
+                                          {
+                                              [self filterReports:@[reports[iReport]]
+                                                          filters:filters
+                                                      filterIndex:0
+                                                        workQueue:workQueue
+                                                     onCompletion:^(NSArray* filteredReports, BOOL completed, NSError* error)
+                                               {
+                                                   @synchronized(results)
+                                                   {
+                                                       if(completed && filteredReports != nil)
+                                                       {
+                                                           results[iReport] = filteredReports;
+                                                       }
+                                                       else
+                                                       {
+                                                           errors[iReport] = error ?: [NSError errorWithDomain:[[self class] description]
+                                                                                                          code:0
+                                                                                                   description:@"Filtering did not complete"];
+                                                       }
+                                                   }
+                                                   dispatch_semaphore_signal(slots);
+                                                   dispatch_group_leave(group);
+                                               }];
+                                          });
+                       }
+
+                       dispatch_group_notify(group, workQueue, ^
+                                             {
+                                                 NSMutableArray* filteredReports = [NSMutableArray arrayWithCapacity:reportCount];
+                                                 NSError* firstError = nil;
+                                                 for(NSUInteger i = 0; i < reportCount; i++)
+                                                 {
+                                                     if(results[i] != [NSNull null])
+                                                     {
+                                                         [filteredReports addObjectsFromArray:results[i]];
+                                                     }
+                                                     if(firstError == nil && errors[i] != [NSNull null])
+                                                     {
+                                                         firstError = errors[i];
+                                                     }
+                                                 }
+                                                 rc_callCompletion(onCompletion, filteredReports, firstError == nil, firstError);
+                                             });
+                   });
 }
 
 @end
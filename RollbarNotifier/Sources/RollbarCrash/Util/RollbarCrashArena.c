@@ -0,0 +1,288 @@
+//
+//  RollbarCrashArena.c
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include "RollbarCrashArena.h"
+#include "RollbarCrashSystemCapabilities.h"
+
+//#define RollbarCrashLogger_LocalLevel TRACE
+#include "RollbarCrashLogger.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if RollbarCrashCRASH_HOST_APPLE
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#endif
+
+
+/* The arena state packs the number of open scopes into the top 16 bits and
+ * the bump offset into the low 48, so that allocating and rewinding are each
+ * a single compare-and-swap and can never interleave badly.
+ */
+#define OFFSET_MASK ((UINT64_C(1) << 48) - 1)
+#define ONE_SCOPE (UINT64_C(1) << 48)
+#define ALIGNMENT 16
+
+static uint8_t* g_arenaBase;
+static size_t g_arenaSize;
+static _Atomic(uint64_t) g_arenaState;
+
+static _Atomic(bool) g_trapsAllocations;
+static _Atomic(uintptr_t) g_crashHandlingThread;
+
+
+// ============================================================================
+#pragma mark - Allocation traps -
+// ============================================================================
+
+#if RollbarCrashCRASH_HOST_APPLE
+
+static void* (*g_zoneMalloc)(struct _malloc_zone_t*, size_t);
+static void* (*g_zoneCalloc)(struct _malloc_zone_t*, size_t, size_t);
+static void* (*g_zoneValloc)(struct _malloc_zone_t*, size_t);
+static void* (*g_zoneRealloc)(struct _malloc_zone_t*, void*, size_t);
+static bool g_zoneIsPatched;
+
+static void trapIfHandlingCrash(void)
+{
+    if(atomic_load(&g_trapsAllocations) &&
+       atomic_load(&g_crashHandlingThread) == (uintptr_t)pthread_self())
+    {
+        static const char message[] = "RollbarCrash: malloc called while handling a fatal exception\n";
+        write(STDERR_FILENO, message, sizeof(message) - 1);
+        __builtin_trap();
+    }
+}
+
+static void* trappingMalloc(struct _malloc_zone_t* zone, size_t size)
+{
+    trapIfHandlingCrash();
+    return g_zoneMalloc(zone, size);
+}
+
+static void* trappingCalloc(struct _malloc_zone_t* zone, size_t count, size_t size)
+{
+    trapIfHandlingCrash();
+    return g_zoneCalloc(zone, count, size);
+}
+
+static void* trappingValloc(struct _malloc_zone_t* zone, size_t size)
+{
+    trapIfHandlingCrash();
+    return g_zoneValloc(zone, size);
+}
+
+static void* trappingRealloc(struct _malloc_zone_t* zone, void* ptr, size_t size)
+{
+    trapIfHandlingCrash();
+    return g_zoneRealloc(zone, ptr, size);
+}
+
+/** The memory protection of the region holding an address, as mprotect() flags. */
+static int getProtection(uintptr_t address)
+{
+    mach_port_t task = mach_task_self();
+    vm_size_t size = 0;
+    vm_address_t regionAddress = (vm_address_t)address;
+    memory_object_name_t object;
+#if __LP64__
+    mach_msg_type_number_t count = VM_REGION_BASIC_INFO_COUNT_64;
+    vm_region_basic_info_data_64_t info;
+    kern_return_t result =
+        vm_region_64(task, &regionAddress, &size, VM_REGION_BASIC_INFO_64, (vm_region_info_64_t)&info, &count, &object);
+#else
+    mach_msg_type_number_t count = VM_REGION_BASIC_INFO_COUNT;
+    vm_region_basic_info_data_t info;
+    kern_return_t result =
+        vm_region(task, &regionAddress, &size, VM_REGION_BASIC_INFO, (vm_region_info_t)&info, &count, &object);
+#endif
+    if(result != KERN_SUCCESS)
+    {
+        return PROT_READ;
+    }
+
+    int protection = 0;
+    if(info.protection & VM_PROT_READ)
+    {
+        protection |= PROT_READ;
+    }
+    if(info.protection & VM_PROT_WRITE)
+    {
+        protection |= PROT_WRITE;
+    }
+    if(info.protection & VM_PROT_EXECUTE)
+    {
+        protection |= PROT_EXEC;
+    }
+    return protection;
+}
+
+/** Only the default zone is patched: allocations from other malloc zones, such as
+ * ones created with malloc_create_zone() or the scalable zones of some allocators,
+ * are not trapped.
+ */
+static void patchDefaultZone(void)
+{
+    if(g_zoneIsPatched)
+    {
+        return;
+    }
+    malloc_zone_t* zone = malloc_default_zone();
+    uintptr_t start = trunc_page((uintptr_t)zone);
+    size_t length = round_page((uintptr_t)zone + sizeof(*zone)) - start;
+    int originalProtection = getProtection(start);
+    if(mprotect((void*)start, length, PROT_READ | PROT_WRITE) != 0)
+    {
+        RCLOG_ERROR("Could not unprotect the default malloc zone: %s", strerror(errno));
+        return;
+    }
+    g_zoneMalloc = zone->malloc;
+    g_zoneCalloc = zone->calloc;
+    g_zoneValloc = zone->valloc;
+    g_zoneRealloc = zone->realloc;
+    zone->malloc = trappingMalloc;
+    zone->calloc = trappingCalloc;
+    zone->valloc = trappingValloc;
+    zone->realloc = trappingRealloc;
+    mprotect((void*)start, length, originalProtection);
+    g_zoneIsPatched = true;
+}
+
+#endif
+
+
+// ============================================================================
+#pragma mark - API -
+// ============================================================================
+
+bool rcarena_initialize(size_t byteCount)
+{
+    if(g_arenaBase != NULL)
+    {
+        return true;
+    }
+    if(byteCount == 0)
+    {
+        byteCount = RollbarCrashArena_DEFAULT_SIZE;
+    }
+    void* base = mmap(NULL, byteCount, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if(base == MAP_FAILED)
+    {
+        RCLOG_ERROR("Could not map %zu byte crash arena: %s", byteCount, strerror(errno));
+        return false;
+    }
+    g_arenaSize = byteCount;
+    g_arenaBase = base;
+    return true;
+}
+
+void rcarena_begin(void)
+{
+    atomic_fetch_add(&g_arenaState, ONE_SCOPE);
+}
+
+void rcarena_end(void)
+{
+    uint64_t state = atomic_load(&g_arenaState);
+    for(;;)
+    {
+        uint64_t scopes = state >> 48;
+        if(scopes == 0)
+        {
+            RCLOG_ERROR("Unbalanced call to rcarena_end()");
+            return;
+        }
+        uint64_t next = scopes == 1 ? 0 : state - ONE_SCOPE;
+        if(atomic_compare_exchange_weak(&g_arenaState, &state, next))
+        {
+            return;
+        }
+    }
+}
+
+void* rcarena_alloc(size_t byteCount)
+{
+    if(g_arenaBase == NULL)
+    {
+        return NULL;
+    }
+    byteCount = (byteCount + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+    uint64_t state = atomic_load(&g_arenaState);
+    for(;;)
+    {
+        uint64_t offset = state & OFFSET_MASK;
+        if(byteCount > g_arenaSize - offset)
+        {
+            return NULL;
+        }
+        if(atomic_compare_exchange_weak(&g_arenaState, &state, state + byteCount))
+        {
+            void* memory = g_arenaBase + offset;
+            memset(memory, 0, byteCount);
+            return memory;
+        }
+    }
+}
+
+char* rcarena_strdup(const char* string)
+{
+    size_t length = strlen(string) + 1;
+    char* copy = rcarena_alloc(length);
+    if(copy != NULL)
+    {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+void rcarena_setTrapsAllocations(bool trapsAllocations)
+{
+#if RollbarCrashCRASH_HOST_APPLE
+    if(trapsAllocations)
+    {
+        patchDefaultZone();
+    }
+#else
+    if(trapsAllocations)
+    {
+        RCLOG_WARN("Allocation traps are not supported on this platform.");
+    }
+#endif
+    atomic_store(&g_trapsAllocations, trapsAllocations);
+}
+
+void rcarena_notifyCrashHandlingStarted(void)
+{
+    atomic_store(&g_crashHandlingThread, (uintptr_t)pthread_self());
+}
+
+void rcarena_notifyCrashHandlingEnded(void)
+{
+    atomic_store(&g_crashHandlingThread, (uintptr_t)0);
+}
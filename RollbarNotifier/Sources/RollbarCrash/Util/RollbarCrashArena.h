@@ -0,0 +1,95 @@
+//
+//  RollbarCrashArena.h
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall remain in place
+// in this source code.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/* Fixed-size scratch memory for code that may run while handling a crash.
+ *
+ * The arena is mapped once at install time. Allocation is a lock-free pointer
+ * bump, so it is async-safe and never enters malloc.
+ * Memory is not freed individually: callers bracket their use with
+ * rcarena_begin() / rcarena_end(), and the arena rewinds once the last
+ * such scope has ended.
+ */
+
+#ifndef HDR_RollbarCrashArena_h
+#define HDR_RollbarCrashArena_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Default arena size, in bytes. */
+#define RollbarCrashArena_DEFAULT_SIZE (64 * 1024)
+
+/** Map the arena. Subsequent calls do nothing.
+ *
+ * @param byteCount The arena size. 0 = use the default.
+ *
+ * @return true if the arena is available.
+ */
+bool rcarena_initialize(size_t byteCount);
+
+/** Open an allocation scope.
+ * Memory allocated inside a scope stays valid until every open scope has ended.
+ */
+void rcarena_begin(void);
+
+/** Close an allocation scope. Rewinds the arena when no scope remains open. */
+void rcarena_end(void);
+
+/** Allocate zero-filled memory from the arena, aligned to 16 bytes.
+ *
+ * This function is async-safe.
+ *
+ * @return The memory, or NULL if the arena is exhausted or not initialized.
+ */
+void* rcarena_alloc(size_t byteCount);
+
+/** Copy a null terminated string into the arena.
+ *
+ * This function is async-safe.
+ *
+ * @return The copy, or NULL if the arena is exhausted or not initialized.
+ */
+char* rcarena_strdup(const char* string);
+
+/** Debug aid: trap if the thread handling a fatal exception calls malloc.
+ * Only implemented on Apple platforms; elsewhere this does nothing.
+ * Only the default malloc zone is covered, so allocations from other zones are not trapped.
+ *
+ * Default: false
+ */
+void rcarena_setTrapsAllocations(bool trapsAllocations);
+
+/** Note that the calling thread has started handling a fatal exception. */
+void rcarena_notifyCrashHandlingStarted(void);
+
+/** Note that the calling thread has finished handling a non-fatal exception. */
+void rcarena_notifyCrashHandlingEnded(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HDR_RollbarCrashArena_h
@@ -50,9 +50,10 @@
 
 #include "RollbarCrashCxaThrowSwapper.h"
 
+#include <stdatomic.h>
 #include <stdlib.h>
-#include <execinfo.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -73,55 +74,104 @@ typedef struct
     uintptr_t function;
 } RollbarCrashAddressPair;
 
+typedef struct
+{
+    _Atomic(uintptr_t) image;
+    uintptr_t function;
+} RollbarCrashAddressEntry;
+
 static cxa_throw_type g_cxa_throw_handler = NULL;
 static const char *const g_cxa_throw_name = "__cxa_throw";
 
-static RollbarCrashAddressPair *g_cxa_originals = NULL;
-static size_t g_cxa_originals_capacity = 0;
+/** Maximum number of images whose __cxa_throw binding can be swapped.
+ * The table is fixed so that throwing never races a reallocation.
+ * Images beyond this limit keep their original binding.
+ */
+#define RollbarCrashCXA_MAX_IMAGES 2048
+
+/** Open-addressed table of original __cxa_throw bindings, keyed by image base address.
+ * It is kept at most half full so that probe sequences stay short.
+ * Entries are only ever added: an image key is published after its function,
+ * so lookups need no lock.
+ */
+#define RollbarCrashCXA_TABLE_BITS 12
+#define RollbarCrashCXA_TABLE_SIZE (1 << RollbarCrashCXA_TABLE_BITS)
+
+static RollbarCrashAddressEntry g_cxa_originals[RollbarCrashCXA_TABLE_SIZE];
 static size_t g_cxa_originals_count = 0;
+static pthread_mutex_t g_cxa_originals_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void addPair(RollbarCrashAddressPair pair)
+static inline size_t hashImage(uintptr_t image)
 {
-    if (g_cxa_originals_count == g_cxa_originals_capacity)
+    // Images are page aligned, so the low bits carry no information.
+    return (size_t) (((uint64_t) (image >> 12) * 0x9E3779B97F4A7C15ULL) >> (64 - RollbarCrashCXA_TABLE_BITS));
+}
+
+static bool addPair(RollbarCrashAddressPair pair)
+{
+    bool isAdded = false;
+    pthread_mutex_lock(&g_cxa_originals_mutex);
+    size_t index = hashImage(pair.image);
+    for (size_t probe = 0; probe < RollbarCrashCXA_TABLE_SIZE; probe++)
     {
-        g_cxa_originals_capacity *= 2;
-        g_cxa_originals = (RollbarCrashAddressPair *) realloc(g_cxa_originals, sizeof(RollbarCrashAddressPair) * g_cxa_originals_capacity);
+        RollbarCrashAddressEntry *entry = &g_cxa_originals[index];
+        uintptr_t image = atomic_load_explicit(&entry->image, memory_order_relaxed);
+        if (image == pair.image)
+        {
+            // Already swapped. Keep the first original; the binding now points at the decorator.
+            isAdded = true;
+            break;
+        }
+        if (image == 0)
+        {
+            if (g_cxa_originals_count < RollbarCrashCXA_MAX_IMAGES)
+            {
+                entry->function = pair.function;
+                atomic_store_explicit(&entry->image, pair.image, memory_order_release);
+                g_cxa_originals_count++;
+                isAdded = true;
+            }
+            break;
+        }
+        index = (index + 1) & (RollbarCrashCXA_TABLE_SIZE - 1);
     }
-    memcpy(&g_cxa_originals[g_cxa_originals_count++], &pair, sizeof(RollbarCrashAddressPair));
+    pthread_mutex_unlock(&g_cxa_originals_mutex);
+    return isAdded;
 }
 
 static uintptr_t findAddress(void *address)
 {
-    for (size_t i = 0; i < g_cxa_originals_count; i++)
+    size_t index = hashImage((uintptr_t) address);
+    for (size_t probe = 0; probe < RollbarCrashCXA_TABLE_SIZE; probe++)
     {
-        if (g_cxa_originals[i].image == (uintptr_t) address)
+        const RollbarCrashAddressEntry *entry = &g_cxa_originals[index];
+        uintptr_t image = atomic_load_explicit(&entry->image, memory_order_acquire);
+        if (image == (uintptr_t) address)
+        {
+            return entry->function;
+        }
+        if (image == 0)
         {
-            return g_cxa_originals[i].function;
+            break;
         }
+        index = (index + 1) & (RollbarCrashCXA_TABLE_SIZE - 1);
     }
     return (uintptr_t) NULL;
 }
 
 static void __cxa_throw_decorator(void *thrown_exception, void *tinfo, void (*dest)(void *))
 {
-    const int k_requiredFrames = 2;
-
     g_cxa_throw_handler(thrown_exception, tinfo, dest);
 
-    void *backtraceArr[k_requiredFrames];
-    int count = backtrace(backtraceArr, k_requiredFrames);
-
+    // The caller is the throw site, in the image whose binding was swapped.
     Dl_info info;
-    if (count >= k_requiredFrames)
+    if (dladdr(__builtin_return_address(0), &info) != 0)
     {
-        if (dladdr(backtraceArr[k_requiredFrames - 1], &info) != 0)
+        uintptr_t function = findAddress(info.dli_fbase);
+        if (function != (uintptr_t) NULL)
         {
-            uintptr_t function = findAddress(info.dli_fbase);
-            if (function != (uintptr_t) NULL)
-            {
-                cxa_throw_type original = (cxa_throw_type) function;
-                original(thrown_exception, tinfo, dest);
-            }
+            cxa_throw_type original = (cxa_throw_type) function;
+            original(thrown_exception, tinfo, dest);
         }
     }
 }
@@ -276,9 +326,11 @@ static void perform_rebinding_with_section(const section_t *section,
             if (dladdr(section, &info) != 0)
             {
                 RollbarCrashAddressPair pair = {(uintptr_t) info.dli_fbase, (uintptr_t) indirect_symbol_bindings[i]};
-                addPair(pair);
+                if (addPair(pair))
+                {
+                    indirect_symbol_bindings[i] = (void *) __cxa_throw_decorator;
+                }
             }
-            indirect_symbol_bindings[i] = (void *) __cxa_throw_decorator;
             continue;
         }
     }
@@ -352,13 +404,6 @@ static void rebind_symbols_for_image(const struct mach_header *header, intptr_t
 
 int rcct_swap(const cxa_throw_type handler)
 {
-    if (g_cxa_originals == NULL)
-    {
-        g_cxa_originals_capacity = 25;
-        g_cxa_originals = (RollbarCrashAddressPair *) malloc(sizeof(RollbarCrashAddressPair) * g_cxa_originals_capacity);
-    }
-    g_cxa_originals_count = 0;
-
     if (g_cxa_throw_handler == NULL)
     {
         g_cxa_throw_handler = handler;
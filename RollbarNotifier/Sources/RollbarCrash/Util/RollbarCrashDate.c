@@ -23,35 +23,91 @@
 //
 
 #include "RollbarCrashDate.h"
-#include <stdio.h>
-#include <time.h>
+
+#include <stdint.h>
+
+
+/* Dates are formatted by hand rather than through gmtime_r() and snprintf(),
+ * so that they are async-safe and never touch locale state.
+ */
+
+#define SECONDS_PER_DAY 86400
+
+/** Convert days since 1970-01-01 to a proleptic Gregorian date.
+ * This is the "civil_from_days" algorithm by Howard Hinnant:
+ * http://howardhinnant.github.io/date_algorithms.html
+ */
+static void civilFromDays(int64_t days, int64_t* year, unsigned* month, unsigned* day)
+{
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const unsigned dayOfEra = (unsigned)(days - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    *year = (int64_t)yearOfEra + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
+static char* writeDigits(char* dst, uint64_t value, int digitCount)
+{
+    for(int i = digitCount - 1; i >= 0; i--)
+    {
+        dst[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    return dst + digitCount;
+}
+
+/** Write "YYYY-MM-DDTHH:MM:SS" (19 chars, not terminated). */
+static char* writeDateTime(char* dst, int64_t seconds)
+{
+    int64_t days = seconds / SECONDS_PER_DAY;
+    int64_t secondOfDay = seconds % SECONDS_PER_DAY;
+    if(secondOfDay < 0)
+    {
+        secondOfDay += SECONDS_PER_DAY;
+        days--;
+    }
+    int64_t year;
+    unsigned month;
+    unsigned day;
+    civilFromDays(days, &year, &month, &day);
+
+    dst = writeDigits(dst, (uint64_t)year, 4);
+    *dst++ = '-';
+    dst = writeDigits(dst, month, 2);
+    *dst++ = '-';
+    dst = writeDigits(dst, day, 2);
+    *dst++ = 'T';
+    dst = writeDigits(dst, (uint64_t)(secondOfDay / 3600), 2);
+    *dst++ = ':';
+    dst = writeDigits(dst, (uint64_t)(secondOfDay / 60 % 60), 2);
+    *dst++ = ':';
+    dst = writeDigits(dst, (uint64_t)(secondOfDay % 60), 2);
+    return dst;
+}
 
 void rcdate_utcStringFromTimestamp(time_t timestamp, char* buffer21Chars)
 {
-    struct tm result = {0};
-    gmtime_r(&timestamp, &result);
-    snprintf(buffer21Chars, 21, "%04d-%02d-%02dT%02d:%02d:%02dZ",
-             result.tm_year + 1900,
-             result.tm_mon + 1,
-             result.tm_mday,
-             result.tm_hour,
-             result.tm_min,
-             result.tm_sec);
+    char* dst = writeDateTime(buffer21Chars, (int64_t)timestamp);
+    *dst++ = 'Z';
+    *dst = 0;
 }
 
 void rcdate_utcStringFromMicroseconds(int64_t microseconds, char* buffer28Chars)
 {
-    struct tm result = {0};
-    time_t curtime = (time_t)(microseconds / 1000000);
-    long micros = (long)(microseconds % 1000000);
-
-    gmtime_r(&curtime, &result);
-    snprintf(buffer28Chars, 28, "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
-             result.tm_year + 1900,
-             result.tm_mon + 1,
-             result.tm_mday,
-             result.tm_hour,
-             result.tm_min,
-             result.tm_sec,
-             micros);
+    int64_t seconds = microseconds / 1000000;
+    int64_t micros = microseconds % 1000000;
+    if(micros < 0)
+    {
+        micros += 1000000;
+        seconds--;
+    }
+    char* dst = writeDateTime(buffer28Chars, seconds);
+    *dst++ = '.';
+    dst = writeDigits(dst, (uint64_t)micros, 6);
+    *dst++ = 'Z';
+    *dst = 0;
 }
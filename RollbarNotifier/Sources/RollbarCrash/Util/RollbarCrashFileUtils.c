@@ -94,13 +94,22 @@ static int dirContentsCount(const char* path)
     return count;
 }
 
-static void dirContents(const char* path, char*** entries, int* count)
+/** List a directory into heap memory, to be released with freeDirListing().
+ * This only runs outside crash handling, so it does not need the crash arena and
+ * is not bounded by its size.
+ *
+ * @return false if the directory could not be listed in full. Whatever was listed
+ *         is still returned and must be freed.
+ */
+static bool dirContents(const char* path, char*** entries, int* count)
 {
+    bool isComplete = false;
     DIR* dir = NULL;
     char** entryList = NULL;
     int entryCount = dirContentsCount(path);
     if(entryCount <= 0)
     {
+        isComplete = entryCount == 0;
         goto done;
     }
     dir = opendir(path);
@@ -111,6 +120,11 @@ static void dirContents(const char* path, char*** entries, int* count)
     }
 
     entryList = calloc((unsigned)entryCount, sizeof(char*));
+    if(entryList == NULL)
+    {
+        RCLOG_ERROR("Not enough memory to list %s", path);
+        goto done;
+    }
     struct dirent* ent;
     int index = 0;
     while((ent = readdir(dir)))
@@ -121,8 +135,14 @@ static void dirContents(const char* path, char*** entries, int* count)
             goto done;
         }
         entryList[index] = strdup(ent->d_name);
+        if(entryList[index] == NULL)
+        {
+            RCLOG_ERROR("Not enough memory to list %s", path);
+            goto done;
+        }
         index++;
     }
+    isComplete = true;
 
 done:
     if(dir != NULL)
@@ -135,6 +155,7 @@ done:
     }
     *entries = entryList;
     *count = entryCount;
+    return isComplete;
 }
 
 static void freeDirListing(char** entries, int count)
@@ -165,10 +186,10 @@ static bool deletePathContents(const char* path, bool deleteTopLevelPathAlso)
     {
         char** entries = NULL;
         int entryCount = 0;
-        dirContents(path, &entries, &entryCount);
+        bool isSuccessful = dirContents(path, &entries, &entryCount);
 
-        int bufferLength = RollbarCrashFU_MAX_PATH_LENGTH;
-        char* pathBuffer = malloc((unsigned)bufferLength);
+        char pathBuffer[RollbarCrashFU_MAX_PATH_LENGTH];
+        int bufferLength = sizeof(pathBuffer);
         snprintf(pathBuffer, bufferLength, "%s/", path);
         char* pathPtr = pathBuffer + strlen(pathBuffer);
         int pathRemainingLength = bufferLength - (int)(pathPtr - pathBuffer);
@@ -179,20 +200,27 @@ static bool deletePathContents(const char* path, bool deleteTopLevelPathAlso)
             if(entry != NULL && canDeletePath(entry))
             {
                 strncpy(pathPtr, entry, pathRemainingLength);
-                deletePathContents(pathBuffer, true);
+                if(!deletePathContents(pathBuffer, true))
+                {
+                    isSuccessful = false;
+                }
             }
         }
 
-        free(pathBuffer);
         freeDirListing(entries, entryCount);
+        if(!isSuccessful)
+        {
+            RCLOG_ERROR("Could not delete all contents of %s", path);
+            return false;
+        }
         if(deleteTopLevelPathAlso)
         {
-            rcfu_removeFile(path, false);
+            return rcfu_removeFile(path, false);
         }
     }
     else if(S_ISREG(statStruct.st_mode))
     {
-        rcfu_removeFile(path, false);
+        return rcfu_removeFile(path, false);
     }
     else
     {
@@ -23,31 +23,117 @@
 //
 
 
-#include <stdio.h>
-#include <uuid/uuid.h>
+#include "RollbarCrashID.h"
 
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <sys/random.h>
+#endif
+
+
+/* IDs come from a counter-based generator: each call takes the next value of
+ * a process-wide atomic counter and runs it through the SplitMix64 finalizer
+ * under two independent 64-bit seeds, one per half of the UUID. Taking a
+ * counter value is a single atomic add, so generation is lock-free and
+ * async-safe, and concurrent callers can never produce the same ID.
+ */
+
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15ULL
+
+typedef enum
+{
+    SeedState_Unseeded,
+    SeedState_Seeding,
+    SeedState_Seeded,
+} SeedState;
+
+static uint64_t g_seeds[2];
+static _Atomic(uint64_t) g_counter;
+/** g_seeds may only be read once this is SeedState_Seeded, loaded with acquire ordering. */
+static _Atomic(int) g_seedState;
+
+static const char g_hexDigits[] = "0123456789ABCDEF";
+
+/** Where each UUID byte goes in the formatted string. */
+static const uint8_t g_byteOffsets[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+
+static inline uint64_t mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void seed(uint64_t seeds[2])
+{
+    seeds[0] = seeds[1] = 0;
+    if(getentropy(seeds, 2 * sizeof(uint64_t)) != 0)
+    {
+        // No entropy source. Mix together what is unique to this process.
+        struct timespec now = {0};
+        clock_gettime(CLOCK_REALTIME, &now);
+        seeds[0] = mix64((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+        seeds[1] = mix64(((uint64_t)getpid() << 32) ^ (uint64_t)(uintptr_t)&now);
+    }
+}
+
+void rcid_initialize(void)
+{
+    int expected = SeedState_Unseeded;
+    if(atomic_compare_exchange_strong_explicit(&g_seedState, &expected, SeedState_Seeding,
+                                               memory_order_acquire, memory_order_acquire))
+    {
+        seed(g_seeds);
+        atomic_store_explicit(&g_seedState, SeedState_Seeded, memory_order_release);
+    }
+}
+
+static inline void writeHexByte(char* const dst, const uint8_t value)
+{
+    dst[0] = g_hexDigits[value >> 4];
+    dst[1] = g_hexDigits[value & 0xf];
+}
 
 void rcid_generate(char* destinationBuffer37Bytes)
 {
-    uuid_t uuid;
-    uuid_generate(uuid);
-    sprintf(destinationBuffer37Bytes,
-            "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X",
-            (unsigned)uuid[0],
-            (unsigned)uuid[1],
-            (unsigned)uuid[2],
-            (unsigned)uuid[3],
-            (unsigned)uuid[4],
-            (unsigned)uuid[5],
-            (unsigned)uuid[6],
-            (unsigned)uuid[7],
-            (unsigned)uuid[8],
-            (unsigned)uuid[9],
-            (unsigned)uuid[10],
-            (unsigned)uuid[11],
-            (unsigned)uuid[12],
-            (unsigned)uuid[13],
-            (unsigned)uuid[14],
-            (unsigned)uuid[15]
-            );
+    rcid_initialize();
+
+    const uint64_t* seeds = g_seeds;
+    uint64_t ownSeeds[2];
+    if(atomic_load_explicit(&g_seedState, memory_order_acquire) != SeedState_Seeded)
+    {
+        // Another thread is still seeding, and waiting for it could deadlock if we interrupted it
+        // from a signal handler. Seed this one ID on its own instead.
+        seed(ownSeeds);
+        seeds = ownSeeds;
+    }
+
+    const uint64_t counter = atomic_fetch_add_explicit(&g_counter, 1, memory_order_relaxed);
+    const uint64_t halves[2] =
+    {
+        mix64(seeds[0] + counter * GOLDEN_GAMMA),
+        mix64(seeds[1] + counter * GOLDEN_GAMMA),
+    };
+    uint8_t uuid[16];
+    for(int i = 0; i < 8; i++)
+    {
+        uuid[i] = (uint8_t)(halves[0] >> (56 - i * 8));
+        uuid[i + 8] = (uint8_t)(halves[1] >> (56 - i * 8));
+    }
+    // RFC 4122: version 4 (random), variant 10xx.
+    uuid[6] = (uuid[6] & 0x0f) | 0x40;
+    uuid[8] = (uuid[8] & 0x3f) | 0x80;
+
+    char* dst = destinationBuffer37Bytes;
+    for(int i = 0; i < 16; i++)
+    {
+        writeHexByte(dst + g_byteOffsets[i], uuid[i]);
+    }
+    dst[8] = dst[13] = dst[18] = dst[23] = '-';
+    dst[36] = 0;
 }
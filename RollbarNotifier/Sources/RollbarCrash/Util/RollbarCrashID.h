@@ -30,7 +30,16 @@ extern "C" {
 #endif
     
 
+/** Seed the ID generator from the system entropy source.
+ * Call this at startup so that the crash path never has to seed.
+ * rcid_generate() seeds on first use if this was not called.
+ */
+void rcid_initialize(void);
+
 /** Generate a new human readabale, null terminated, globally unique ID string.
+ * The ID is a random (version 4) UUID in upper case.
+ *
+ * This function is async-safe once the generator has been seeded.
  *
  * @param destinationBuffer37Bytes Buffer of at least 37 bytes to hold the ID.
  */
@@ -29,6 +29,7 @@
 #include "RollbarCrashSystemCapabilities.h"
 #include "RollbarCrashCPU.h"
 #include "RollbarCrashCPU_Apple.h"
+#include "RollbarCrashMemory.h"
 #include "RollbarCrashStackCursor_MachineContext.h"
 
 #include <mach/mach.h>
@@ -128,6 +129,19 @@ bool rcmc_getContextForThread(RollbarCrashThread thread, RollbarCrashMachineCont
     return true;
 }
 
+bool rcmc_getContextForCapturedThread(RollbarCrashThread thread, RollbarCrashMachineContext* destinationContext)
+{
+    RCLOG_DEBUG("Fill captured thread 0x%x context into %p.", thread, destinationContext);
+    memset(destinationContext, 0, sizeof(*destinationContext));
+    destinationContext->thisThread = (thread_t)thread;
+    // Its registers are long gone, so treat it like the current thread and read none.
+    destinationContext->isCurrentThread = true;
+    destinationContext->isCrashedContext = true;
+    destinationContext->allThreads[0] = (thread_t)thread;
+    destinationContext->threadCount = 1;
+    return true;
+}
+
 bool rcmc_getContextForSignal(void* signalUserContext, RollbarCrashMachineContext* destinationContext)
 {
     RCLOG_DEBUG("Get context from signal user context and put into %p.", destinationContext);
@@ -193,6 +207,9 @@ void rcmc_suspendEnvironment(__unused thread_act_array_t *suspendedThreads, __un
             }
         }
     }
+
+    // Nothing can remap memory until we resume, so readability probes can be remembered.
+    rcmem_enablePageCache();
     
     RCLOG_DEBUG("Suspend complete.");
 #endif
@@ -205,6 +222,9 @@ void rcmc_resumeEnvironment(__unused thread_act_array_t threads, __unused mach_m
     kern_return_t kr;
     const task_t thisTask = mach_task_self();
     const thread_t thisThread = (thread_t)rcthread_self();
+
+    // Forget remembered pages even when there is nothing to resume, so they can't outlive the suspension.
+    rcmem_disablePageCache();
     
     if(threads == NULL || numThreads == 0)
     {
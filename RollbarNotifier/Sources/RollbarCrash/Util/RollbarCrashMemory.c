@@ -25,15 +25,162 @@
 //
 
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+// Needed for process_vm_readv().
+#define _GNU_SOURCE
+#endif
+
 #include "RollbarCrashMemory.h"
 
+#include "RollbarCrashSystemCapabilities.h"
+
 //#define RollbarCrashLogger_LocalLevel TRACE
 #include "RollbarCrashLogger.h"
 
+#if RollbarCrashCRASH_HOST_APPLE
 #include <mach/mach.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#include <stdint.h>
+#include <string.h>
 
 
-static inline int copySafely(const void* restrict const src, void* restrict const dst, const int byteCount)
+/** Readability is remembered in 4 KiB blocks. Protection is uniform within a
+ * block whatever the real VM page size is, since pages are never smaller.
+ */
+#define RollbarCrashMEM_PAGE_SHIFT 12
+
+/** Number of entries in the direct-mapped page cache. Must be a power of 2. */
+#define RollbarCrashMEM_PAGE_CACHE_SIZE 256
+
+/** Maximum number of regions handed to the kernel in one batched read. */
+#define RollbarCrashMEM_MAX_BATCH_SIZE 64
+
+typedef enum
+{
+    PageStateUnknown = 0,
+    PageStateReadable,
+    PageStateUnreadable,
+} PageState;
+
+/** Page number + 1 for each cache entry, or 0 if the entry is empty. */
+static uintptr_t g_pageCacheTags[RollbarCrashMEM_PAGE_CACHE_SIZE];
+static uint8_t g_pageCacheStates[RollbarCrashMEM_PAGE_CACHE_SIZE];
+static volatile bool g_pageCacheEnabled = false;
+
+
+// ============================================================================
+#pragma mark - Page Cache -
+// ============================================================================
+
+static inline PageState getPageState(const uintptr_t page)
+{
+    const int entry = (int)(page & (RollbarCrashMEM_PAGE_CACHE_SIZE - 1));
+    if(g_pageCacheTags[entry] != page + 1)
+    {
+        return PageStateUnknown;
+    }
+    return (PageState)g_pageCacheStates[entry];
+}
+
+static inline void setPageState(const uintptr_t page, const PageState state)
+{
+    const int entry = (int)(page & (RollbarCrashMEM_PAGE_CACHE_SIZE - 1));
+    g_pageCacheTags[entry] = page + 1;
+    g_pageCacheStates[entry] = (uint8_t)state;
+}
+
+/** Look up a whole range in the page cache.
+ *
+ * @return PageStateReadable if every page is known to be readable,
+ *         PageStateUnreadable if any page is known to be unreadable,
+ *         PageStateUnknown otherwise.
+ */
+static inline PageState getRangeState(const void* const memory, const int byteCount)
+{
+    if(!g_pageCacheEnabled || byteCount <= 0)
+    {
+        return PageStateUnknown;
+    }
+    const uintptr_t firstPage = (uintptr_t)memory >> RollbarCrashMEM_PAGE_SHIFT;
+    const uintptr_t lastPage = ((uintptr_t)memory + (uintptr_t)byteCount - 1) >> RollbarCrashMEM_PAGE_SHIFT;
+    if(lastPage < firstPage)
+    {
+        // Wrapped around the address range.
+        return PageStateUnreadable;
+    }
+    PageState rangeState = PageStateReadable;
+    for(uintptr_t page = firstPage; page <= lastPage; page++)
+    {
+        PageState state = getPageState(page);
+        if(state == PageStateUnreadable)
+        {
+            return PageStateUnreadable;
+        }
+        if(state != PageStateReadable)
+        {
+            rangeState = PageStateUnknown;
+        }
+    }
+    return rangeState;
+}
+
+/** Record the outcome of a read in the page cache.
+ *
+ * Every page holding a copied byte is readable. A failed remainder is only
+ * recorded as unreadable when it lies within a single page, since otherwise
+ * we cannot tell which of its pages caused the failure.
+ */
+static inline void rememberReadResult(const void* const memory, const int byteCount, const int bytesCopied)
+{
+    if(!g_pageCacheEnabled || byteCount <= 0)
+    {
+        return;
+    }
+    const uintptr_t start = (uintptr_t)memory;
+    if(bytesCopied > 0)
+    {
+        const uintptr_t lastPage = (start + (uintptr_t)bytesCopied - 1) >> RollbarCrashMEM_PAGE_SHIFT;
+        for(uintptr_t page = start >> RollbarCrashMEM_PAGE_SHIFT; page <= lastPage; page++)
+        {
+            setPageState(page, PageStateReadable);
+        }
+    }
+    if(bytesCopied < byteCount)
+    {
+        const uintptr_t failedStart = start + (uintptr_t)bytesCopied;
+        const uintptr_t failedPage = failedStart >> RollbarCrashMEM_PAGE_SHIFT;
+        if(failedPage == ((start + (uintptr_t)byteCount - 1) >> RollbarCrashMEM_PAGE_SHIFT))
+        {
+            setPageState(failedPage, PageStateUnreadable);
+        }
+    }
+}
+
+void rcmem_enablePageCache(void)
+{
+    memset(g_pageCacheTags, 0, sizeof(g_pageCacheTags));
+    g_pageCacheEnabled = true;
+}
+
+void rcmem_disablePageCache(void)
+{
+    g_pageCacheEnabled = false;
+    memset(g_pageCacheTags, 0, sizeof(g_pageCacheTags));
+}
+
+
+// ============================================================================
+#pragma mark - Platform Backends -
+// ============================================================================
+
+#if RollbarCrashCRASH_HOST_APPLE
+
+static inline int readMemory(const void* const src, void* const dst, const int byteCount)
 {
     vm_size_t bytesCopied = 0;
     kern_return_t result = vm_read_overwrite(mach_task_self(),
@@ -48,6 +195,203 @@ static inline int copySafely(const void* restrict const src, void* restrict cons
     return (int)bytesCopied;
 }
 
+/** Mach has no scatter read for our own task, so batches are read one region
+ * at a time. The page cache still saves a trap for most of them.
+ */
+static int readMemoryBatch(RollbarCrashMemoryCopy* const copies, const int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        int bytesCopied = readMemory(copies[i].src, copies[i].dst, copies[i].byteCount);
+        rememberReadResult(copies[i].src, copies[i].byteCount, bytesCopied);
+        copies[i].wasCopied = bytesCopied == copies[i].byteCount;
+    }
+    return count;
+}
+
+#else
+
+static volatile int g_procSelfMemFD = -1;
+static volatile bool g_canUseProcessVMReadv = true;
+
+/** Fallback for kernels without process_vm_readv(), or when it is blocked by
+ * a seccomp policy.
+ */
+static int readProcSelfMem(const void* const src, void* const dst, const int byteCount)
+{
+    int fd = g_procSelfMemFD;
+    if(fd < 0)
+    {
+        fd = open("/proc/self/mem", O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            return 0;
+        }
+        g_procSelfMemFD = fd;
+    }
+    ssize_t bytesCopied = pread(fd, dst, (size_t)byteCount, (off_t)(uintptr_t)src);
+    return bytesCopied < 0 ? 0 : (int)bytesCopied;
+}
+
+/** Read several regions with a single process_vm_readv() call.
+ *
+ * @return The number of bytes copied, or -1 if the call is unavailable.
+ */
+static ssize_t processVMReadv(struct iovec* const local, struct iovec* const remote, const int count)
+{
+    if(!g_canUseProcessVMReadv)
+    {
+        return -1;
+    }
+    ssize_t bytesCopied = process_vm_readv(getpid(), local, (unsigned long)count, remote, (unsigned long)count, 0);
+    if(bytesCopied < 0)
+    {
+        if(errno == ENOSYS || errno == EPERM)
+        {
+            g_canUseProcessVMReadv = false;
+            return -1;
+        }
+        return 0;
+    }
+    return bytesCopied;
+}
+
+static inline int readMemory(const void* const src, void* const dst, const int byteCount)
+{
+    const int savedErrno = errno;
+    struct iovec local = {.iov_base = dst, .iov_len = (size_t)byteCount};
+    struct iovec remote = {.iov_base = (void*)src, .iov_len = (size_t)byteCount};
+    ssize_t bytesCopied = processVMReadv(&local, &remote, 1);
+    if(bytesCopied < 0)
+    {
+        bytesCopied = readProcSelfMem(src, dst, byteCount);
+    }
+    errno = savedErrno;
+    return (int)bytesCopied;
+}
+
+/** Read the leading entries of a batch with one system call.
+ *
+ * The kernel stops at the first region it cannot read, and never splits a
+ * region. Everything before that region was copied and the region itself
+ * failed; anything after it has to be retried by the caller.
+ *
+ * @return The number of entries that were resolved (copied or failed).
+ */
+static int readMemoryBatch(RollbarCrashMemoryCopy* const copies, const int count)
+{
+    const int savedErrno = errno;
+    const int batchSize = count < RollbarCrashMEM_MAX_BATCH_SIZE ? count : RollbarCrashMEM_MAX_BATCH_SIZE;
+    struct iovec local[RollbarCrashMEM_MAX_BATCH_SIZE];
+    struct iovec remote[RollbarCrashMEM_MAX_BATCH_SIZE];
+    for(int i = 0; i < batchSize; i++)
+    {
+        local[i].iov_base = copies[i].dst;
+        local[i].iov_len = (size_t)copies[i].byteCount;
+        remote[i].iov_base = (void*)copies[i].src;
+        remote[i].iov_len = (size_t)copies[i].byteCount;
+    }
+    ssize_t bytesRemaining = processVMReadv(local, remote, batchSize);
+    errno = savedErrno;
+    if(bytesRemaining < 0)
+    {
+        copies[0].wasCopied = readMemory(copies[0].src, copies[0].dst, copies[0].byteCount) == copies[0].byteCount;
+        rememberReadResult(copies[0].src, copies[0].byteCount, copies[0].wasCopied ? copies[0].byteCount : 0);
+        return 1;
+    }
+
+    int resolved = 0;
+    while(resolved < batchSize)
+    {
+        RollbarCrashMemoryCopy* copy = &copies[resolved++];
+        if(bytesRemaining >= copy->byteCount)
+        {
+            bytesRemaining -= copy->byteCount;
+            copy->wasCopied = true;
+            rememberReadResult(copy->src, copy->byteCount, copy->byteCount);
+        }
+        else
+        {
+            copy->wasCopied = false;
+            rememberReadResult(copy->src, copy->byteCount, 0);
+            break;
+        }
+    }
+    return resolved;
+}
+
+#endif
+
+
+// ============================================================================
+#pragma mark - Copying -
+// ============================================================================
+
+static inline int copySafely(const void* restrict const src, void* restrict const dst, const int byteCount)
+{
+    switch(getRangeState(src, byteCount))
+    {
+        case PageStateReadable:
+            memcpy(dst, src, (size_t)byteCount);
+            return byteCount;
+        case PageStateUnreadable:
+            return 0;
+        default:
+            break;
+    }
+    int bytesCopied = readMemory(src, dst, byteCount);
+    rememberReadResult(src, byteCount, bytesCopied);
+    return bytesCopied;
+}
+
+static int copySafelyBatch(RollbarCrashMemoryCopy* const copies, const int count)
+{
+    RollbarCrashMemoryCopy* pending[RollbarCrashMEM_MAX_BATCH_SIZE];
+    RollbarCrashMemoryCopy uncached[RollbarCrashMEM_MAX_BATCH_SIZE];
+    int copiedCount = 0;
+    int next = 0;
+
+    while(next < count)
+    {
+        // Satisfy what we can from the page cache, and collect the rest.
+        int pendingCount = 0;
+        for(; next < count && pendingCount < RollbarCrashMEM_MAX_BATCH_SIZE; next++)
+        {
+            RollbarCrashMemoryCopy* copy = &copies[next];
+            copy->wasCopied = false;
+            if(copy->byteCount <= 0)
+            {
+                continue;
+            }
+            switch(getRangeState(copy->src, copy->byteCount))
+            {
+                case PageStateReadable:
+                    memcpy(copy->dst, copy->src, (size_t)copy->byteCount);
+                    copy->wasCopied = true;
+                    copiedCount++;
+                    break;
+                case PageStateUnreadable:
+                    break;
+                default:
+                    uncached[pendingCount] = *copy;
+                    pending[pendingCount++] = copy;
+                    break;
+            }
+        }
+
+        for(int resolved = 0; resolved < pendingCount;)
+        {
+            resolved += readMemoryBatch(uncached + resolved, pendingCount - resolved);
+        }
+        for(int i = 0; i < pendingCount; i++)
+        {
+            pending[i]->wasCopied = uncached[i].wasCopied;
+            copiedCount += uncached[i].wasCopied ? 1 : 0;
+        }
+    }
+    return copiedCount;
+}
+
 static inline int copyMaxPossible(const void* restrict const src, void* restrict const dst, const int byteCount)
 {
     const uint8_t* pSrc = src;
@@ -144,5 +488,10 @@ int rcmem_copyMaxPossible(const void* restrict const src, void* restrict const d
 
 bool rcmem_copySafely(const void* restrict const src, void* restrict const dst, const int byteCount)
 {
-    return copySafely(src, dst, byteCount);
+    return copySafely(src, dst, byteCount) == byteCount;
+}
+
+int rcmem_copySafelyBatch(RollbarCrashMemoryCopy* const copies, const int count)
+{
+    return copySafelyBatch(copies, count);
 }
@@ -25,7 +25,11 @@
 //
 
 
-/* Utility functions for querying the mach kernel.
+/* Utility functions for safely reading memory that may not be mapped.
+ *
+ * Reads go through vm_read_overwrite() on Apple platforms and through
+ * process_vm_readv() (or /proc/self/mem) on Linux, so a bad address results
+ * in a failed copy rather than a fault.
  */
 
 
@@ -40,6 +44,20 @@ extern "C" {
 #include <stdbool.h>
 
 
+/** One entry in a batch passed to rcmem_copySafelyBatch(). */
+typedef struct
+{
+    /** The source location to copy from. */
+    const void* src;
+    /** The location to copy to. */
+    void* dst;
+    /** The number of bytes to copy. */
+    int byteCount;
+    /** Set to true if all bytes were copied. */
+    bool wasCopied;
+} RollbarCrashMemoryCopy;
+
+
 /** Test if the specified memory is safe to read from.
  *
  * @param memory A pointer to the memory to test.
@@ -84,6 +102,29 @@ bool rcmem_copySafely(const void* restrict const src, void* restrict const dst,
  */
 int rcmem_copyMaxPossible(const void* restrict const src, void* restrict const dst, int byteCount);
 
+/** Copy many independent regions safely, using as few system calls as the
+ * platform allows. Each entry succeeds or fails on its own.
+ *
+ * @param copies The regions to copy. wasCopied is filled in for each entry.
+ *
+ * @param count The number of entries in copies.
+ *
+ * @return The number of entries that were copied successfully.
+ */
+int rcmem_copySafelyBatch(RollbarCrashMemoryCopy* const copies, int count);
+
+/** Start remembering which pages are readable and which are not, so repeated
+ * probes of the same pages don't need a system call each time.
+ *
+ * Pages remembered as readable are read directly, so this must only be
+ * enabled while the address space cannot change underneath us, e.g. while
+ * all other threads are suspended for crash handling.
+ */
+void rcmem_enablePageCache(void);
+
+/** Stop using and forget everything in the page cache. */
+void rcmem_disablePageCache(void);
+
 #ifdef __cplusplus
 }
 #endif
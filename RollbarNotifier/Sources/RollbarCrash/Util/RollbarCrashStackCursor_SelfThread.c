@@ -26,12 +26,20 @@
 #include "RollbarCrashStackCursor_SelfThread.h"
 #include "RollbarCrashStackCursor_Backtrace.h"
 #include <execinfo.h>
+#include <pthread.h>
 
 //#define RollbarCrashLogger_LocalLevel TRACE
 #include "RollbarCrashLogger.h"
 
 #define MAX_BACKTRACE_LENGTH (RollbarCrashSC_CONTEXT_SIZE - sizeof(RollbarCrashStackCursor_Backtrace_Context) / sizeof(void*) - 1)
 
+/** The frame record that every frame-pointer-preserving function pushes. */
+typedef struct FrameEntry
+{
+    const struct FrameEntry* previous;
+    uintptr_t returnAddress;
+} FrameEntry;
+
 typedef struct
 {
     RollbarCrashStackCursor_Backtrace_Context SelfThreadContextSpacer;
@@ -44,3 +52,44 @@ void rcsc_initSelfThread(RollbarCrashStackCursor *cursor, int skipEntries)
     int backtraceLength = backtrace((void**)context->backtrace, MAX_BACKTRACE_LENGTH);
     rcsc_initWithBacktrace(cursor, context->backtrace, backtraceLength, skipEntries + 1);
 }
+
+__attribute__((noinline))
+int rcsc_captureFramePointers(uintptr_t* backtrace, int maxLength, int skipEntries)
+{
+#if defined(__APPLE__)
+    pthread_t self = pthread_self();
+    uintptr_t stackHigh = (uintptr_t)pthread_get_stackaddr_np(self);
+    uintptr_t stackLow = stackHigh - pthread_get_stacksize_np(self);
+#else
+    uintptr_t stackLow = 0;
+    uintptr_t stackHigh = UINTPTR_MAX;
+#endif
+    int length = 0;
+    const FrameEntry* frame = (const FrameEntry*)__builtin_frame_address(0);
+    while(length < maxLength)
+    {
+        uintptr_t address = (uintptr_t)frame;
+        if(address < stackLow ||
+           address > stackHigh - sizeof(*frame) ||
+           (address & (sizeof(uintptr_t) - 1)) != 0 ||
+           frame->returnAddress == 0)
+        {
+            break;
+        }
+        if(skipEntries > 0)
+        {
+            skipEntries--;
+        }
+        else
+        {
+            backtrace[length++] = frame->returnAddress;
+        }
+        // Callers always live higher up the stack. Anything else is a corrupt chain.
+        if(frame->previous <= frame)
+        {
+            break;
+        }
+        frame = frame->previous;
+    }
+    return length;
+}
@@ -42,6 +42,20 @@ extern "C" {
  * @param skipEntries The number of stack entries to skip.
  */
 void rcsc_initSelfThread(RollbarCrashStackCursor *cursor, int skipEntries);
+
+/** Capture the current thread's return addresses by walking its frame pointers.
+ *  This is much cheaper than backtrace(), but frames that omit the frame pointer
+ *  are skipped over. The first entry is the caller of this function.
+ *
+ * @param backtrace The buffer to fill.
+ *
+ * @param maxLength The capacity of the buffer.
+ *
+ * @param skipEntries The number of stack entries to skip.
+ *
+ * @return The number of entries written.
+ */
+int rcsc_captureFramePointers(uintptr_t* backtrace, int maxLength, int skipEntries);
     
     
 #ifdef __cplusplus
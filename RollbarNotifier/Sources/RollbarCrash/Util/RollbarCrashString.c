@@ -30,6 +30,12 @@
 #include <stdlib.h>
 #include "RollbarCrashSystemCapabilities.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 
 // Compiler hints for "if" statements
 #define likely_if(x) if(__builtin_expect(x,1))
@@ -59,6 +65,53 @@ static const int g_continuationByteCount[0x40] =
     3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 0, 0,
 };
 
+/** Number of bytes examined at once by the ASCII fast path. */
+#define RollbarCrashSTRING_BLOCK_SIZE 16
+
+/** Check if a block is made up only of bytes the scalar loop would accept
+ * without further thought: printable ASCII, tab, CR and LF. Anything else
+ * (NUL, control characters, multi-byte UTF-8) makes this return false, and
+ * the caller falls back to checking the block byte by byte.
+ *
+ * Only loads from ptr, and uses no library calls, so it is async-safe.
+ */
+static inline bool isPlainASCIIBlock(const unsigned char* const ptr)
+{
+#if defined(__SSE2__)
+    const __m128i block = _mm_loadu_si128((const __m128i*)ptr);
+    // A signed compare catches both control characters and bytes >= 0x80.
+    const __m128i special = _mm_cmplt_epi8(block, _mm_set1_epi8(0x20));
+    const __m128i allowed = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')),
+                                         _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                                                      _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+    return _mm_movemask_epi8(_mm_andnot_si128(allowed, special)) == 0;
+#elif defined(__aarch64__)
+    const uint8x16_t block = vld1q_u8(ptr);
+    // Bytes outside 0x20-0x7f wrap around to >= 0x60 after subtracting 0x20.
+    const uint8x16_t special = vcgeq_u8(vsubq_u8(block, vdupq_n_u8(0x20)), vdupq_n_u8(0x60));
+    const uint8x16_t allowed = vorrq_u8(vceqq_u8(block, vdupq_n_u8('\t')),
+                                        vorrq_u8(vceqq_u8(block, vdupq_n_u8('\n')),
+                                                 vceqq_u8(block, vdupq_n_u8('\r'))));
+    return vmaxvq_u8(vbicq_u8(special, allowed)) == 0;
+#else
+    // SWAR: flag any byte with the high bit set or a value below 0x20.
+    // This is conservative about tab, CR and LF, which the scalar path handles.
+    uint64_t words[2];
+    memcpy(words, ptr, sizeof(words));
+    const uint64_t highBits = 0x8080808080808080ULL;
+    const uint64_t below0x20 = 0x2020202020202020ULL;
+    for(int i = 0; i < 2; i++)
+    {
+        const uint64_t word = words[i];
+        if(((word | ((word - below0x20) & ~word)) & highBits) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
 bool rcstring_isNullTerminatedUTF8String(const void* memory,
                                         int minLength,
                                         int maxLength)
@@ -66,36 +119,48 @@ bool rcstring_isNullTerminatedUTF8String(const void* memory,
     const unsigned char* ptr = memory;
     const unsigned char* const end = ptr + maxLength;
 
-    for(; ptr < end; ptr++)
+    while(ptr < end)
     {
-        unsigned char ch = *ptr;
-        unlikely_if(ch == 0)
+        // Skip plain ASCII a block at a time.
+        while(end - ptr >= RollbarCrashSTRING_BLOCK_SIZE && isPlainASCIIBlock(ptr))
         {
-            return (ptr - (const unsigned char*)memory) >= minLength;
+            ptr += RollbarCrashSTRING_BLOCK_SIZE;
         }
-        unlikely_if(ch & 0x80)
+
+        // Something in the next block needs a closer look, so go through it
+        // one character at a time before trying the fast path again.
+        const unsigned char* scalarEnd = end - ptr > RollbarCrashSTRING_BLOCK_SIZE ? ptr + RollbarCrashSTRING_BLOCK_SIZE : end;
+        for(; ptr < scalarEnd; ptr++)
         {
-            unlikely_if((ch & 0xc0) != 0xc0)
+            unsigned char ch = *ptr;
+            unlikely_if(ch == 0)
             {
-                return false;
-            }
-            int continuationBytes = g_continuationByteCount[ch & 0x3f];
-            unlikely_if(continuationBytes == 0 || ptr + continuationBytes >= end)
-            {
-                return false;
+                return (ptr - (const unsigned char*)memory) >= minLength;
             }
-            for(int i = 0; i < continuationBytes; i++)
+            unlikely_if(ch & 0x80)
             {
-                ptr++;
-                unlikely_if((*ptr & 0xc0) != 0x80)
+                unlikely_if((ch & 0xc0) != 0xc0)
                 {
                     return false;
                 }
+                int continuationBytes = g_continuationByteCount[ch & 0x3f];
+                unlikely_if(continuationBytes == 0 || ptr + continuationBytes >= end)
+                {
+                    return false;
+                }
+                for(int i = 0; i < continuationBytes; i++)
+                {
+                    ptr++;
+                    unlikely_if((*ptr & 0xc0) != 0x80)
+                    {
+                        return false;
+                    }
+                }
+            }
+            else unlikely_if(ch < 0x20 && !g_printableControlChars[ch])
+            {
+                return false;
             }
-        }
-        else unlikely_if(ch < 0x20 && !g_printableControlChars[ch])
-        {
-            return false;
         }
     }
     return false;
@@ -89,6 +89,18 @@ void rc_setUserInfoJSON(const char* const userInfoJSON);
  */
 void rc_setDeadlockWatchdogInterval(double deadlockWatchdogInterval);
 
+/** If greater than 0, profile main thread stalls longer than this many seconds.
+ * While a stall lasts, the main thread's stack is sampled every 10ms. When it
+ * ends, a non-fatal "MainThreadHang" report is written containing the sampled
+ * stacks in folded form ("root;...;leaf count"), so that UI hitches show up
+ * and not only full deadlocks. Requires the deadlock monitor.
+ *
+ * 0 = Disabled.
+ *
+ * Default: 0
+ */
+void rc_setHangProfilingThreshold(double hangProfilingThreshold);
+
 /** If true, attempt to fetch dispatch queue names for each running thread.
  *
  * WARNING: There is a chance that this will crash on a rcthread_getQueueName() call!
@@ -108,6 +120,26 @@ void rc_setSearchQueueNames(bool searchQueueNames);
  */
 void rc_setIntrospectMemory(bool introspectMemory);
 
+/** Set how many deallocated objects the zombie monitor remembers.
+ * Must be called before the zombie monitor is enabled.
+ * Memory is taken in 64 byte sets of 3 objects, rounded up to a power of two
+ * number of sets: the default takes 512 KiB, 65536 objects take 2 MiB.
+ *
+ * 0 = Use the default.
+ *
+ * Default: 24576
+ */
+void rc_setZombieCacheSize(int zombieCacheSize);
+
+/** Debugging aid: trap if the thread handling a crash calls malloc.
+ * Crash handling must not allocate, since the heap may be corrupt or locked.
+ * Only available on Apple platforms, and only covers the default malloc zone:
+ * allocations from other zones are not trapped.
+ *
+ * Default: false
+ */
+void rc_setTrapsAllocationsDuringCrashHandling(bool trapsAllocations);
+
 /** List of Objective-C classes that should never be introspected.
  * Whenever a class in this list is encountered, only the class name will be recorded.
  * This can be useful for information security concerns.
@@ -159,6 +191,14 @@ void rc_setPrintPreviousLog(bool shouldPrintPreviousLog);
  */
 void rc_setMaxReportCount(int maxReportCount);
 
+/** If true, non-fatal user exceptions that don't log all threads are captured
+ * cheaply: only the calling thread's backtrace is taken, no threads are suspended,
+ * and the report is written on a background thread after the call returns.
+ *
+ * Default: false
+ */
+void rc_setDeferUserReports(bool deferUserReports);
+
 /** Report a custom, user defined exception.
  * This can be useful when dealing with scripting languages.
  *
@@ -195,6 +235,17 @@ void rc_reportUserException(const char* name,
  * Also allows a user to override original __cxa_throw  with his implementation.
  */
 void enableSwapCxaThrow(void);
+
+/** Choose which C++ throws capture their stack.
+ * Code that throws and catches in hot loops can sample or skip throw-time capture.
+ *
+ * 1 = Capture every throw.
+ * N > 1 = Capture 1 in N throws on each thread.
+ * 0 = Only capture when an uncaught exception reaches terminate.
+ *
+ * Default: 1
+ */
+void rc_setCPPExceptionStackCaptureInterval(int interval);
     
 #pragma mark -- Notifications --
 
@@ -239,6 +290,17 @@ int rc_getReportCount(void);
  */
 int rc_getReportIDs(int64_t* reportIDs, int count);
 
+/** Get a page of report IDs, in ascending order, that come after a given ID.
+ * Pass the last ID of the previous page to fetch the next page.
+ *
+ * @param afterID Only IDs greater than this are returned (0 = from the start).
+ * @param reportIDs An array to hold the report IDs.
+ * @param count How many reports the array can hold.
+ *
+ * @return The number of report IDs that were placed in the array.
+ */
+int rc_getReportIDsAfter(int64_t afterID, int64_t* reportIDs, int count);
+
 /** Read a report.
  *
  * @param reportID The report's ID.
@@ -31,6 +31,8 @@
 #import "RollbarCrashReportFilter.h"
 #import "RollbarCrashMonitorType.h"
 
+@class RollbarCrashReportEnumerator;
+
 typedef enum
 {
     RollbarCrashDeleteNever,
@@ -99,6 +101,18 @@ typedef enum
  */
 @property(nonatomic,readwrite,assign) double deadlockWatchdogInterval;
 
+/** If greater than 0, profile main thread stalls longer than this many seconds.
+ * While a stall lasts, the main thread's stack is sampled every 10ms. When it
+ * ends, a non-fatal "MainThreadHang" report is written containing the sampled
+ * stacks in folded form ("root;...;leaf count"), so that UI hitches show up
+ * and not only full deadlocks. Requires the deadlock monitor.
+ *
+ * 0 = Disabled.
+ *
+ * Default: 0
+ */
+@property(nonatomic,readwrite,assign) double hangProfilingThreshold;
+
 /** If YES, attempt to fetch dispatch queue names for each running thread.
  *
  * WARNING: There is a chance that this will crash on a rcthread_getQueueName() call!
@@ -125,6 +139,16 @@ typedef enum
  */
 @property(nonatomic,readwrite,assign) BOOL catchZombies;
 
+/** How many deallocated objects to remember when catching zombies.
+ * Larger caches catch zombies that were freed longer ago, at the cost of
+ * 64 bytes of memory per 3 objects, rounded up to a power of two number of
+ * sets: the default takes 512 KiB, 65536 objects take 2 MiB.
+ * Must be set before enabling catchZombies.
+ *
+ * Default: 24576
+ */
+@property(nonatomic,readwrite,assign) int zombieCacheSize;
+
 /** List of Objective-C classes that should never be introspected.
  * Whenever a class in this list is encountered, only the class name will be recorded.
  * This can be useful for information security concerns.
@@ -139,6 +163,33 @@ typedef enum
  */
 @property(nonatomic,readwrite,assign) int maxReportCount;
 
+/** If true, non-fatal user exceptions that don't log all threads are captured
+ * cheaply: only the calling thread's backtrace is taken, no threads are suspended,
+ * and the report is written on a background thread after the call returns.
+ *
+ * Default: NO
+ */
+@property(nonatomic,readwrite,assign) BOOL deferUserReports;
+
+/** Choose which C++ throws capture their stack.
+ * Code that throws and catches in hot loops can sample or skip throw-time capture.
+ *
+ * 1 = Capture every throw.
+ * N > 1 = Capture 1 in N throws on each thread.
+ * 0 = Only capture when an uncaught exception reaches terminate.
+ *
+ * Default: 1
+ */
+@property(nonatomic,readwrite,assign) int cppExceptionStackCaptureInterval;
+
+/** How many reports sendAllReportsWithCompletion: decodes and passes to the
+ * sink at a time. Only one page of reports is held in memory, so a large
+ * backlog doesn't grow memory use.
+ *
+ * Default: 10
+ */
+@property(nonatomic,readwrite,assign) int reportPageSize;
+
 /** The report sink where reports get sent.
  * This MUST be set or else the reporter will not send reports (although it will
  * still record them).
@@ -225,13 +276,26 @@ typedef enum
  * deleted. Once the reports are successfully sent to the server, they may be
  * deleted locally, depending on the property "deleteAfterSendAll".
  *
+ * Reports are sent oldest first, "reportPageSize" at a time. Sending stops at
+ * the first page that the sink fails to complete.
+ *
  * Note: property "sink" MUST be set or else this method will call onCompletion
  *       with an error.
  *
  * @param onCompletion Called when sending is complete (nil = ignore).
+ *                     "filteredReports" holds the sink's output for the last
+ *                     page sent.
  */
 - (void) sendAllReportsWithCompletion:(RollbarCrashReportFilterCompletion) onCompletion;
 
+/** Get an enumerator over all unsent reports, oldest first.
+ *
+ * @param pageSize How many reports to decode at a time.
+ *
+ * @return An enumerator yielding report dictionaries.
+ */
+- (RollbarCrashReportEnumerator*) reportEnumeratorWithPageSize:(NSUInteger) pageSize;
+
 /** Get all unsent report IDs.
  *
  * @return An array with report IDs.
@@ -295,6 +359,34 @@ typedef enum
 @end
 
 
+/**
+ * Walks the stored reports oldest first, decoding them a page at a time.
+ * Only the current page is held in memory, so memory use doesn't depend on
+ * how many reports are on disk. Reports written after enumeration starts are
+ * included.
+ *
+ * Use nextObject to get one report at a time, or nextPage to get a page.
+ */
+@interface RollbarCrashReportEnumerator : NSEnumerator
+
+/** The maximum number of reports decoded at a time. */
+@property(nonatomic,readonly,assign) NSUInteger pageSize;
+
+/** The IDs of the reports in the page last read from the store, including any
+ * that could not be decoded.
+ */
+@property(nonatomic,readonly,retain) NSArray* lastPageReportIDs;
+
+/** Decode the next page of reports.
+ *
+ * @return Up to pageSize reports, or nil if there are no more. The array is
+ *         empty if none of the page's reports could be decoded.
+ */
+- (NSArray*) nextPage;
+
+@end
+
+
 //! Project version number for RollbarCrashFramework.
 FOUNDATION_EXPORT const double RollbarCrashFrameworkVersionNumber;
 
@@ -74,6 +74,17 @@ int rcmc_contextSize(void);
  */
 bool rcmc_getContextForThread(RollbarCrashThread thread, struct RollbarCrashMachineContext* destinationContext, bool isCrashedContext);
 
+/** Fill in a crashed context for a thread whose backtrace was captured earlier.
+ * The thread has moved on since, so no registers are read and the thread list
+ * holds only this thread.
+ *
+ * @param thread The thread that was captured.
+ * @param destinationContext The context to fill.
+ *
+ * @return true if successful.
+ */
+bool rcmc_getContextForCapturedThread(RollbarCrashThread thread, struct RollbarCrashMachineContext* destinationContext);
+
 /** Fill in a machine context from a signal handler.
  * A signal handler context is always assumed to be a crashed context.
  *
@@ -136,6 +136,11 @@ typedef struct RollbarCrash_MonitorContext
         
         /** The user-supplied JSON encoded stack trace. */
         const char* customStackTrace;
+
+        /** If true, the report is being written in the background after the
+         * reporting call has already returned.
+         */
+        bool isDeferred;
     } userException;
 
     struct
@@ -52,6 +52,14 @@ typedef void(^RollbarCrashReportFilterCompletion)(NSArray* filteredReports, BOOL
 - (void) filterReports:(NSArray*) reports
           onCompletion:(RollbarCrashReportFilterCompletion) onCompletion;
 
+@optional
+
+/** Whether filterReports:onCompletion: may run on several threads at once.
+ * Pipelines in concurrent mode call filters that return NO one call at a
+ * time. Filters that don't implement this are treated as thread-safe.
+ */
+- (BOOL) supportsConcurrentFiltering;
+
 @end
 
 
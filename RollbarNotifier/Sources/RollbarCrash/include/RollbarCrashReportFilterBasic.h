@@ -80,6 +80,26 @@
 /** The filters in this pipeline. */
 @property(nonatomic,readonly,retain) NSArray* filters;
 
+/** If greater than 1, each report goes through the filter chain on its own,
+ * with up to this many reports in flight at once on a worker pool. Reports
+ * beyond that wait for a free slot.
+ *
+ * Output is returned in input order. A report that a filter fails to complete
+ * is dropped, the other reports are still processed, and the completion gets
+ * completed = NO along with the first report's error.
+ *
+ * Default: 1 (all reports pass through each filter together, in sequence)
+ */
+@property(atomic,readwrite,assign) NSUInteger maxConcurrentReports;
+
+/** Total time spent in each filter, in seconds (NSNumber), in filter order.
+ * Time is measured from calling a filter until it calls its completion.
+ */
+@property(nonatomic,readonly,retain) NSArray* filterDurations;
+
+/** Number of times each filter was called (NSNumber), in filter order. */
+@property(nonatomic,readonly,retain) NSArray* filterCallCounts;
+
 /** Constructor.
  *
  * @param firstFilter The first filter, followed by filter, filter, ...
@@ -94,6 +114,9 @@
 
 - (void) addFilter:(id<RollbarCrashReportFilter>) filter;
 
+/** Reset filterDurations and filterCallCounts to zero. */
+- (void) resetFilterTimings;
+
 @end
 
 
@@ -49,6 +49,12 @@ static NSString *const DFK_CUSTOM = @"custom";
 
 #pragma mark - class implementation
 
+@interface RollbarConfig () {
+  @private
+  NSString *_serializedJSONString;
+}
+@end
+
 @implementation RollbarConfig
 
 #pragma mark - factory methods
@@ -248,6 +254,22 @@ static NSString *const DFK_CUSTOM = @"custom";
 
 #pragma mark - overrides
 
+- (nullable NSString *)serializeToJSONString {
+
+  // every payload is stored along with its config, so immutable configs
+  // only get serialized once:
+  if ([self isKindOfClass:[RollbarMutableConfig class]]) {
+    return [super serializeToJSONString];
+  }
+
+  @synchronized(self) {
+    if (!_serializedJSONString) {
+      _serializedJSONString = [super serializeToJSONString];
+    }
+    return _serializedJSONString;
+  }
+}
+
 - (nonnull RollbarMutableConfig *)mutableCopy {
 
   return [self mutableCopyWithZone:nil];
@@ -9,6 +9,12 @@ static BOOL const DEFAULT_SUPPRESS_SDK_INFO_LOGGING_FLAG = YES;
 static BOOL const DEFAULT_LOG_INCOMING_PAYLOADS_FLAG = NO;
 static BOOL const DEFAULT_LOG_TRANSMITTED_PAYLOADS_FLAG = NO;
 static BOOL const DEFAULT_LOG_DROPPED_PAYLOADS_FLAG = NO;
+static RollbarPayloadStoreDurability const DEFAULT_PAYLOAD_STORE_DURABILITY = RollbarPayloadStoreDurability_Normal;
+static NSUInteger const DEFAULT_PAYLOAD_STORE_COMMIT_BATCH_SIZE = 32;
+static NSTimeInterval const DEFAULT_PAYLOAD_STORE_COMMIT_INTERVAL = 0.005;
+static NSUInteger const DEFAULT_MAXIMUM_REQUESTS_IN_FLIGHT = 4;
+static BOOL const DEFAULT_COMPRESS_PAYLOADS_FLAG = NO;
+static NSUInteger const DEFAULT_PAYLOAD_COMPRESSION_THRESHOLD = 1024;
 
 #pragma mark - data field keys
 
@@ -23,6 +29,13 @@ static NSString * const DFK_LOG_TRANSMITTED_PAYLOADS_FILE = @"logTransmittedPayl
 static NSString * const DFK_LOG_DROPPED_PAYLOADS = @"logDroppedPayloads";
 static NSString * const DFK_LOG_DROPPED_PAYLOADS_FILE = @"logDroppedPayloadsFile";
 
+static NSString * const DFK_PAYLOAD_STORE_DURABILITY = @"payloadStoreDurability";
+static NSString * const DFK_PAYLOAD_STORE_COMMIT_BATCH_SIZE = @"payloadStoreCommitBatchSize";
+static NSString * const DFK_PAYLOAD_STORE_COMMIT_INTERVAL = @"payloadStoreCommitInterval";
+static NSString * const DFK_MAXIMUM_REQUESTS_IN_FLIGHT = @"maximumRequestsInFlight";
+static NSString * const DFK_COMPRESS_PAYLOADS = @"compressPayloads";
+static NSString * const DFK_PAYLOAD_COMPRESSION_THRESHOLD = @"payloadCompressionThreshold";
+
 #pragma mark - class implementation
 
 @implementation RollbarDeveloperOptions
@@ -129,6 +142,36 @@ static NSString * const DFK_LOG_DROPPED_PAYLOADS_FILE = @"logDroppedPayloadsFile
     return result;
 }
 
+- (RollbarPayloadStoreDurability)payloadStoreDurability {
+    return [self safelyGetIntegerByKey:DFK_PAYLOAD_STORE_DURABILITY
+                           withDefault:DEFAULT_PAYLOAD_STORE_DURABILITY];
+}
+
+- (NSUInteger)payloadStoreCommitBatchSize {
+    return [self safelyGetUIntegerByKey:DFK_PAYLOAD_STORE_COMMIT_BATCH_SIZE
+                            withDefault:DEFAULT_PAYLOAD_STORE_COMMIT_BATCH_SIZE];
+}
+
+- (NSTimeInterval)payloadStoreCommitInterval {
+    return [self safelyGetTimeIntervalByKey:DFK_PAYLOAD_STORE_COMMIT_INTERVAL
+                                withDefault:DEFAULT_PAYLOAD_STORE_COMMIT_INTERVAL];
+}
+
+- (NSUInteger)maximumRequestsInFlight {
+    return [self safelyGetUIntegerByKey:DFK_MAXIMUM_REQUESTS_IN_FLIGHT
+                            withDefault:DEFAULT_MAXIMUM_REQUESTS_IN_FLIGHT];
+}
+
+- (BOOL)compressPayloads {
+    return [self safelyGetBoolByKey:DFK_COMPRESS_PAYLOADS
+                        withDefault:DEFAULT_COMPRESS_PAYLOADS_FLAG];
+}
+
+- (NSUInteger)payloadCompressionThreshold {
+    return [self safelyGetUIntegerByKey:DFK_PAYLOAD_COMPRESSION_THRESHOLD
+                            withDefault:DEFAULT_PAYLOAD_COMPRESSION_THRESHOLD];
+}
+
 @end
 
 @implementation RollbarMutableDeveloperOptions
@@ -142,6 +185,12 @@ static NSString * const DFK_LOG_DROPPED_PAYLOADS_FILE = @"logDroppedPayloadsFile
 @dynamic transmittedPayloadsLogFile;
 @dynamic logDroppedPayloads;
 @dynamic droppedPayloadsLogFile;
+@dynamic payloadStoreDurability;
+@dynamic payloadStoreCommitBatchSize;
+@dynamic payloadStoreCommitInterval;
+@dynamic maximumRequestsInFlight;
+@dynamic compressPayloads;
+@dynamic payloadCompressionThreshold;
 
 #pragma mark - property accessors
 
@@ -181,4 +230,28 @@ static NSString * const DFK_LOG_DROPPED_PAYLOADS_FILE = @"logDroppedPayloadsFile
     [self setString:value forKey:DFK_LOG_DROPPED_PAYLOADS_FILE];
 }
 
+- (void)setPayloadStoreDurability:(RollbarPayloadStoreDurability)value {
+    [self setInteger:value forKey:DFK_PAYLOAD_STORE_DURABILITY];
+}
+
+- (void)setPayloadStoreCommitBatchSize:(NSUInteger)value {
+    [self setUInteger:value forKey:DFK_PAYLOAD_STORE_COMMIT_BATCH_SIZE];
+}
+
+- (void)setPayloadStoreCommitInterval:(NSTimeInterval)value {
+    [self setTimeInterval:value forKey:DFK_PAYLOAD_STORE_COMMIT_INTERVAL];
+}
+
+- (void)setMaximumRequestsInFlight:(NSUInteger)value {
+    [self setUInteger:value forKey:DFK_MAXIMUM_REQUESTS_IN_FLIGHT];
+}
+
+- (void)setCompressPayloads:(BOOL)value {
+    [self setBool:value forKey:DFK_COMPRESS_PAYLOADS];
+}
+
+- (void)setPayloadCompressionThreshold:(NSUInteger)value {
+    [self setUInteger:value forKey:DFK_PAYLOAD_COMPRESSION_THRESHOLD];
+}
+
 @end
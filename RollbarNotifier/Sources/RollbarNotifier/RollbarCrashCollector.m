@@ -45,6 +45,10 @@ NS_ASSUME_NONNULL_BEGIN
     rc_callCompletion(completion, reports, YES, nil);
 }
 
+- (BOOL)supportsConcurrentFiltering {
+    return NO;
+}
+
 @end
 
 #pragma mark -
@@ -88,7 +92,10 @@ NS_ASSUME_NONNULL_BEGIN
     id diagnose = [[RollbarCrashDiagnosticFilter alloc] init];
     id format = [[RollbarCrashFormattingFilter alloc] init];
     id log = [[RollbarCrashLoggingFilter alloc] init];
-    return [RollbarCrashReportFilterPipeline filterWithFilters:diagnose, format, log, nil];
+    RollbarCrashReportFilterPipeline *pipeline =
+        [RollbarCrashReportFilterPipeline filterWithFilters:diagnose, format, log, nil];
+    pipeline.maxConcurrentReports = NSProcessInfo.processInfo.activeProcessorCount;
+    return pipeline;
 }
 
 @end
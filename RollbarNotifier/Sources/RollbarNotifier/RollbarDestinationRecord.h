@@ -21,6 +21,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property (readwrite) NSUInteger localWindowLimit;
 
 @property (readonly) NSUInteger localWindowCount;
+@property (readonly) NSUInteger postsInFlightCount;
 @property (readonly) NSUInteger serverWindowRemainingCount;
 @property (readonly, nullable) NSDate *nextLocalWindowStart;
 @property (readonly, nullable) NSDate *nextServerWindowStart;
@@ -29,6 +30,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property (readonly, nonnull) RollbarRegistry *registry;
 
 - (BOOL)canPostWithConfig:(nonnull RollbarConfig *)config;
+/// Counts a dispatched post against the local window until its reply is in.
+- (void)reservePost;
+/// Releases the slot of a post whose reply is in, to be followed by `recordPostReply:withConfig:`.
+- (void)releasePost;
 - (void)recordPostReply:(nullable RollbarPayloadPostReply *)reply
              withConfig:(nonnull RollbarConfig *)config;
 
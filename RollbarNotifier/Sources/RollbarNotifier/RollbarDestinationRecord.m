@@ -28,6 +28,7 @@
         self->_destinationID = [RollbarRegistry destinationID:config.destination];
         self->_localWindowLimit = config.loggingOptions.maximumReportsPerMinute;
         self->_localWindowCount = 0;
+        self->_postsInFlightCount = 0;
         self->_serverWindowRemainingCount = 0;
         self->_nextLocalWindowStart = nil;
         self->_nextServerWindowStart = nil;
@@ -45,6 +46,7 @@
         self->_destinationID = destinationID;
         self->_localWindowLimit = 0;
         self->_localWindowCount = 0;
+        self->_postsInFlightCount = 0;
         self->_serverWindowRemainingCount = 0;
         self->_nextLocalWindowStart = nil;
         self->_nextServerWindowStart = nil;
@@ -56,7 +58,12 @@
 #pragma mark - methods
 
 - (BOOL)canPostWithConfig:(nonnull RollbarConfig *)config {
-    if (self->_nextLocalWindowStart && (self->_localWindowCount >= config.loggingOptions.maximumReportsPerMinute)) {
+    // posts still waiting for their reply count against the window their replies will land in:
+    BOOL isLocalWindowOpen = self->_nextLocalWindowStart
+        && ([self->_nextLocalWindowStart compare:[NSDate date]] == NSOrderedDescending);
+    NSUInteger localWindowCount = (isLocalWindowOpen ? self->_localWindowCount : 0) + self->_postsInFlightCount;
+    if ((isLocalWindowOpen || self->_postsInFlightCount > 0)
+        && (localWindowCount >= config.loggingOptions.maximumReportsPerMinute)) {
         // we already exceeded local rate limits, let's wait till the next local rate limiting window:
         //self->_nextEarliestPost = self->_nextLocalWindowStart;
         return NO;
@@ -75,6 +82,17 @@
     return shouldPost;
 }
 
+- (void)reservePost {
+    self->_postsInFlightCount += 1;
+}
+
+- (void)releasePost {
+    NSAssert(self->_postsInFlightCount > 0, @"No post in flight to release!");
+    if (self->_postsInFlightCount > 0) {
+        self->_postsInFlightCount -= 1;
+    }
+}
+
 - (void)recordPostReply:(nullable RollbarPayloadPostReply *)reply
              withConfig:(nonnull RollbarConfig *)config
 {
@@ -104,7 +122,8 @@
         case 429: // too many requests
             if (self.rateLimitBehavior == RollbarRateLimitBehavior_Queue) {
                 RBLog(@"\tQueuing record");
-                self->_nextLocalWindowStart = [NSDate dateWithTimeIntervalSinceNow:reply.remainingSeconds];
+                // the server's window is exhausted, let's wait for its next one:
+                self->_nextServerWindowStart = [NSDate dateWithTimeIntervalSinceNow:reply.remainingSeconds];
                 self->_serverWindowRemainingCount = 0;
                 break;
             }
@@ -116,12 +135,13 @@
             RBLog(@"\tDropping record");
             self->_nextServerWindowStart = [NSDate dateWithTimeIntervalSinceNow:reply.remainingSeconds];
             self->_serverWindowRemainingCount = reply.remainingCount;
-            if (self->_nextLocalWindowStart) {
+            if (!self->_nextLocalWindowStart
+                || ([self->_nextLocalWindowStart compare:[NSDate date]] != NSOrderedDescending)) {
+                // this post opens a new local rate limiting window:
                 self->_localWindowCount = 0;
                 self->_nextLocalWindowStart = [NSDate dateWithTimeIntervalSinceNow:60];
-            } else {
-                self->_localWindowCount += 1;
             }
+            self->_localWindowCount += 1;
             break;
     }
 
@@ -151,6 +171,7 @@
                              "   destinationID:              %@\n"
                              "   localWindowLimit:           %lu\n"
                              "   localWindowCount:           %lu\n"
+                             "   postsInFlightCount:         %lu\n"
                              "   serverWindowRemainingCount: %lu\n"
                              "   nextLocalWindowStart:       %@\n"
                              "   nextServerWindowStart:      %@\n"
@@ -160,6 +181,7 @@
                              self->_destinationID,
                              (unsigned long)self->_localWindowLimit,
                              (unsigned long)self->_localWindowCount,
+                             (unsigned long)self->_postsInFlightCount,
                              (unsigned long)self->_serverWindowRemainingCount,
                              self->_nextLocalWindowStart,
                              self->_nextServerWindowStart,
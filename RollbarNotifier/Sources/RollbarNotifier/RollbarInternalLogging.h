@@ -3,6 +3,9 @@
 
 @import Foundation;
 
+// This is for internal usage only
+BOOL RBLogEnabled(void);
+
 // This is for internal usage only
 void RBLog(NSString *format, ...);
 
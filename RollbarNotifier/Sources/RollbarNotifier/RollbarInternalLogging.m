@@ -1,9 +1,17 @@
 #import "RollbarInternalLogging.h"
 #import "RollbarInfrastructure.h"
 
+BOOL RBLogEnabled(void) {
+#ifdef DEBUG
+    return !RollbarInfrastructure.sharedInstance.configuration.developerOptions.suppressSdkInfoLogging;
+#else
+    return NO;
+#endif
+}
+
 void RBLog(NSString *format, ...) {
 #ifdef DEBUG
-    if (RollbarInfrastructure.sharedInstance.configuration.developerOptions.suppressSdkInfoLogging) {
+    if (!RBLogEnabled()) {
         return;
     }
 
@@ -17,7 +25,7 @@ void RBLog(NSString *format, ...) {
 
 void RBErr(NSString *format, ...) {
 #ifdef DEBUG
-    if (RollbarInfrastructure.sharedInstance.configuration.developerOptions.suppressSdkInfoLogging) {
+    if (!RBLogEnabled()) {
         return;
     }
 
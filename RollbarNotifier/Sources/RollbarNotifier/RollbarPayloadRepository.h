@@ -8,6 +8,7 @@
 #import <Foundation/Foundation.h>
 
 #import "RollbarPayload.h"
+#import "RollbarDeveloperOptions.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -21,6 +22,8 @@ NS_ASSUME_NONNULL_BEGIN
 + (instancetype)inMemoryRepository;
 + (instancetype)persistentRepository;
 + (instancetype)persistentRepositoryWithPath:(nonnull NSString *)storePath;
++ (instancetype)persistentRepositoryWithPath:(nonnull NSString *)storePath
+                                  durability:(RollbarPayloadStoreDurability)durability;
 
 #pragma mark - instantiation blocking
 
@@ -54,42 +57,86 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Payloads related methods
 
-- (nullable NSDictionary<NSString *, NSString *> *)addPayload:(nonnull NSString *)payload
-                                                   withConfig:(nonnull NSString *)config
-                                             andDestinationID:(nonnull NSString *)destinationID;
+- (nullable NSDictionary<NSString *, id> *)addPayload:(nonnull NSString *)payload
+                                           withConfig:(nonnull NSString *)config
+                                     andDestinationID:(nonnull NSString *)destinationID;
 
-- (nullable NSDictionary<NSString *, NSString *> *)getPayloadByID:(nonnull NSString *)payloadID;
+/// Queues a payload as the exact bytes to post.
+/// Its row's "payload_json" comes back as data, while payloads added as strings come back as strings.
+- (nullable NSDictionary<NSString *, id> *)addPayloadData:(nonnull NSData *)payloadData
+                                               withConfig:(nonnull NSString *)config
+                                         andDestinationID:(nonnull NSString *)destinationID;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getAllPayloadsWithDestinationID:(nonnull NSString *)destinationID;
+- (nullable NSDictionary<NSString *, id> *)getPayloadByID:(nonnull NSString *)payloadID;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
-                                                                                 andLimit:(NSUInteger)limit;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getAllPayloadsWithDestinationID:(nonnull NSString *)destinationID;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
-                                                                                andOffset:(NSUInteger)offset
-                                                                                 andLimit:(NSUInteger)limit;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                           andLimit:(NSUInteger)limit;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithLimit:(NSUInteger)limit;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                          andOffset:(NSUInteger)offset
+                                                                           andLimit:(NSUInteger)limit;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithOffset:(NSUInteger)offset
-                                                                          andLimit:(NSUInteger)limit;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithLimit:(NSUInteger)limit;
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getAllPayloads;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithOffset:(NSUInteger)offset
+                                                                    andLimit:(NSUInteger)limit;
 
+/// Returns up to `limit` payloads of a destination queued after the given one, oldest first.
+/// Unlike offsets, this keeps paging through a long queue cheap: pass "0" to start from its head.
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                            afterID:(nonnull NSString *)payloadID
+                                                                           andLimit:(NSUInteger)limit;
+
+/// Returns up to `limit` payloads queued after the given one, oldest first.
+/// Pass "0" to start from the head of the queue.
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsAfterID:(nonnull NSString *)payloadID
+                                                                 andLimit:(NSUInteger)limit;
+
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getAllPayloads;
+
+/// Returns the number of queued payloads.
+/// It's counted when first needed and then kept up to date in memory, assuming this
+/// repository is the only writer of its store.
 - (NSInteger)getPayloadCount;
 
+/// Returns the number of payloads queued for a destination.
+- (NSInteger)getPayloadCountWithDestinationID:(nonnull NSString *)destinationID;
+
 - (BOOL)removePayloadByID:(nonnull NSString *)payloadID;
 
 - (BOOL)removePayloadsOlderThan:(nonnull NSDate *)cutoffTime;
 
 - (BOOL)removeAllPayloads;
 
+#pragma mark - Configs related methods
+
+- (nullable NSNumber *)getIDofConfig:(nonnull NSString *)config;
+
+- (BOOL)removeUnusedConfigs;
+
+#pragma mark - Group commit
+
+/// The maximum number of payload writes grouped into a single transaction.
+/// 0 or 1 (the default) commits every write on its own.
+@property (nonatomic) NSUInteger groupCommitSize;
+
+/// Flags whether there are payload writes waiting for their group to be committed.
+@property (nonatomic, readonly) BOOL hasPendingWrites;
+
+/// Commits the current group of payload writes, if any.
+/// This is the barrier to call before shutting down.
+- (BOOL)flush;
+
 #pragma mark - unit testing helper methods
 
 - (BOOL)checkIfTableExists_Destinations;
 
 - (BOOL)checkIfTableExists_Payloads;
 
+- (BOOL)checkIfTableExists_Configs;
+
 - (BOOL)checkIfTableExists_Unknown;
 
 - (BOOL)clearDestinations;
@@ -5,6 +5,7 @@
 @import RollbarCommon;
 
 #import <sqlite3.h>
+#import <CommonCrypto/CommonDigest.h>
 
 //======================================================================================================================
 #pragma mark - Sqlite command execution callbacks
@@ -31,51 +32,160 @@ static int checkIfTableExistsCallback(void *info, int columns, char **data, char
     return SQLITE_OK;
 }
 
-static int selectSingleRowCallback(void *info, int columns, char **data, char **column)
+//======================================================================================================================
+#pragma mark - Prepared statements
+#pragma mark -
+//======================================================================================================================
+
+/// Statements prepared once per connection and reused with bound parameters.
+typedef NS_ENUM(NSUInteger, RollbarStatement) {
+    RollbarStatementInsertDestination,
+    RollbarStatementSelectDestinationID,
+    RollbarStatementSelectDestination,
+    RollbarStatementSelectDestinationByID,
+    RollbarStatementSelectAllDestinations,
+    RollbarStatementDeleteDestination,
+    RollbarStatementDeleteDestinationByID,
+    RollbarStatementInsertConfig,
+    RollbarStatementSelectConfigID,
+    RollbarStatementInsertPayload,
+    RollbarStatementSelectPayloadByID,
+    RollbarStatementSelectPayloadsByDestination,
+    RollbarStatementSelectPayloadsPageByDestination,
+    RollbarStatementSelectPayloadsPage,
+    RollbarStatementSelectPayloadsAfterIDByDestination,
+    RollbarStatementSelectPayloadsAfterID,
+    RollbarStatementSelectAllPayloads,
+    RollbarStatementCountPayloadsByDestination,
+    RollbarStatementSelectPayloadDestinationByID,
+    RollbarStatementDeletePayloadByID,
+    RollbarStatementDeletePayloadsOlderThan,
+    RollbarStatementCount
+};
+
+/// Payload rows with their config inlined back, as they were stored before configs were deduplicated.
+#define SELECT_PAYLOADS \
+    "SELECT payloads.id, configs.config_json, payloads.payload_json, payloads.created_at, payloads.destination_key " \
+    "FROM payloads JOIN configs ON configs.id = payloads.config_key"
+
+static const char *const RollbarStatementSql[RollbarStatementCount] = {
+    [RollbarStatementInsertDestination] =
+        "INSERT INTO destinations (endpoint, access_token) VALUES (?1, ?2)",
+    [RollbarStatementSelectDestinationID] =
+        "SELECT id FROM destinations WHERE endpoint = ?1 AND access_token = ?2",
+    [RollbarStatementSelectDestination] =
+        "SELECT * FROM destinations WHERE endpoint = ?1 AND access_token = ?2",
+    [RollbarStatementSelectDestinationByID] =
+        "SELECT * FROM destinations WHERE id = ?1",
+    [RollbarStatementSelectAllDestinations] =
+        "SELECT * FROM destinations",
+    [RollbarStatementDeleteDestination] =
+        "DELETE FROM destinations WHERE endpoint = ?1 AND access_token = ?2",
+    [RollbarStatementDeleteDestinationByID] =
+        "DELETE FROM destinations WHERE id = ?1",
+    [RollbarStatementInsertConfig] =
+        "INSERT OR IGNORE INTO configs (hash, config_json) VALUES (?1, ?2)",
+    [RollbarStatementSelectConfigID] =
+        "SELECT id FROM configs WHERE hash = ?1",
+    [RollbarStatementInsertPayload] =
+        "INSERT INTO payloads (config_key, payload_json, destination_key, created_at) VALUES (?1, ?2, ?3, ?4)",
+    [RollbarStatementSelectPayloadByID] =
+        SELECT_PAYLOADS " WHERE payloads.id = ?1",
+    [RollbarStatementSelectPayloadsByDestination] =
+        SELECT_PAYLOADS " WHERE payloads.destination_key = ?1 ORDER BY payloads.id",
+    [RollbarStatementSelectPayloadsPageByDestination] =
+        SELECT_PAYLOADS " WHERE payloads.destination_key = ?1 ORDER BY payloads.id LIMIT ?2 OFFSET ?3",
+    [RollbarStatementSelectPayloadsPage] =
+        SELECT_PAYLOADS " ORDER BY payloads.id LIMIT ?1 OFFSET ?2",
+    [RollbarStatementSelectPayloadsAfterIDByDestination] =
+        SELECT_PAYLOADS " WHERE payloads.destination_key = ?1 AND payloads.id > ?2 ORDER BY payloads.id LIMIT ?3",
+    [RollbarStatementSelectPayloadsAfterID] =
+        SELECT_PAYLOADS " WHERE payloads.id > ?1 ORDER BY payloads.id LIMIT ?2",
+    [RollbarStatementSelectAllPayloads] =
+        SELECT_PAYLOADS " ORDER BY payloads.id",
+    [RollbarStatementCountPayloadsByDestination] =
+        "SELECT destination_key, COUNT(*) FROM payloads GROUP BY destination_key",
+    [RollbarStatementSelectPayloadDestinationByID] =
+        "SELECT destination_key FROM payloads WHERE id = ?1",
+    [RollbarStatementDeletePayloadByID] =
+        "DELETE FROM payloads WHERE id = ?1",
+    [RollbarStatementDeletePayloadsOlderThan] =
+        "DELETE FROM payloads WHERE created_at <= ?1",
+};
+
+/// Binds a string without copying it.
+///
+/// The string's UTF-8 buffer only has to outlive the statement's execution, since
+/// bindings are cleared before the statement is handed back to the cache.
+static void bindText(sqlite3_stmt *statement, int index, NSString *text)
 {
-    defaultOnSelectCallback(info, columns, data, column);
+    sqlite3_bind_text(statement, index, [text UTF8String], -1, SQLITE_STATIC);
+}
 
-    NSDictionary<NSString *, NSString *> *__strong*result = (NSDictionary<NSString *, NSString *> *__strong*)info;
-    
-    NSMutableDictionary<NSString *, NSString *> *row =
-    [NSMutableDictionary<NSString *, NSString *> dictionaryWithCapacity:columns];
-    
-    for (int i = 0; i < columns; i++) {
-        NSString *key = [NSString stringWithFormat:@"%s", column[i]];
-        NSString *value = [NSString stringWithFormat:@"%s", data[i]];
-        row[key] = value;
+/// Binds bytes without copying them, on the same terms as `bindText`.
+static void bindBlob(sqlite3_stmt *statement, int index, NSData *data)
+{
+    if (0 == data.length) {
+        // empty data has no bytes to point at, and binding NULL bytes would store SQL NULL:
+        sqlite3_bind_zeroblob(statement, index, 0);
+        return;
     }
-    
-    *result = [row copy];
-
-    return SQLITE_OK;
+    sqlite3_bind_blob(statement, index, data.bytes, (int)data.length, SQLITE_STATIC);
 }
 
-static int selectMultipleRowsCallback(void *info, int columns, char **data, char **column)
+/// Binds a row ID given as its string representation.
+static void bindID(sqlite3_stmt *statement, int index, NSString *rowID)
 {
-    defaultOnSelectCallback(info, columns, data, column);
-
-    typedef NSMutableDictionary<NSString *, NSString *> RBPayload;
-    typedef NSMutableArray<RBPayload *> RBPayloads;
+    sqlite3_bind_int64(statement, index, [rowID longLongValue]);
+}
 
-    RBPayloads * __strong *result = (RBPayloads * __strong *)info;
-    if (!*result) {
-        *result = [RBPayloads array];
+/// Returns a SHA-256 digest of a string's UTF-8 bytes as lowercase hex.
+static NSString *contentHash(NSString *text)
+{
+    NSData *data = [text dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+    
+    NSMutableString *hash = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+    for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        [hash appendFormat:@"%02x", digest[i]];
     }
+    return hash;
+}
+
+/// Returns the current row of a statement with every column as a string,
+/// except for BLOB values that are returned as data.
+static NSDictionary<NSString *, id> *readRow(sqlite3_stmt *statement)
+{
+    int columns = sqlite3_column_count(statement);
+    NSMutableDictionary<NSString *, id> *row =
+    [NSMutableDictionary<NSString *, id> dictionaryWithCapacity:columns];
     
-    RBPayload *row = [RBPayload dictionaryWithCapacity:columns];
-        
     for (int i = 0; i < columns; i++) {
-        NSString *key = [[NSString alloc] initWithUTF8String:column[i]];
-        NSString *value = [[NSString alloc] initWithUTF8String:data[i]];
-        row[key] = value;
+        NSString *key = [[NSString alloc] initWithUTF8String:sqlite3_column_name(statement, i)];
+        if (SQLITE_BLOB == sqlite3_column_type(statement, i)) {
+            const void *bytes = sqlite3_column_blob(statement, i);
+            row[key] = [NSData dataWithBytes:bytes length:sqlite3_column_bytes(statement, i)];
+            continue;
+        }
+        const char *value = (const char *)sqlite3_column_text(statement, i);
+        if (value) {
+            row[key] = [[NSString alloc] initWithUTF8String:value];
+        }
     }
     
-    [*result addObject:[row copy]];
-    
-    return SQLITE_OK;
+    return [row copy];
 }
 
+/// The payloads table definition, shared by its creation and migration.
+static NSString * const PAYLOADS_TABLE_COLUMNS =
+@"(id INTEGER NOT NULL PRIMARY KEY, config_key INTEGER NOT NULL, payload_json BLOB NOT NULL, created_at INTEGER NOT NULL, destination_key INTEGER NOT NULL, "
+@"FOREIGN KEY(config_key) REFERENCES configs(id), "
+@"FOREIGN KEY(destination_key) REFERENCES destinations(id) ON UPDATE CASCADE ON DELETE CASCADE)";
+
+/// How many config IDs are remembered before the lookup cache starts over.
+static NSUInteger const MAX_CACHED_CONFIG_IDS = 16;
+
 //======================================================================================================================
 #pragma mark - Peyloads Repository
 #pragma mark -
@@ -88,6 +198,14 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     NSString *_storePath;
     sqlite3 *_db;
     char *_sqliteErrorMessage;
+    sqlite3_stmt *_statements[RollbarStatementCount];
+    RollbarPayloadStoreDurability _durability;
+    NSUInteger _groupCommitSize;
+    NSUInteger _pendingWrites;
+    BOOL _inTransaction;
+    NSMutableDictionary<NSString *, NSNumber *> *_configIDs;
+    NSMutableDictionary<NSString *, NSNumber *> *_payloadCounts;
+    NSInteger _payloadCount;
 
 }
 
@@ -124,6 +242,12 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     return [RollbarPayloadRepository repositoryWithPath:storePath];
 }
 
++ (instancetype)persistentRepositoryWithPath:(nonnull NSString *)storePath
+                                  durability:(RollbarPayloadStoreDurability)durability {
+    
+    return [[RollbarPayloadRepository alloc] initWithStore:storePath durability:durability];
+}
+
 #pragma mark - class initializer
 
 + (void)initialize {
@@ -145,9 +269,16 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 
 - (instancetype)initWithStore:(nonnull NSString *)storePath {
     
+    return [self initWithStore:storePath durability:RollbarPayloadStoreDurability_Normal];
+}
+
+- (instancetype)initWithStore:(nonnull NSString *)storePath
+                   durability:(RollbarPayloadStoreDurability)durability {
+    
     if (self = [super init]) {
         
         self->_storePath = storePath;
+        self->_durability = durability;
         [self initDB:NO];
         return self;
     }
@@ -171,13 +302,14 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 - (nullable NSDictionary<NSString *, NSString *> *)addDestinationWithEndpoint:(nonnull NSString *)endpoint
                                                                 andAccesToken:(nonnull NSString *)accessToken {
     
-    NSString *sql = [NSString stringWithFormat:
-                     @"INSERT INTO destinations (endpoint, access_token) VALUES ('%@', '%@')",
-                     endpoint,
-                     accessToken
-    ];
+    sqlite3_stmt *statement = [self statement:RollbarStatementInsertDestination];
+    if (!statement) {
+        return nil;
+    }
+    bindText(statement, 1, endpoint);
+    bindText(statement, 2, accessToken);
     
-    if (NO == [self executeSql:sql]) {
+    if (NO == [self executeStatement:statement]) {
         return nil;
     }
     
@@ -193,14 +325,13 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 - (nonnull NSString *)getIDofDestinationWithEndpoint:(nonnull NSString *)endpoint
                                        andAccesToken:(nonnull NSString *)accessToken {
     
-    NSString *sql = [NSString stringWithFormat:
-                         @"SELECT id FROM destinations WHERE endpoint = '%@' AND access_token = '%@'",
-                     endpoint,
-                     accessToken
-    ];
-    
-    NSDictionary<NSString *, NSString *> *result = [self selectSingleRowWithSql:sql
-                                                                    andCallback:selectSingleRowCallback];
+    NSDictionary<NSString *, NSString *> *result = nil;
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectDestinationID];
+    if (statement) {
+        bindText(statement, 1, endpoint);
+        bindText(statement, 2, accessToken);
+        result = [self selectSingleRowWithStatement:statement];
+    }
     
     if (!result || (0 == result.count)) {
         result = [self addDestinationWithEndpoint:endpoint
@@ -222,59 +353,55 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 - (nullable NSDictionary<NSString *, NSString *> *)getDestinationWithEndpoint:(nonnull NSString *)endpoint
                                                                 andAccesToken:(nonnull NSString *)accessToken {
     
-    NSString *sql = [NSString stringWithFormat:
-                         @"SELECT * FROM destinations WHERE endpoint = '%@' AND access_token = '%@'",
-                     endpoint,
-                     accessToken
-    ];
-                                               
-    NSDictionary<NSString *, NSString *> *result =
-    [self selectSingleRowWithSql:sql andCallback:selectSingleRowCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectDestination];
+    if (!statement) {
+        return nil;
+    }
+    bindText(statement, 1, endpoint);
+    bindText(statement, 2, accessToken);
     
-    return result;
+    return [self selectSingleRowWithStatement:statement];
 }
 
 - (nullable NSDictionary<NSString *, NSString *> *)getDestinationByID:(nonnull NSString *)destinationID {
     NSAssert(destinationID && destinationID.length > 0, @"destinationID cannot be nil");
-    NSString *sql = [NSString stringWithFormat:
-                     @"SELECT * FROM destinations WHERE id = '%@'",
-                     destinationID
-    ];
     
-    NSDictionary<NSString *, NSString *> *result =
-    [self selectSingleRowWithSql:sql andCallback:selectSingleRowCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectDestinationByID];
+    if (!statement) {
+        return nil;
+    }
+    bindID(statement, 1, destinationID);
     
-    return result;
+    return [self selectSingleRowWithStatement:statement];
 }
 
 - (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getAllDestinations {
     
-    NSString *sql = @"SELECT * FROM destinations";
-    
-    NSArray<NSDictionary<NSString *, NSString *> *> *result =
-    [self selectMultipleRowsWithSql:sql andCallback:selectMultipleRowsCallback];
-    
-    return result;
+    return [self selectMultipleRowsWithStatement:[self statement:RollbarStatementSelectAllDestinations]];
 }
 
 - (BOOL)removeDestinationWithEndpoint:(nonnull NSString *)endpoint
                         andAccesToken:(nonnull NSString *)accessToken {
     
-    NSString *sql =
-    [NSString stringWithFormat: @"DELETE FROM destinations WHERE endpoint = '%@' AND access_token = '%@'",
-     endpoint,
-     accessToken
-    ];
+    sqlite3_stmt *statement = [self statement:RollbarStatementDeleteDestination];
+    if (!statement) {
+        return NO;
+    }
+    bindText(statement, 1, endpoint);
+    bindText(statement, 2, accessToken);
     
-    return [self executeSql:sql];
+    return [self executeStatement:statement];
 }
 
 - (BOOL)removeDestinationByID:(nonnull NSString *)destinationID {
     
-    NSString *sql =
-    [NSString stringWithFormat: @"DELETE FROM destinations WHERE id = '%@'", destinationID];
+    sqlite3_stmt *statement = [self statement:RollbarStatementDeleteDestinationByID];
+    if (!statement) {
+        return NO;
+    }
+    bindID(statement, 1, destinationID);
     
-    return [self executeSql:sql];
+    return [self executeStatement:statement];
 }
 
 - (BOOL)removeUnusedDestinations {
@@ -292,28 +419,54 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 
 #pragma mark - Payloads related methods
 
-- (nullable NSDictionary<NSString *, NSString *> *)addPayload:(nonnull NSString *)payload
-                                                   withConfig:(nonnull NSString *)config
-                                             andDestinationID:(nonnull NSString *)destinationID {
+- (nullable NSDictionary<NSString *, id> *)addPayload:(nonnull NSString *)payload
+                                           withConfig:(nonnull NSString *)config
+                                     andDestinationID:(nonnull NSString *)destinationID {
     
-    NSNumber *timeStamp = [NSNumber numberWithInteger:[[NSDate date] timeIntervalSince1970]];
+    return [self addPayloadValue:payload withConfig:config andDestinationID:destinationID];
+}
+
+- (nullable NSDictionary<NSString *, id> *)addPayloadData:(nonnull NSData *)payloadData
+                                               withConfig:(nonnull NSString *)config
+                                         andDestinationID:(nonnull NSString *)destinationID {
     
-    NSString *escapedPayload = [payload stringByReplacingOccurrencesOfString:@"'" withString:@"''"];
-    NSString *escapedConfig = [config stringByReplacingOccurrencesOfString:@"'" withString:@"''"];
+    return [self addPayloadValue:payloadData withConfig:config andDestinationID:destinationID];
+}
 
-    NSString *sql = [NSString stringWithFormat:
-      @"INSERT INTO payloads (config_json, payload_json, destination_key, created_at) VALUES ('%@', '%@', '%@', '%ld')",
-      escapedConfig,
-      escapedPayload,
-      destinationID,
-      (long)[timeStamp integerValue]
-    ];
+- (nullable NSDictionary<NSString *, id> *)addPayloadValue:(nonnull id)payload
+                                                withConfig:(nonnull NSString *)config
+                                          andDestinationID:(nonnull NSString *)destinationID {
     
-    if (NO == [self executeSql:sql]) {
-        return nil;
+    NSNumber *timeStamp = [NSNumber numberWithInteger:[[NSDate date] timeIntervalSince1970]];
+    
+    [self beginGroupedWrite];
+    
+    BOOL success = NO;
+    sqlite3_int64 payloadID = 0;
+    NSNumber *configID = [self getIDofConfig:config];
+    sqlite3_stmt *statement = [self statement:RollbarStatementInsertPayload];
+    if (configID && statement) {
+        sqlite3_bind_int64(statement, 1, [configID longLongValue]);
+        if ([payload isKindOfClass:[NSData class]]) {
+            bindBlob(statement, 2, payload);
+        } else {
+            bindText(statement, 2, payload);
+        }
+        bindID(statement, 3, destinationID);
+        sqlite3_bind_int64(statement, 4, [timeStamp longLongValue]);
+        
+        success = [self executeStatement:statement];
+        if (success) {
+            payloadID = sqlite3_last_insert_rowid(self->_db);
+        }
     }
     
-    sqlite3_int64 payloadID = sqlite3_last_insert_rowid(self->_db);
+    // every grouped write is ended, whether it succeeded or not, so the group still gets committed:
+    [self endGroupedWrite];
+    if (!success) {
+        return nil;
+    }
+    [self countPayloads:1 forDestinationID:destinationID];
     
     return @ {
         @"id": [NSString stringWithFormat:@"%lli", payloadID], //[NSNumber numberWithLongLong:destinationID],
@@ -323,128 +476,308 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     };
 }
 
-- (nullable NSDictionary<NSString *, NSString *> *)getPayloadByID:(nonnull NSString *)payloadID {
+- (nullable NSDictionary<NSString *, id> *)getPayloadByID:(nonnull NSString *)payloadID {
 
-    NSString *sql = [NSString stringWithFormat:
-      @"SELECT * FROM payloads WHERE id = '%@'",
-      payloadID
-    ];
-    
-    NSDictionary<NSString *, NSString *> *result =
-    [self selectSingleRowWithSql:sql andCallback:selectSingleRowCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadByID];
+    if (!statement) {
+        return nil;
+    }
+    bindID(statement, 1, payloadID);
     
-    return result;
+    return [self selectSingleRowWithStatement:statement];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getAllPayloadsWithDestinationID:(nonnull NSString *)destinationID {
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getAllPayloadsWithDestinationID:(nonnull NSString *)destinationID {
     
-    NSString *sql = [NSString stringWithFormat:
-      @"SELECT * FROM payloads WHERE destination_key = '%@'",
-      destinationID
-    ];
-
-    NSArray<NSDictionary<NSString *, NSString *> *> *result =
-    [self selectMultipleRowsWithSql:sql andCallback:selectMultipleRowsCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadsByDestination];
+    if (statement) {
+        bindID(statement, 1, destinationID);
+    }
     
-    return result;
+    return [self selectMultipleRowsWithStatement:statement];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
-                                                                                    andLimit:(NSUInteger)limit {
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                              andLimit:(NSUInteger)limit {
     
     return  [self getPayloadsWithDestinationID:destinationID andOffset:0 andLimit:limit];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
-                                                                                andOffset:(NSUInteger)offset
-                                                                                 andLimit:(NSUInteger)limit {
-    
-    
-    NSString *sql = [NSString stringWithFormat:
-                         @"SELECT * FROM payloads WHERE destination_key = '%@' LIMIT %lu OFFSET %lu",
-                     destinationID,
-                     (unsigned long)limit,
-                     (unsigned long)offset
-    ];
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                          andOffset:(NSUInteger)offset
+                                                                           andLimit:(NSUInteger)limit {
     
-    NSArray<NSDictionary<NSString *, NSString *> *> *result =
-    [self selectMultipleRowsWithSql:sql andCallback:selectMultipleRowsCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadsPageByDestination];
+    if (statement) {
+        bindID(statement, 1, destinationID);
+        sqlite3_bind_int64(statement, 2, (sqlite3_int64)limit);
+        sqlite3_bind_int64(statement, 3, (sqlite3_int64)offset);
+    }
     
-    return result;
+    return [self selectMultipleRowsWithStatement:statement];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithLimit:(NSUInteger)limit {
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithLimit:(NSUInteger)limit {
 
     return [self getPayloadsWithOffset:0 andLimit:limit];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getPayloadsWithOffset:(NSUInteger)offset
-                                                                          andLimit:(NSUInteger)limit {
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithOffset:(NSUInteger)offset
+                                                                    andLimit:(NSUInteger)limit {
 
-    NSString *sql =
-    [NSString stringWithFormat:@"SELECT * FROM payloads LIMIT %lu OFFSET %lu",
-     (unsigned long)limit,
-     (unsigned long)offset];
-    
-    NSArray<NSDictionary<NSString *, NSString *> *> *result =
-    [self selectMultipleRowsWithSql:sql andCallback:selectMultipleRowsCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadsPage];
+    if (statement) {
+        sqlite3_bind_int64(statement, 1, (sqlite3_int64)limit);
+        sqlite3_bind_int64(statement, 2, (sqlite3_int64)offset);
+    }
     
-    return result;
+    return [self selectMultipleRowsWithStatement:statement];
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)getAllPayloads {
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsWithDestinationID:(nonnull NSString *)destinationID
+                                                                            afterID:(nonnull NSString *)payloadID
+                                                                           andLimit:(NSUInteger)limit {
+    
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadsAfterIDByDestination];
+    if (statement) {
+        bindID(statement, 1, destinationID);
+        bindID(statement, 2, payloadID);
+        sqlite3_bind_int64(statement, 3, (sqlite3_int64)limit);
+    }
+    
+    return [self selectMultipleRowsWithStatement:statement];
+}
 
-    NSString *sql = @"SELECT * FROM payloads";
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getPayloadsAfterID:(nonnull NSString *)payloadID
+                                                                 andLimit:(NSUInteger)limit {
     
-    NSArray<NSDictionary<NSString *, NSString *> *> *result =
-    [self selectMultipleRowsWithSql:sql andCallback:selectMultipleRowsCallback];
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadsAfterID];
+    if (statement) {
+        bindID(statement, 1, payloadID);
+        sqlite3_bind_int64(statement, 2, (sqlite3_int64)limit);
+    }
     
-    return result;
+    return [self selectMultipleRowsWithStatement:statement];
 }
 
-- (NSInteger)getPayloadCount {
-    const char *sql = "SELECT COUNT(*) FROM payloads";
-    sqlite3_stmt *statement;
-    NSInteger count = 0;
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)getAllPayloads {
 
-    if (sqlite3_prepare_v2(self->_db, sql, -1, &statement, NULL) == SQLITE_OK) {
-        while (sqlite3_step(statement) == SQLITE_ROW) {
-            count = sqlite3_column_int(statement, 0);
-            break;
-        }
-    } else {
-        RBErr(@"sqlite3_prepare_v2 error %s", sqlite3_errmsg(self->_db));
-    }
+    return [self selectMultipleRowsWithStatement:[self statement:RollbarStatementSelectAllPayloads]];
+}
 
-    sqlite3_finalize(statement);
-    return count;
+- (NSInteger)getPayloadCount {
+    
+    [self loadPayloadCounts];
+    return self->_payloadCount;
+}
+
+- (NSInteger)getPayloadCountWithDestinationID:(nonnull NSString *)destinationID {
+    
+    return [[self loadPayloadCounts][destinationID] integerValue];
 }
 
 - (BOOL)removePayloadByID:(nonnull NSString *)payloadID {
     
-    NSString *sql =
-    [NSString stringWithFormat: @"DELETE FROM payloads WHERE id = '%@'", payloadID];
+    // the row's destination is needed to keep its count, and costs a primary key lookup:
+    sqlite3_stmt *statement = [self statement:RollbarStatementSelectPayloadDestinationByID];
+    if (!statement) {
+        return NO;
+    }
+    bindID(statement, 1, payloadID);
+    NSString *destinationID = [self selectSingleRowWithStatement:statement][@"destination_key"];
     
-    return [self executeSql:sql];
+    statement = [self statement:RollbarStatementDeletePayloadByID];
+    if (!statement) {
+        return NO;
+    }
+    bindID(statement, 1, payloadID);
+    
+    [self beginGroupedWrite];
+    BOOL success = [self executeStatement:statement];
+    [self endGroupedWrite];
+    
+    if (success && destinationID && sqlite3_changes(self->_db) > 0) {
+        [self countPayloads:-1 forDestinationID:destinationID];
+    }
+    return success;
 }
 
 - (BOOL)removePayloadsOlderThan:(nonnull NSDate *)cutoffTime {
     
     NSTimeInterval interval = [cutoffTime timeIntervalSince1970];
     
-    NSString *sql = [NSString stringWithFormat:
-                     @"DELETE FROM payloads WHERE created_at <= '%li'",
-                     (long int)interval
-    ];
-    return [self executeSql:sql];
+    sqlite3_stmt *statement = [self statement:RollbarStatementDeletePayloadsOlderThan];
+    if (!statement) {
+        return NO;
+    }
+    sqlite3_bind_int64(statement, 1, (sqlite3_int64)interval);
+    
+    BOOL success = [self executeStatement:statement];
+    if (sqlite3_changes(self->_db) > 0) {
+        self->_payloadCounts = nil;
+    }
+    return success;
 }
 
 - (BOOL)removeAllPayloads {
 
     NSString *sql = @"DELETE FROM payloads";
+    self->_payloadCounts = nil;
+    return [self executeSql:sql];
+}
+
+#pragma mark - Payload counts
+
+- (nonnull NSDictionary<NSString *, NSNumber *> *)loadPayloadCounts {
+    
+    if (self->_payloadCounts) {
+        return self->_payloadCounts;
+    }
+    
+    // counted once per connection, then kept up to date by every insert and delete:
+    self->_payloadCounts = [NSMutableDictionary<NSString *, NSNumber *> dictionary];
+    self->_payloadCount = 0;
+    
+    sqlite3_stmt *statement = [self statement:RollbarStatementCountPayloadsByDestination];
+    if (!statement) {
+        return self->_payloadCounts;
+    }
+    int result;
+    while ((result = sqlite3_step(statement)) == SQLITE_ROW) {
+        NSString *destinationID = [NSString stringWithFormat:@"%lli", sqlite3_column_int64(statement, 0)];
+        NSInteger count = (NSInteger)sqlite3_column_int64(statement, 1);
+        self->_payloadCounts[destinationID] = @(count);
+        self->_payloadCount += count;
+    }
+    if (result != SQLITE_DONE) {
+        RBErr(@"sqlite3_step: %s during %s", sqlite3_errmsg(self->_db), sqlite3_sql(statement));
+    }
+    [self resetStatement:statement];
+    
+    return self->_payloadCounts;
+}
+
+- (void)countPayloads:(NSInteger)delta forDestinationID:(nonnull NSString *)destinationID {
+    
+    if (!self->_payloadCounts) {
+        // not loaded yet, so there is nothing to keep up to date:
+        return;
+    }
+    
+    // IDs are kept in their canonical form, the one loadPayloadCounts reads back:
+    NSString *key = [NSString stringWithFormat:@"%lli", [destinationID longLongValue]];
+    NSInteger count = [self->_payloadCounts[key] integerValue] + delta;
+    self->_payloadCounts[key] = (count > 0) ? @(count) : nil;
+    self->_payloadCount += delta;
+}
+
+#pragma mark - Configs related methods
+
+- (nullable NSNumber *)getIDofConfig:(nonnull NSString *)config {
+    
+    // callers pass the string cached on their RollbarConfig, so this is mostly a pointer comparison:
+    NSNumber *configID = self->_configIDs[config];
+    if (configID) {
+        return configID;
+    }
+    
+    NSString *hash = contentHash(config);
+    
+    sqlite3_stmt *statement = [self statement:RollbarStatementInsertConfig];
+    if (!statement) {
+        return nil;
+    }
+    bindText(statement, 1, hash);
+    bindText(statement, 2, config);
+    if (NO == [self executeStatement:statement]) {
+        return nil;
+    }
+    
+    statement = [self statement:RollbarStatementSelectConfigID];
+    if (!statement) {
+        return nil;
+    }
+    bindText(statement, 1, hash);
+    NSString *configKey = [self selectSingleRowWithStatement:statement][@"id"];
+    if (!configKey) {
+        return nil;
+    }
+    
+    if (self->_configIDs.count >= MAX_CACHED_CONFIG_IDS) {
+        [self->_configIDs removeAllObjects];
+    }
+    configID = [NSNumber numberWithLongLong:[configKey longLongValue]];
+    self->_configIDs[config] = configID;
+    return configID;
+}
+
+- (BOOL)removeUnusedConfigs {
+    
+    [self->_configIDs removeAllObjects];
+    
+    NSString *sql =
+    @"DELETE FROM configs WHERE NOT EXISTS (SELECT 1 FROM payloads WHERE payloads.config_key = configs.id)";
     return [self executeSql:sql];
 }
 
+#pragma mark - Group commit
+
+- (NSUInteger)groupCommitSize {
+    
+    return self->_groupCommitSize;
+}
+
+- (void)setGroupCommitSize:(NSUInteger)groupCommitSize {
+    
+    self->_groupCommitSize = groupCommitSize;
+    if (self->_pendingWrites >= groupCommitSize) {
+        [self flush];
+    }
+}
+
+- (BOOL)hasPendingWrites {
+    
+    return self->_inTransaction;
+}
+
+- (BOOL)flush {
+    
+    if (!self->_inTransaction) {
+        return YES;
+    }
+    
+    self->_inTransaction = NO;
+    self->_pendingWrites = 0;
+    
+    // straight to the connection we began on, so that a reopened store isn't touched:
+    char *sqliteErrorMessage;
+    if (sqlite3_exec(self->_db, "COMMIT", NULL, NULL, &sqliteErrorMessage) != SQLITE_OK) {
+        
+        RBErr(@"sqlite3_exec: %s during COMMIT", sqliteErrorMessage);
+        sqlite3_free(sqliteErrorMessage);
+        // the writes that were counted may not have made it:
+        self->_payloadCounts = nil;
+        return NO;
+    }
+    return YES;
+}
+
+- (void)beginGroupedWrite {
+    
+    if (self->_groupCommitSize > 1 && !self->_inTransaction) {
+        
+        self->_inTransaction = [self executeSql:@"BEGIN IMMEDIATE"];
+    }
+}
+
+- (void)endGroupedWrite {
+    
+    if (self->_inTransaction && ++self->_pendingWrites >= self->_groupCommitSize) {
+        
+        [self flush];
+    }
+}
+
 #pragma mark - unit testing helper methods
 
 - (BOOL)checkIfTableExists_Destinations {
@@ -459,6 +792,12 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     return result;
 }
 
+- (BOOL)checkIfTableExists_Configs {
+    
+    BOOL result = [self checkIfTableExists:@"configs"];
+    return result;
+}
+
 - (BOOL)checkIfTableExists_Unknown {
     
     BOOL result = [self checkIfTableExists:@"unknown"];
@@ -478,6 +817,9 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 - (BOOL)clear {
 
     BOOL success = [self clearPayloads];
+    if (success) {
+        success = [self removeUnusedConfigs];
+    }
     if (success) {
         success = [self clearDestinations];
     }
@@ -505,18 +847,64 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     ? (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_MEMORY)
     : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
     
+    if (self->_db) {
+        
+        // statements are prepared per connection, so they can't outlive it:
+        [self releaseDB];
+    }
+    
+    // config IDs and payload counts are only valid within the store they were read from:
+    self->_configIDs = [NSMutableDictionary<NSString *, NSNumber *> dictionary];
+    self->_payloadCounts = nil;
+    
     int result = sqlite3_open_v2([self->_storePath UTF8String], &self->_db, sqliteDbFlags, NULL);
     if (result != SQLITE_OK) {
         
         RBErr(@"sqlite3_open: %s", sqlite3_errmsg(self->_db));
         return NO;
     }
+    
+    if (!inMemory) {
+        
+        [self configureJournal];
+    }
 
     [self checkDbFile];
 
     return YES;
 }
 
+- (void)configureJournal {
+    
+    // WAL appends to a log instead of rewriting pages through a rollback journal,
+    // so commits need at most one fsync, and none at all below FULL synchronous:
+    char *sqliteErrorMessage;
+    if (sqlite3_exec(self->_db, "PRAGMA journal_mode=WAL", NULL, NULL, &sqliteErrorMessage) != SQLITE_OK) {
+        
+        RBErr(@"sqlite3_exec: %s during PRAGMA journal_mode=WAL", sqliteErrorMessage);
+        sqlite3_free(sqliteErrorMessage);
+    }
+    
+    const char *sql = NULL;
+    switch (self->_durability) {
+        case RollbarPayloadStoreDurability_Full:
+            sql = "PRAGMA synchronous=FULL";
+            break;
+        case RollbarPayloadStoreDurability_Relaxed:
+            sql = "PRAGMA synchronous=OFF";
+            break;
+        case RollbarPayloadStoreDurability_Normal:
+        default:
+            sql = "PRAGMA synchronous=NORMAL";
+            break;
+    }
+    if (sqlite3_exec(self->_db, sql, NULL, NULL, &sqliteErrorMessage) != SQLITE_OK) {
+        
+        RBErr(@"sqlite3_exec: %s during %s", sqliteErrorMessage, sql);
+        sqlite3_free(sqliteErrorMessage);
+    }
+}
+
 - (BOOL)ensureDestinationsTable {
     
     NSString *sql = [NSString stringWithFormat:
@@ -527,20 +915,79 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
 
 - (BOOL)ensurePayloadsTable {
     
+    // payloads share their configs, which are stored once per distinct content:
+    NSString *sql =
+    @"CREATE TABLE IF NOT EXISTS configs (id INTEGER NOT NULL PRIMARY KEY, hash TEXT NOT NULL UNIQUE, config_json TEXT NOT NULL)";
+    if (NO == [self executeSql:sql]) {
+        return NO;
+    }
+    
+    sql = [NSString stringWithFormat:@"CREATE TABLE IF NOT EXISTS payloads %@", PAYLOADS_TABLE_COLUMNS];
+    if (NO == [self executeSql:sql]) {
+        return NO;
+    }
+    
+    if (NO == [self migrateInlineConfigs]) {
+        return NO;
+    }
+    
+    // payloads are dequeued in id order, per destination, and expire by age:
+    sql = @"CREATE INDEX IF NOT EXISTS payloads_destination_key ON payloads (destination_key, id);"
+    @"CREATE INDEX IF NOT EXISTS payloads_created_at ON payloads (created_at)";
+    return [self executeSql:sql];
+}
+
+- (BOOL)migrateInlineConfigs {
     
+    // stores created before configs were deduplicated keep a config_json column on every payload:
+    sqlite3_stmt *probe = NULL;
+    BOOL hasInlineConfigs =
+    (SQLITE_OK == sqlite3_prepare_v2(self->_db, "SELECT config_json FROM payloads LIMIT 0", -1, &probe, NULL));
+    sqlite3_finalize(probe);
+    if (!hasInlineConfigs) {
+        return YES;
+    }
     
+    // their hashes can't be computed in SQL, so migrated configs get placeholder keys;
+    // at worst, each of them gets stored once more when it's used again:
     NSString *sql = [NSString stringWithFormat:
-                         @"CREATE TABLE IF NOT EXISTS payloads (id INTEGER NOT NULL PRIMARY KEY, config_json TEXT NOT NULL, payload_json TEXT NOT NULL, created_at INTEGER NOT NULL, destination_key INTEGER NOT NULL, FOREIGN KEY(destination_key) REFERENCES destinations(id) ON UPDATE CASCADE ON DELETE CASCADE)"
+                     @"BEGIN IMMEDIATE;"
+                     @"INSERT INTO configs (hash, config_json) SELECT 'migrated:' || MIN(id), config_json FROM payloads GROUP BY config_json;"
+                     @"CREATE TABLE payloads_migrated %@;"
+                     @"INSERT INTO payloads_migrated (id, config_key, payload_json, created_at, destination_key) "
+                     @"SELECT payloads.id, configs.id, payloads.payload_json, payloads.created_at, payloads.destination_key "
+                     @"FROM payloads JOIN configs ON configs.config_json = payloads.config_json;"
+                     @"DROP TABLE payloads;"
+                     @"ALTER TABLE payloads_migrated RENAME TO payloads;"
+                     @"COMMIT;",
+                     PAYLOADS_TABLE_COLUMNS
     ];
-    return [self executeSql:sql];
+    if (NO == [self executeSql:sql]) {
+        [self executeSql:@"ROLLBACK"];
+        return NO;
+    }
+    return YES;
 }
 
 - (void)releaseDB {
     
+    [self flush];
+    
+    for (NSUInteger i = 0; i < RollbarStatementCount; i++) {
+        
+        sqlite3_finalize(self->_statements[i]);
+        self->_statements[i] = NULL;
+    }
+    
     sqlite3_close(self->_db);
     self->_db = nil;
 }
 
+- (void)dealloc {
+    
+    [self releaseDB];
+}
+
 - (BOOL)checkIfTableExists:(nonnull NSString *)tableName {
     
     [self checkDbFile];
@@ -574,44 +1021,84 @@ static int selectMultipleRowsCallback(void *info, int columns, char **data, char
     return YES;
 }
 
-- (nullable NSDictionary<NSString *, NSString *> *)selectSingleRowWithSql:(NSString *)sql
-                                                              andCallback:(int(*)(void*,int,char**,char**))callback {
+- (nullable sqlite3_stmt *)statement:(RollbarStatement)statement {
     
     [self checkDbFile];
-
-    NSDictionary<NSString *, NSString *> *result = nil;
-    char *sqliteErrorMessage;
-    int sqlResult = sqlite3_exec(self->_db, [sql UTF8String], callback, &result, &sqliteErrorMessage);
-    if (sqlResult != SQLITE_OK) {
+    
+    sqlite3_stmt *prepared = self->_statements[statement];
+    if (!prepared) {
         
-        RBErr(@"sqlite3_exec: %s during %@", sqliteErrorMessage, sql);
-        sqlite3_free(sqliteErrorMessage);
+        int result = sqlite3_prepare_v2(self->_db, RollbarStatementSql[statement], -1, &prepared, NULL);
+        if (result != SQLITE_OK) {
+            
+            RBErr(@"sqlite3_prepare_v2: %s during %s", sqlite3_errmsg(self->_db), RollbarStatementSql[statement]);
+            sqlite3_finalize(prepared);
+            return NULL;
+        }
+        self->_statements[statement] = prepared;
     }
     
-    return result;
+    return prepared;
 }
 
-- (nonnull NSArray<NSDictionary<NSString *, NSString *> *> *)selectMultipleRowsWithSql:(NSString *)sql
-                                                                           andCallback:(int(*)(void*,int,char**,char**))callback {
+- (void)resetStatement:(nonnull sqlite3_stmt *)statement {
     
-    [self checkDbFile];
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
+}
+
+- (BOOL)executeStatement:(nonnull sqlite3_stmt *)statement {
     
-    NSMutableArray<NSDictionary<NSString *, NSString *> *> *result = nil;
+    int result = sqlite3_step(statement);
+    if (result != SQLITE_DONE && result != SQLITE_ROW) {
+        
+        RBErr(@"sqlite3_step: %s during %s", sqlite3_errmsg(self->_db), sqlite3_sql(statement));
+    }
     
-    char *sqliteErrorMessage;
-    int sqlResult = sqlite3_exec(self->_db, [sql UTF8String], callback, &result, &sqliteErrorMessage);
-    if (sqlResult != SQLITE_OK) {
+    [self resetStatement:statement];
+    return (result == SQLITE_DONE || result == SQLITE_ROW);
+}
+
+- (nullable NSDictionary<NSString *, id> *)selectSingleRowWithStatement:(nonnull sqlite3_stmt *)statement {
+    
+    NSDictionary<NSString *, id> *result = nil;
+    
+    int stepResult = sqlite3_step(statement);
+    if (stepResult == SQLITE_ROW) {
         
-        RBErr(@"sqlite3_exec: %s during %@", sqliteErrorMessage, sql);
-        sqlite3_free(sqliteErrorMessage);
+        result = readRow(statement);
+    }
+    else if (stepResult != SQLITE_DONE) {
+        
+        RBErr(@"sqlite3_step: %s during %s", sqlite3_errmsg(self->_db), sqlite3_sql(statement));
     }
     
-    if (result) {
+    [self resetStatement:statement];
+    return result;
+}
+
+- (nonnull NSArray<NSDictionary<NSString *, id> *> *)selectMultipleRowsWithStatement:(nullable sqlite3_stmt *)statement {
+    
+    NSMutableArray<NSDictionary<NSString *, id> *> *result =
+    [NSMutableArray<NSDictionary<NSString *, id> *> array];
+    
+    if (!statement) {
         return [result copy];
     }
-    else {
-        return [NSArray<NSDictionary<NSString *, NSString *> *> array];
+    
+    int stepResult;
+    while ((stepResult = sqlite3_step(statement)) == SQLITE_ROW) {
+        
+        [result addObject:readRow(statement)];
     }
+    
+    if (stepResult != SQLITE_DONE) {
+        
+        RBErr(@"sqlite3_step: %s during %s", sqlite3_errmsg(self->_db), sqlite3_sql(statement));
+    }
+    
+    [self resetStatement:statement];
+    return [result copy];
 }
 
 - (void)checkDbFile {
@@ -14,8 +14,22 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface RollbarSender : NSObject
 
+/// The number of payload bytes posted so far, before any compression.
+@property (readonly) NSUInteger uncompressedBytesCount;
+
+/// The number of request body bytes posted so far, after compression.
+@property (readonly) NSUInteger compressedBytesCount;
+
+/// Posts a payload and blocks until its reply, or the lack of one, is known.
 - (nullable RollbarPayloadPostReply *)sendPayload:(nonnull NSData *)payload
                                       usingConfig:(nonnull RollbarConfig *)config;
+
+/// Posts a payload without blocking.
+/// The completion is called once, on an arbitrary queue, with the reply or nil if there was none.
+- (void)sendPayload:(nonnull NSData *)payload
+        usingConfig:(nonnull RollbarConfig *)config
+         completion:(void (^)(RollbarPayloadPostReply * _Nullable reply))completion;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,31 +7,159 @@
 #import "RollbarNotifierFiles.h"
 #import "RollbarInternalLogging.h"
 
-@implementation RollbarSender
+#import <zlib.h>
+
+@implementation RollbarSender {
+    @private
+    z_stream _stream;
+    BOOL _streamReady;
+    NSUInteger _uncompressedBytesCount;
+    NSUInteger _compressedBytesCount;
+}
+
+#pragma mark - initializers
+
+- (void)dealloc {
+    if (self->_streamReady) {
+        deflateEnd(&self->_stream);
+    }
+}
+
+#pragma mark - property accessors
+
+- (NSUInteger)uncompressedBytesCount {
+    @synchronized (self) {
+        return self->_uncompressedBytesCount;
+    }
+}
+
+- (NSUInteger)compressedBytesCount {
+    @synchronized (self) {
+        return self->_compressedBytesCount;
+    }
+}
+
+#pragma mark - compression
+
+/// Gzips the payload, reusing one deflate stream across payloads.
+/// Returns nil if the payload could not be compressed or would not get any smaller.
+- (nullable NSData *)compressPayload:(nonnull NSData *)payload {
+    @synchronized (self) {
+        if (!self->_streamReady) {
+            memset(&self->_stream, 0, sizeof(self->_stream));
+            // 15 window bits plus 16 asks zlib for a gzip header and trailer:
+            if (Z_OK != deflateInit2(&self->_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY)) {
+                RBLog(@"Failed to initialize payload compression: %s", self->_stream.msg);
+                return nil;
+            }
+            self->_streamReady = YES;
+        }
+        else if (Z_OK != deflateReset(&self->_stream)) {
+            return nil;
+        }
+
+        NSMutableData *compressed = [NSMutableData dataWithLength:deflateBound(&self->_stream, payload.length)];
+        self->_stream.next_in = (Bytef *)payload.bytes;
+        self->_stream.avail_in = (uInt)payload.length;
+        self->_stream.next_out = (Bytef *)compressed.mutableBytes;
+        self->_stream.avail_out = (uInt)compressed.length;
+
+        if (Z_STREAM_END != deflate(&self->_stream, Z_FINISH)) {
+            RBLog(@"Failed to compress a payload: %s", self->_stream.msg);
+            return nil;
+        }
+
+        compressed.length = self->_stream.total_out;
+        return (compressed.length < payload.length) ? compressed : nil;
+    }
+}
+
+#pragma mark - sessions
+
++ (nonnull NSURLSession *)sessionWithHttpProxySettings:(nonnull RollbarProxy *)httpProxySettings
+                                andHttpsProxySettings:(nonnull RollbarProxy *)httpsProxySettings
+{
+    if (!(httpProxySettings.enabled || httpsProxySettings.enabled)) {
+        return [NSURLSession sharedSession];
+    }
+
+    // one session per proxy configuration, so that its connections get reused across payloads:
+    static NSMutableDictionary<NSString *, NSURLSession *> *sessions = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sessions = [NSMutableDictionary<NSString *, NSURLSession *> dictionary];
+    });
+
+    NSString *key = [NSString stringWithFormat:@"%d %@:%lu %d %@:%lu",
+                     httpProxySettings.enabled,
+                     httpProxySettings.proxyUrl,
+                     (unsigned long)httpProxySettings.proxyPort,
+                     httpsProxySettings.enabled,
+                     httpsProxySettings.proxyUrl,
+                     (unsigned long)httpsProxySettings.proxyPort];
+
+    @synchronized (sessions) {
+        NSURLSession *session = sessions[key];
+        if (!session) {
+            NSDictionary *connectionProxyDictionary = @{
+                @"HTTPEnable"   : [NSNumber numberWithBool:httpProxySettings.enabled],
+                @"HTTPProxy"    : httpProxySettings.proxyUrl,
+                @"HTTPPort"     : [NSNumber numberWithUnsignedInteger:httpProxySettings.proxyPort],
+                @"HTTPSEnable"  : [NSNumber numberWithBool:httpsProxySettings.enabled],
+                @"HTTPSProxy"   : httpsProxySettings.proxyUrl,
+                @"HTTPSPort"    : [NSNumber numberWithUnsignedInteger:httpsProxySettings.proxyPort]
+            };
+
+            NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration ephemeralSessionConfiguration];
+            sessionConfig.connectionProxyDictionary = connectionProxyDictionary;
+            session = [NSURLSession sessionWithConfiguration:sessionConfig];
+            sessions[key] = session;
+        }
+        return session;
+    }
+}
+
+#pragma mark - sending
 
 - (nullable RollbarPayloadPostReply *)sendPayload:(nonnull NSData *)payload
                                       usingConfig:(nonnull RollbarConfig *)config
 {
-    RollbarPayloadPostReply *reply;
+    __block RollbarPayloadPostReply *reply = nil;
 
+    dispatch_semaphore_t sem = dispatch_semaphore_create(0);
+
+    [self sendPayload:payload usingConfig:config completion:^(RollbarPayloadPostReply *postReply) {
+        reply = postReply;
+        dispatch_semaphore_signal(sem);
+    }];
+
+    dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
+
+    return reply;
+}
+
+- (void)sendPayload:(nonnull NSData *)payload
+        usingConfig:(nonnull RollbarConfig *)config
+         completion:(void (^)(RollbarPayloadPostReply * _Nullable reply))completion
+{
     if (config.developerOptions.transmit) {
-        reply = [self transmitPayload:payload
-                        toDestination:config.destination
-                usingDeveloperOptions:config.developerOptions
-                 andHttpProxySettings:config.httpProxy
-                andHttpsProxySettings:config.httpsProxy];
+        [self transmitPayload:payload
+                toDestination:config.destination
+        usingDeveloperOptions:config.developerOptions
+         andHttpProxySettings:config.httpProxy
+        andHttpsProxySettings:config.httpsProxy
+                   completion:completion];
     } else {
-        reply = [RollbarPayloadPostReply greenReply]; // we just successfully short-circuit here...
+        completion([RollbarPayloadPostReply greenReply]); // we just successfully short-circuit here...
     }
-
-    return reply;
 }
 
-- (nullable RollbarPayloadPostReply *)transmitPayload:(nonnull NSData *)payload
-                                        toDestination:(nonnull RollbarDestination  *)destination
-                                usingDeveloperOptions:(nullable RollbarDeveloperOptions *)developerOptions
-                                 andHttpProxySettings:(nullable RollbarProxy *)httpProxySettings
-                                andHttpsProxySettings:(nullable RollbarProxy *)httpsProxySettings
+- (void)transmitPayload:(nonnull NSData *)payload
+          toDestination:(nonnull RollbarDestination  *)destination
+  usingDeveloperOptions:(nullable RollbarDeveloperOptions *)developerOptions
+   andHttpProxySettings:(nullable RollbarProxy *)httpProxySettings
+  andHttpsProxySettings:(nullable RollbarProxy *)httpsProxySettings
+             completion:(void (^)(RollbarPayloadPostReply * _Nullable reply))completion
 {
     NSAssert(payload, @"The payload must be initialized!");
     NSAssert(destination, @"The destination must be initialized!");
@@ -42,66 +170,65 @@
     httpProxySettings = httpProxySettings ?: [RollbarProxy new];
     httpsProxySettings = httpsProxySettings ?: [RollbarProxy new];
 
-    NSHTTPURLResponse *response = [self postPayload:payload
-                                      toDestination:destination
-                              usingDeveloperOptions:developerOptions
-                               andHttpProxySettings:httpProxySettings
-                              andHttpsProxySettings:httpsProxySettings];
-
-    return [RollbarPayloadPostReply replyFromHttpResponse:response];
+    [self postPayload:payload
+        toDestination:destination
+usingDeveloperOptions:developerOptions
+ andHttpProxySettings:httpProxySettings
+andHttpsProxySettings:httpsProxySettings
+           completion:^(NSHTTPURLResponse *response) {
+        completion([RollbarPayloadPostReply replyFromHttpResponse:response]);
+    }];
 }
 
-- (nullable NSHTTPURLResponse *)postPayload:(nonnull NSData *)payload
-                              toDestination:(nonnull RollbarDestination  *)destination
-                      usingDeveloperOptions:(nonnull RollbarDeveloperOptions *)developerOptions
-                       andHttpProxySettings:(nonnull RollbarProxy *)httpProxySettings
-                      andHttpsProxySettings:(nonnull RollbarProxy *)httpsProxySettings
+- (void)postPayload:(nonnull NSData *)payload
+      toDestination:(nonnull RollbarDestination  *)destination
+usingDeveloperOptions:(nonnull RollbarDeveloperOptions *)developerOptions
+andHttpProxySettings:(nonnull RollbarProxy *)httpProxySettings
+andHttpsProxySettings:(nonnull RollbarProxy *)httpsProxySettings
+         completion:(void (^)(NSHTTPURLResponse * _Nullable response))completion
 {
     NSURL *url = [NSURL URLWithString:destination.endpoint];
     if (url == nil) {
         RBLog(@"The destination endpoint URL is malformed: %@", destination.endpoint);
-        return nil;
+        completion(nil);
+        return;
+    }
+
+    NSData *body = nil;
+    if (developerOptions.compressPayloads
+        && (payload.length >= developerOptions.payloadCompressionThreshold)) {
+        body = [self compressPayload:payload];
     }
 
     NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:url];
     [request setHTTPMethod:@"POST"];
     [request setValue:@"application/json" forHTTPHeaderField:@"Content-Type"];
     [request setValue:destination.accessToken forHTTPHeaderField:@"X-Rollbar-Access-Token"];
-    [request setHTTPBody:payload];
-
-    __block NSHTTPURLResponse *httpResponse = nil;
-
-    dispatch_semaphore_t sem = dispatch_semaphore_create(0);
+    if (body) {
+        [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+        RBLog(@"\tCompressed payload from %lu to %lu bytes",
+              (unsigned long)payload.length,
+              (unsigned long)body.length);
+    } else {
+        body = payload;
+    }
+    [request setHTTPBody:body];
 
-    NSURLSession *session = [NSURLSession sharedSession];
-
-    if (httpProxySettings.enabled || httpsProxySettings.enabled) {
-        NSDictionary *connectionProxyDictionary = @{
-            @"HTTPEnable"   : [NSNumber numberWithBool:httpProxySettings.enabled],
-            @"HTTPProxy"    : httpProxySettings.proxyUrl,
-            @"HTTPPort"     : [NSNumber numberWithUnsignedInteger:httpProxySettings.proxyPort],
-            @"HTTPSEnable"  : [NSNumber numberWithBool:httpsProxySettings.enabled],
-            @"HTTPSProxy"   : httpsProxySettings.proxyUrl,
-            @"HTTPSPort"    : [NSNumber numberWithUnsignedInteger:httpsProxySettings.proxyPort]
-        };
-
-        NSURLSessionConfiguration *sessionConfig = [NSURLSessionConfiguration ephemeralSessionConfiguration];
-        sessionConfig.connectionProxyDictionary = connectionProxyDictionary;
-        session = [NSURLSession sessionWithConfiguration:sessionConfig];
+    @synchronized (self) {
+        self->_uncompressedBytesCount += payload.length;
+        self->_compressedBytesCount += body.length;
     }
 
+    NSURLSession *session = [RollbarSender sessionWithHttpProxySettings:httpProxySettings
+                                                  andHttpsProxySettings:httpsProxySettings];
+
     RBLog(@"\tSending payload...");
     NSURLSessionDataTask *dataTask = [session dataTaskWithRequest:request
                                                 completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
-        httpResponse = [self checkPayloadResponse:response error:error];
-        dispatch_semaphore_signal(sem);
+        completion([self checkPayloadResponse:response error:error]);
     }];
 
     [dataTask resume];
-
-    dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
-
-    return httpResponse;
 }
 
 - (nullable NSHTTPURLResponse *)checkPayloadResponse:(NSURLResponse *)response error:(NSError *)error {
@@ -17,6 +17,10 @@ NS_ASSUME_NONNULL_BEGIN
 - (RollbarTriStateFlag)sendPayload:(nonnull NSData *)payload
                         withConfig:(nonnull RollbarConfig *)config;
 
+/// Commits any queued payloads still waiting for their group commit.
+/// Blocks until they are on disk, so it can be used as a barrier before shutdown.
+- (void)flushPayloads;
+
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithTarget:(id)target selector:(SEL)selector object:(nullable id)argument NS_UNAVAILABLE;
 - (instancetype)initWithBlock:(void (^)(void))block NS_UNAVAILABLE;
@@ -1,5 +1,9 @@
 @import RollbarCommon;
 
+#if TARGET_OS_IOS | TARGET_OS_TV | TARGET_OS_MACCATALYST
+@import UIKit;
+#endif
+
 #import "RollbarThread.h"
 #import "RollbarReachability.h"
 #import "RollbarTelemetry.h"
@@ -18,14 +22,32 @@
 static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
 // hours-per day * 60 min-per-hour * 60 sec-per-min = 1 day in sec
 
+static NSUInteger const MAX_CACHED_CONFIGS = 16;
+
+// how many payloads are processed before other work queued on the thread gets a turn:
+static NSUInteger const MAX_PAYLOADS_PER_BATCH = 10;
+
+// the shortest a blocked destination is waited for, so that a rate limit window
+// that's already due can't turn into a busy loop:
+static NSTimeInterval const MIN_RETRY_INTERVAL_SECONDS = 1.0;
+
 @implementation RollbarThread {
 @private
-    NSUInteger _maxReportsPerMinute;
     NSTimeInterval _payloadLifetimeInSeconds;
     NSTimer *_timer;
+    BOOL _sendingScheduled;
     NSString *_payloadsRepoFilePath;
     RollbarRegistry *_registry;
     RollbarPayloadRepository *_payloadsRepo;
+    NSTimeInterval _payloadsRepoCommitInterval;
+    NSTimer *_payloadsRepoFlushTimer;
+    NSCache<NSString *, RollbarConfig *> *_configs;
+    RollbarSender *_sender;
+    NSUInteger _maximumRequestsInFlight;
+    NSMutableSet<NSString *> *_payloadsInFlight;
+    NSCountedSet<NSString *> *_destinationsInFlight;
+    NSMutableDictionary<NSString *, NSString *> *_destinationCursors;
+    NSUInteger _nextDestinationIndex;
     
 #if !TARGET_OS_WATCH
     RollbarReachability *_reachability;
@@ -43,9 +65,16 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     if (self) {
         [self setupDataStorage];
         
-        self->_maxReportsPerMinute = 240;
         self->_payloadLifetimeInSeconds = DEFAULT_PAYLOAD_LIFETIME_SECONDS;
         self->_registry = [RollbarRegistry new];
+        self->_configs = [NSCache<NSString *, RollbarConfig *> new];
+        self->_configs.countLimit = MAX_CACHED_CONFIGS;
+        self->_sender = [RollbarSender new];
+        self->_maximumRequestsInFlight = MAX(1, [self developerOptions].maximumRequestsInFlight);
+        self->_payloadsInFlight = [NSMutableSet<NSString *> set];
+        self->_destinationsInFlight = [NSCountedSet<NSString *> set];
+        self->_destinationCursors = [NSMutableDictionary<NSString *, NSString *> dictionary];
+        self->_nextDestinationIndex = 0;
 
 #if !TARGET_OS_WATCH
         self->_reachability = nil;
@@ -65,6 +94,7 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         self->_reachability.reachableBlock = ^(RollbarReachability*reach) {
             [weakSelf captureTelemetryDataForNetwork:true];
             self->_isNetworkReachable = YES;
+            [weakSelf requestSending];
         };
         self->_reachability.unreachableBlock = ^(RollbarReachability*reach) {
             [weakSelf captureTelemetryDataForNetwork:false];
@@ -74,6 +104,19 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         [self->_reachability startNotifier];
 #endif
 
+#if TARGET_OS_IOS | TARGET_OS_TV | TARGET_OS_MACCATALYST
+        // Commit any grouped payload writes before the app may be suspended or killed.
+        // Without blocking the main thread, as this thread may be busy sending:
+        NSNotificationCenter *notificationCenter = [NSNotificationCenter defaultCenter];
+        [notificationCenter addObserver:self
+                               selector:@selector(requestPayloadsFlush)
+                                   name:UIApplicationDidEnterBackgroundNotification
+                                 object:nil];
+        [notificationCenter addObserver:self
+                               selector:@selector(requestPayloadsFlush)
+                                   name:UIApplicationWillTerminateNotification
+                                 object:nil];
+#endif
     }
     
     [self start];
@@ -90,22 +133,28 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     // setup persistent payloads store/repo:
     self->_payloadsRepoFilePath =
     [cachesDirectory stringByAppendingPathComponent:[RollbarNotifierFiles payloadsStore]];
+    RollbarDeveloperOptions *developerOptions = [self developerOptions];
     self->_payloadsRepo =
-    [RollbarPayloadRepository persistentRepositoryWithPath:self->_payloadsRepoFilePath];
+    [RollbarPayloadRepository persistentRepositoryWithPath:self->_payloadsRepoFilePath
+                                                durability:developerOptions.payloadStoreDurability];
+    [self->_payloadsRepo removeUnusedConfigs];
+    if (developerOptions.payloadStoreDurability != RollbarPayloadStoreDurability_Full) {
+        self->_payloadsRepo.groupCommitSize = developerOptions.payloadStoreCommitBatchSize;
+        self->_payloadsRepoCommitInterval = developerOptions.payloadStoreCommitInterval;
+    }
     NSAssert([[NSFileManager defaultManager] fileExistsAtPath:self->_payloadsRepoFilePath],
              @"Persistent payloads store was not created: %@!!!", self->_payloadsRepoFilePath);
 }
 
 - (void)run {
     @autoreleasepool {
-        _timer = [NSTimer timerWithTimeInterval:60.0 / _maxReportsPerMinute
-                                         target:self
-                                       selector:@selector(checkItems)
-                                       userInfo:nil
-                                        repeats:YES];
-        
         NSRunLoop *runLoop = [NSRunLoop currentRunLoop];
-        [runLoop addTimer:_timer forMode:NSDefaultRunLoopMode];
+        
+        // the thread sleeps until there is something to send, so the run loop needs a source to wait on:
+        [runLoop addPort:[NSPort port] forMode:NSDefaultRunLoopMode];
+        
+        // payloads left over from earlier sessions:
+        [self scheduleSending];
         
         while (self.active) {
             [runLoop runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
@@ -284,6 +333,8 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     } @finally {
         [[RollbarTelemetry sharedInstance] clearAllData];
     }
+    
+    [self scheduleSending];
 }
 
 - (void)savePayload:(nonnull RollbarPayload *)payload withConfig:(nonnull RollbarConfig *)config {
@@ -367,29 +418,87 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         return;
     }
 
+    // the payload is stored exactly as it is going to be posted, so sending it later needs no JSON work:
+    NSError *error;
+    NSData *jsonPayload = [NSJSONSerialization rollbar_dataWithJSONObject:payload.jsonFriendlyData
+                                                                  options:0
+                                                                    error:&error
+                                                                     safe:true];
+    if (jsonPayload == nil) {
+        RBErr(@"Couldn't queue payload %@ that can not be serialized", payload.data.uuid);
+        if (error != nil) {
+            RBErr(@"\tError while generating JSON data: %@", error);
+        }
+        return;
+    }
+
     RBLog(@"Queuing %@ (%d in queue)", payload.data.uuid, [self->_payloadsRepo getPayloadCount]);
-    NSString *payloadJson = [payload serializeToJSONString];
-    NSDictionary *payloadDataRow = [self->_payloadsRepo addPayload:payloadJson
-                                                        withConfig:configJson
-                                                  andDestinationID:destinationID];
+    NSDictionary *payloadDataRow = [self->_payloadsRepo addPayloadData:jsonPayload
+                                                            withConfig:configJson
+                                                      andDestinationID:destinationID];
+    if (payload.data.level >= RollbarLevel_Error) {
+        // errors are what a crash tends to follow, so they don't wait for their group:
+        [self flushPayloads_OnlyCallOnThisThread];
+    } else {
+        [self schedulePayloadsFlush];
+    }
     if (!payloadDataRow || !payloadDataRow[@"id"]) {
-        RBErr(@"*** Couldn't add a payload to the repo: %@", payloadJson);
+        RBErr(@"*** Couldn't add a payload to the repo: %@", payload.data.uuid);
         RBErr(@"*** with config: %@", configJson);
         RBErr(@"*** with destinationID: %@", destinationID);
         RBErr(@"*** Resulting payloadDataRow: %@", payloadDataRow);
     }
 
-    NSAssert(payloadDataRow && payloadDataRow[@"id"], @"Couldn't add a payload to the repo: %@", payloadJson);
+    NSAssert(payloadDataRow && payloadDataRow[@"id"], @"Couldn't add a payload to the repo: %@", payload.data.uuid);
 }
 
 #pragma mark - processing persisted payload items
 
+- (void)requestSending {
+    [self performSelector:@selector(scheduleSending)
+                 onThread:self
+               withObject:nil
+            waitUntilDone:NO
+    ];
+}
+
+- (void)scheduleSending {
+    // coalesces bursts of wake-ups into a single pass over the queue:
+    if (self->_sendingScheduled) {
+        return;
+    }
+
+    self->_sendingScheduled = YES;
+    [self performSelector:@selector(checkItems)
+               withObject:nil
+               afterDelay:0];
+}
+
+- (void)scheduleSendingAt:(nonnull NSDate *)date {
+    if (self->_timer) {
+        [self->_timer invalidate];
+        self->_timer = nil;
+    }
+
+    NSDate *earliestDate = [NSDate dateWithTimeIntervalSinceNow:MIN_RETRY_INTERVAL_SECONDS];
+    self->_timer = [[NSTimer alloc] initWithFireDate:[date laterDate:earliestDate]
+                                            interval:0
+                                              target:self
+                                            selector:@selector(scheduleSending)
+                                            userInfo:nil
+                                             repeats:NO];
+    [[NSRunLoop currentRunLoop] addTimer:self->_timer forMode:NSDefaultRunLoopMode];
+}
+
 - (void)checkItems {
+    self->_sendingScheduled = NO;
+
     if (self.cancelled) {
         if (_timer) {
             [_timer invalidate];
             _timer = nil;
         }
+        [self flushPayloads_OnlyCallOnThisThread];
         [NSThread exit];
     }
     
@@ -398,7 +507,7 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     }
 }
 
-- (BOOL)checkProcessStalePayload:(nonnull NSDictionary<NSString *, NSString *> *)payloadDataRow {
+- (BOOL)checkProcessStalePayload:(nonnull NSDictionary<NSString *, id> *)payloadDataRow {
     // let's make sure we are not dealing with a stale payload:
     NSString *timestampValue = payloadDataRow[@"created_at"];
     NSScanner *scanner = [NSScanner scannerWithString:timestampValue];
@@ -410,19 +519,19 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         // we are processing a stale payload let's just drop it and call it done:
         [self removePayloadByID:payloadDataRow[@"id"]];
 
-        RollbarConfig *config = [[RollbarConfig alloc] initWithJSONString:payloadDataRow[@"config_json"]];
+        RollbarConfig *config = [self configFromJSONString:payloadDataRow[@"config_json"]];
         
         if (config && config.developerOptions.logTransmittedPayloads) {
             NSString *payloadsLogFile = config.developerOptions.droppedPayloadsLogFile;
             if (payloadsLogFile && (payloadsLogFile.length > 0)) {
                 NSString *cachesDirectory = [RollbarCachesDirectory directory];
                 NSString *payloadsLogFilePath = [cachesDirectory stringByAppendingPathComponent:payloadsLogFile];
-                RollbarPayload *payload = [[RollbarPayload alloc] initWithJSONString:payloadDataRow[@"payload_json"]];
-                [RollbarFileWriter appendSafelyData: payload.serializeToJSONData toFile:payloadsLogFilePath];
+                [RollbarFileWriter appendSafelyData:[RollbarThread dataOfPayloadRow:payloadDataRow]
+                                             toFile:payloadsLogFilePath];
             }
         }
         
-        RBLog(@"Dropped stale payload: %@", payloadDataRow[@"payload_json"]);
+        RBLog(@"Dropped stale payload %@", payloadDataRow[@"id"]);
 
         return YES;
     }
@@ -430,61 +539,131 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     return NO;
 }
 
-- (void)processSavedPayload:(nonnull NSDictionary<NSString *, NSString *> *)payloadDataRow {
+- (nullable RollbarConfig *)configFromJSONString:(nonnull NSString *)configJson {
+    
+    // queued payloads mostly share a handful of configs, so each of them is only parsed once:
+    RollbarConfig *config = [self->_configs objectForKey:configJson];
+    if (!config) {
+        config = [[RollbarConfig alloc] initWithJSONString:configJson];
+        if (config) {
+            [self->_configs setObject:config forKey:configJson];
+        }
+    }
+    return config;
+}
+
+/// Returns the bytes to post for a queued payload.
+/// Payloads queued by earlier versions are stored as JSON text rather than as data.
++ (nonnull NSData *)dataOfPayloadRow:(nonnull NSDictionary<NSString *, id> *)payloadDataRow {
+    
+    id payload = payloadDataRow[@"payload_json"];
+    if ([payload isKindOfClass:[NSString class]]) {
+        return [(NSString *)payload dataUsingEncoding:NSUTF8StringEncoding];
+    }
+    return payload ?: [NSData data];
+}
+
+/// Returns the payload's UUID for internal logging.
+/// The payload is only parsed if internal logging is on, otherwise its row ID is good enough.
++ (nonnull NSString *)loggableIDOfPayload:(nonnull NSData *)jsonPayload
+                                   withID:(nonnull NSString *)payloadID {
+    
+    if (!RBLogEnabled()) {
+        return payloadID;
+    }
+    RollbarPayload *payload = [[RollbarPayload alloc] initWithJSONData:jsonPayload];
+    return payload.data.uuid ?: payloadID;
+}
+
+/// Returns YES if the payload left the queue or is being sent, NO if it's held back for later.
+- (BOOL)processSavedPayload:(nonnull NSDictionary<NSString *, id> *)payloadDataRow {
     if ([self checkProcessStalePayload:payloadDataRow]) {
-        return;
+        return YES;
     }
 
     NSDictionary<NSString *, NSString *> *destination = [self->_payloadsRepo getDestinationByID:payloadDataRow[@"destination_key"]];
     RollbarDestinationRecord *destinationRecord = [self->_registry getRecordForEndpoint:destination[@"endpoint"]
                                                                          andAccessToken:destination[@"access_token"]];
-    RollbarPayload *payload = [[RollbarPayload alloc] initWithJSONString:payloadDataRow[@"payload_json"]];
-    RollbarConfig *config = [[RollbarConfig alloc] initWithJSONString:payloadDataRow[@"config_json"]];
+    RollbarConfig *config = [self configFromJSONString:payloadDataRow[@"config_json"]];
+    NSString *payloadID = payloadDataRow[@"id"];
+    NSData *jsonPayload = [RollbarThread dataOfPayloadRow:payloadDataRow];
 
     if (![destinationRecord canPostWithConfig:config]) {
         if (self.rateLimitBehavior == RollbarRateLimitBehavior_Drop) {
-            RBLog(@"Processing %@ (%d in queue)", payload.data.uuid, [self->_payloadsRepo getPayloadCount]);
+            NSString *loggableID = [RollbarThread loggableIDOfPayload:jsonPayload withID:payloadID];
+            RBLog(@"Processing %@ (%d in queue)", loggableID, [self->_payloadsRepo getPayloadCount]);
             RBLog(@"\tRate limited");
-            [self removePayloadByID:payloadDataRow[@"id"]];
-            RBLog(@"Dropped %@", payload.data.uuid);
+            [self removePayloadByID:payloadID];
+            RBLog(@"Dropped %@", loggableID);
+            return YES;
         }
-        return;
+        return NO;
     }
 
-    RBLog(@"Processing %@ (%d in queue)", payload.data.uuid, [self->_payloadsRepo getPayloadCount]);
+    if (RBLogEnabled()) {
+        RBLog(@"Processing %@ (%d in queue)",
+              [RollbarThread loggableIDOfPayload:jsonPayload withID:payloadID],
+              [self->_payloadsRepo getPayloadCount]);
+    }
 
-    NSError *error;
-    NSData *jsonPayload = [NSJSONSerialization rollbar_dataWithJSONObject:payload.jsonFriendlyData
-                                                                  options:0
-                                                                    error:&error
-                                                                     safe:true];
-    if (jsonPayload == nil) {
-        RBErr(@"Couldn't send jsonPayload that is nil");
-        if (error != nil) {
-            RBErr(@"\tError while generating JSON data: %@", error);
-        }
-        [self removePayloadByID:payloadDataRow[@"id"]];
-        return;
+    if (0 == jsonPayload.length) {
+        RBErr(@"Couldn't send jsonPayload that is empty");
+        [self removePayloadByID:payloadID];
+        return YES;
     }
 
-    RollbarTriStateFlag result = RollbarTriStateFlag_On;
-    if (config.developerOptions.transmit) {
-        result = [self sendPayload:jsonPayload toDestination:destinationRecord withConfig:config];
+    if (!config.developerOptions.transmit) {
+        [self completeProcessingOfPayload:jsonPayload
+                                    andID:payloadID
+                               withConfig:config
+                                   result:RollbarTriStateFlag_On];
+        return YES;
     }
-    
+
+    // the payload stays queued, but out of the way of further sending, until its reply is in:
+    NSString *destinationID = payloadDataRow[@"destination_key"];
+    [self->_payloadsInFlight addObject:payloadID];
+    [self->_destinationsInFlight addObject:destinationID];
+    [destinationRecord reservePost];
+
+    [self->_sender sendPayload:jsonPayload usingConfig:config completion:^(RollbarPayloadPostReply *reply) {
+        [self performBlock_OnlyCallOnThisThread:^{
+            [self->_payloadsInFlight removeObject:payloadID];
+            [self->_destinationsInFlight removeObject:destinationID];
+
+            [destinationRecord releasePost];
+            [destinationRecord recordPostReply:reply withConfig:config];
+            [self completeProcessingOfPayload:jsonPayload
+                                        andID:payloadID
+                                   withConfig:config
+                                       result:[self resultOfPostReply:reply]];
+
+            // a slot for this destination just opened up, or its next earliest post moved:
+            [self scheduleSending];
+        }];
+    }];
+
+    return YES;
+}
+
+- (void)completeProcessingOfPayload:(nonnull NSData *)jsonPayload
+                              andID:(nonnull NSString *)payloadID
+                         withConfig:(nonnull RollbarConfig *)config
+                             result:(RollbarTriStateFlag)result {
+
     NSString *payloadsLogFile = nil;
 
     switch (result) {
         case RollbarTriStateFlag_On:
             // The payload is fully processed and transmitted.
-            [self removePayloadByID:payloadDataRow[@"id"]];
+            [self removePayloadByID:payloadID];
             if (config.developerOptions.logTransmittedPayloads) {
                 payloadsLogFile = config.developerOptions.transmittedPayloadsLogFile;
             }
             break;
         case RollbarTriStateFlag_Off:
             // The payload is fully processed but not accepted by the server due to some invalid content.
-            [self removePayloadByID:payloadDataRow[@"id"]];
+            [self removePayloadByID:payloadID];
             if (config.developerOptions.logDroppedPayloads) {
                 payloadsLogFile = config.developerOptions.droppedPayloadsLogFile;
             }
@@ -502,26 +681,119 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         [RollbarFileWriter appendSafelyData:jsonPayload toFile:payloadsLogFilePath];
     }
 
-    RBLog([self loggableStringFromPayload:payload result:result]);
+    if (RBLogEnabled()) {
+        RBLog([self loggableStringFromPayload:jsonPayload withID:payloadID result:result]);
+    }
+}
+
+- (void)performBlock_OnlyCallOnThisThread:(nonnull void (^)(void))block {
+    [self performSelector:@selector(runBlock_OnlyCallOnThisThread:)
+                 onThread:self
+               withObject:[block copy]
+            waitUntilDone:NO
+    ];
+}
+
+- (void)runBlock_OnlyCallOnThisThread:(nonnull void (^)(void))block {
+    block();
 }
 
 - (void)processSavedItems {
+    if (self->_timer) {
+        [self->_timer invalidate];
+        self->_timer = nil;
+    }
+
 #if !TARGET_OS_WATCH
     if (!self->_isNetworkReachable) {
         RBLog(@"Processing saved items: no network!");
-        // Don't attempt sending if the network is known to be not reachable
+        // Don't attempt sending if the network is known to be not reachable.
+        // Regaining it schedules sending again:
         return;
     }
 #endif
 
-    NSArray *payloads = [self->_payloadsRepo getPayloadsWithOffset:0 andLimit:5];
-    for (NSDictionary<NSString *, NSString *> *payload in payloads) {
-        @try {
-            [self processSavedPayload:payload];
-        } @catch (NSException *exception) {
-            RBErr(@"Payload processing EXCEPTION: %@", exception);
+    // picks up a reconfigured limit:
+    self->_maximumRequestsInFlight = MAX(1, [self developerOptions].maximumRequestsInFlight);
+
+    // every destination's payloads are sent oldest first until they run out or one is held back,
+    // which means the destination is rate limited or unavailable until its next earliest post.
+    // Destinations take turns: a pass cut short by the batch limit resumes with the next destination,
+    // and the one that was cut resumes from its cursor when its turn comes again:
+    NSDate *nextEarliestPost = nil;
+    NSUInteger batchSize = 0;
+    NSArray<NSDictionary<NSString *, NSString *> *> *destinations = [self->_payloadsRepo getAllDestinations];
+    NSUInteger firstIndex = destinations.count ? self->_nextDestinationIndex % destinations.count : 0;
+    for (NSUInteger i = 0; i < destinations.count; i++) {
+        NSUInteger destinationIndex = (firstIndex + i) % destinations.count;
+        NSDictionary<NSString *, NSString *> *destination = destinations[destinationIndex];
+        NSString *destinationID = destination[@"id"];
+        if (0 == [self->_payloadsRepo getPayloadCountWithDestinationID:destinationID]) {
+            [self->_destinationCursors removeObjectForKey:destinationID];
+            continue;
+        }
+
+        NSString *lastPayloadID = self->_destinationCursors[destinationID] ?: @"0";
+        BOOL isHeldBack = NO;
+        BOOL isBusy = NO;
+        while (!isHeldBack && !isBusy) {
+            NSArray<NSDictionary<NSString *, id> *> *payloads =
+            [self->_payloadsRepo getPayloadsWithDestinationID:destinationID
+                                                      afterID:lastPayloadID
+                                                     andLimit:MAX_PAYLOADS_PER_BATCH];
+            if (0 == payloads.count) {
+                break;
+            }
+
+            for (NSDictionary<NSString *, id> *payload in payloads) {
+                if ([self->_payloadsInFlight containsObject:payload[@"id"]]) {
+                    lastPayloadID = payload[@"id"];
+                    continue;
+                }
+
+                if ([self->_destinationsInFlight countForObject:destinationID] >= self->_maximumRequestsInFlight) {
+                    // the destination's next reply schedules sending again:
+                    isBusy = YES;
+                    break;
+                }
+
+                if (MAX_PAYLOADS_PER_BATCH == batchSize++) {
+                    // let queued work and replies run, then carry on with the next destination:
+                    self->_destinationCursors[destinationID] = lastPayloadID;
+                    self->_nextDestinationIndex = destinationIndex + 1;
+                    [self scheduleSending];
+                    return;
+                }
+                lastPayloadID = payload[@"id"];
+
+                @try {
+                    isHeldBack = ![self processSavedPayload:payload];
+                } @catch (NSException *exception) {
+                    RBErr(@"Payload processing EXCEPTION: %@", exception);
+                    isHeldBack = YES;
+                }
+                if (isHeldBack) {
+                    break;
+                }
+            }
+        }
+
+        // the next turn starts over from the oldest payload, so that ones kept for a retry get their chance:
+        [self->_destinationCursors removeObjectForKey:destinationID];
+
+        if (isHeldBack) {
+            RollbarDestinationRecord *record = [self->_registry getRecordForEndpoint:destination[@"endpoint"]
+                                                                      andAccessToken:destination[@"access_token"]];
+            nextEarliestPost = nextEarliestPost
+            ? [nextEarliestPost earlierDate:record.nextEarliestPost]
+            : record.nextEarliestPost;
         }
     }
+
+    // nothing else can be sent until then, or until a payload is queued or the network comes back:
+    if (nextEarliestPost) {
+        [self scheduleSendingAt:nextEarliestPost];
+    }
 }
 
 - (RollbarTriStateFlag)sendPayload:(nonnull NSData *)payload
@@ -542,9 +814,14 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
         return RollbarTriStateFlag_Off; //obviously invalid payload to sent or invalid destination...
     }
 
-    RollbarPayloadPostReply *reply = [[RollbarSender new] sendPayload:payload usingConfig:config];
+    RollbarPayloadPostReply *reply = [self->_sender sendPayload:payload usingConfig:config];
     [record recordPostReply:reply withConfig:config];
     
+    return [self resultOfPostReply:reply];
+}
+
+- (RollbarTriStateFlag)resultOfPostReply:(nullable RollbarPayloadPostReply *)reply
+{
     if (!reply) {
         return RollbarTriStateFlag_None; // nothing obviously wrong with the payload - just there was no deterministic
                                          // reply from the destination server
@@ -610,20 +887,77 @@ static NSTimeInterval const DEFAULT_PAYLOAD_LIFETIME_SECONDS = 24 * 60 * 60;
     return RollbarInfrastructure.sharedInstance.configuration.loggingOptions.rateLimitBehavior;
 }
 
+- (nonnull RollbarDeveloperOptions *)developerOptions {
+    return RollbarInfrastructure.sharedInstance.configuration.developerOptions ?: [RollbarDeveloperOptions new];
+}
+
 - (void)removePayloadByID:(nonnull NSString *)payloadID {
     if (![self->_payloadsRepo removePayloadByID:payloadID]) {
         RBErr(@"\tCouldn't remove payload data row with ID: %@", payloadID);
     } else {
         RBLog(@"\tRecord dropped");
     }
+    [self schedulePayloadsFlush];
+}
+
+#pragma mark - payloads store group commit
+
+- (void)flushPayloads {
+    if ([NSThread currentThread] == self || !self.executing) {
+        [self flushPayloads_OnlyCallOnThisThread];
+        return;
+    }
+
+    [self performSelector:@selector(flushPayloads_OnlyCallOnThisThread)
+                 onThread:self
+               withObject:nil
+            waitUntilDone:YES
+    ];
+}
+
+- (void)requestPayloadsFlush {
+    [self performSelector:@selector(flushPayloads_OnlyCallOnThisThread)
+                 onThread:self
+               withObject:nil
+            waitUntilDone:NO
+    ];
+}
+
+- (void)flushPayloads_OnlyCallOnThisThread {
+    if (self->_payloadsRepoFlushTimer) {
+        [self->_payloadsRepoFlushTimer invalidate];
+        self->_payloadsRepoFlushTimer = nil;
+    }
+    [self->_payloadsRepo flush];
+}
+
+- (void)schedulePayloadsFlush {
+    // the repo commits by itself once a group is full, this bounds how long a smaller group waits:
+    if (self->_payloadsRepoFlushTimer || !self->_payloadsRepo.hasPendingWrites) {
+        return;
+    }
+
+    // a timer on this thread's run loop wakes the thread by itself, even if nothing else is queued:
+    self->_payloadsRepoFlushTimer =
+    [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceNow:self->_payloadsRepoCommitInterval]
+                             interval:0
+                               target:self
+                             selector:@selector(flushPayloads_OnlyCallOnThisThread)
+                             userInfo:nil
+                              repeats:NO];
+    [[NSRunLoop currentRunLoop] addTimer:self->_payloadsRepoFlushTimer forMode:NSDefaultRunLoopMode];
 }
 
-- (NSString *)loggableStringFromPayload:(RollbarPayload *)payload result:(RollbarTriStateFlag)result {
+- (NSString *)loggableStringFromPayload:(NSData *)jsonPayload
+                                 withID:(NSString *)payloadID
+                                 result:(RollbarTriStateFlag)result {
     NSString *resultString =
         result == RollbarTriStateFlag_On ? @"Transmitted" :
         result == RollbarTriStateFlag_Off ? @"Dropped" : @"Queued";
 
-    return [NSString stringWithFormat:@"%@ %@", resultString, payload.data.uuid];
+    return [NSString stringWithFormat:@"%@ %@",
+            resultString,
+            [RollbarThread loggableIDOfPayload:jsonPayload withID:payloadID]];
 }
 
 #pragma mark - Singleton pattern
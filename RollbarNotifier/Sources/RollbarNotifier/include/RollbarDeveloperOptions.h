@@ -5,6 +5,17 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/// How durably queued payloads are written to the local payloads store
+typedef NS_ENUM(NSInteger, RollbarPayloadStoreDurability) {
+    /// Every write is committed and synced to disk on its own
+    RollbarPayloadStoreDurability_Full,
+    /// Writes are grouped into short transactions and synced at checkpoints,
+    /// so a crash may lose the last few milliseconds of writes, defaults to this
+    RollbarPayloadStoreDurability_Normal,
+    /// Like normal, but never synced, so an OS crash or power loss may lose recent writes
+    RollbarPayloadStoreDurability_Relaxed
+};
+
 /// Models developer settings of a configuration
 @interface RollbarDeveloperOptions : RollbarDTO
 
@@ -37,6 +48,25 @@ NS_ASSUME_NONNULL_BEGIN
 /// Log file to use for  local logged dropped payloads
 @property (nonatomic, readonly, copy) NSString *droppedPayloadsLogFile;
 
+/// How durably queued payloads are written to the local payloads store
+@property (nonatomic, readonly) RollbarPayloadStoreDurability payloadStoreDurability;
+
+/// The maximum number of payload store writes grouped into a single transaction.
+/// Error and critical payloads commit the group right away
+@property (nonatomic, readonly) NSUInteger payloadStoreCommitBatchSize;
+
+/// The longest time, in seconds, a group of payload store writes waits to be committed
+@property (nonatomic, readonly) NSTimeInterval payloadStoreCommitInterval;
+
+/// The maximum number of payloads being posted to the same destination at once
+@property (nonatomic, readonly) NSUInteger maximumRequestsInFlight;
+
+/// Enables/disables gzip compression of the posted payloads
+@property (nonatomic, readonly) BOOL compressPayloads;
+
+/// The smallest payload size, in bytes, that gets compressed when compression is enabled
+@property (nonatomic, readonly) NSUInteger payloadCompressionThreshold;
+
 #pragma mark - initializers
 
 /// Initializer
@@ -106,6 +136,24 @@ NS_ASSUME_NONNULL_BEGIN
 /// Log file to use for  local logged dropped payloads
 @property (nonatomic, readwrite, copy) NSString *droppedPayloadsLogFile;
 
+/// How durably queued payloads are written to the local payloads store
+@property (nonatomic, readwrite) RollbarPayloadStoreDurability payloadStoreDurability;
+
+/// The maximum number of payload store writes grouped into a single transaction
+@property (nonatomic, readwrite) NSUInteger payloadStoreCommitBatchSize;
+
+/// The longest time, in seconds, a group of payload store writes waits to be committed
+@property (nonatomic, readwrite) NSTimeInterval payloadStoreCommitInterval;
+
+/// The maximum number of payloads being posted to the same destination at once
+@property (nonatomic, readwrite) NSUInteger maximumRequestsInFlight;
+
+/// Enables/disables gzip compression of the posted payloads
+@property (nonatomic, readwrite) BOOL compressPayloads;
+
+/// The smallest payload size, in bytes, that gets compressed when compression is enabled
+@property (nonatomic, readwrite) NSUInteger payloadCompressionThreshold;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -53,14 +53,14 @@ public class RollbarCrashDiagnosticFilter: NSObject, RollbarCrashReportFilter {
     /// - Parameter report: The `Report` to diagnose.
     /// - Returns: A new `Report` with the parsed diagnostic information.
     private func diagnose(_ report: Report) -> Result<Report, NSError> {
-        let binaryImagesResult = report.binaryImages
-        guard case let .success(binaryImages) = binaryImagesResult else {
-            return .failure(binaryImagesResult.failure!)
+        let crashReport = CrashReport(report)
+        guard case let .success(binaryImages) = crashReport.binaryImages else {
+            return .failure(crashReport.binaryImages.failure!)
         }
         
-        let crashDiagnostics = report.crash.diagnosis?
+        let crashDiagnostics = crashReport.crash.diagnosis?
             .split(separator: "\n")
-            .map { Diagnostic($0, source: report.crashType) } ?? []
+            .map { Diagnostic($0, source: crashReport.crashType) } ?? []
 
         let dyldDiagnostics = binaryImages
             .filter(!\.crashInfoMessages.isEmpty)
@@ -103,7 +103,7 @@ public class RollbarCrashDiagnosticFilter: NSObject, RollbarCrashReportFilter {
 
 fileprivate extension Report {
 
-    static var requiredKeys = [
+    static let requiredKeys = [
         "crash",
         "report",
         "system",
@@ -38,39 +38,46 @@ import Foundation
 ///         the empty string always becomes an empty line, whereas a `nil` string
 ///         gets ignored by the formatter.
 ///
+/// Formatted text is kept in UTF-8 ``TextBuffer``s rather than `String`s. Sections and
+/// arrays of lines are joined by appending into a single buffer sized up front, and hot
+/// paths like threads, stack frames and binary images write straight into a buffer
+/// instead of building a `String` per line.
+///
 /// - Tag: DSL
 struct Formatted<T> {
-    /// The formatted string.
+    /// The formatted text.
     ///
-    /// An empty string represents an empty line, a nil string represents abscence, and
+    /// An empty text represents an empty line, a nil text represents abscence, and
     /// won't be turned into an empty line, but ignored by nested formatters, or when
-    /// joining a collection of strings or formatters.
-    let string: T?
+    /// joining a collection of texts or formatters.
+    let text: T?
 
-    /// Creates a new instance of a formatted string with the given string.
-    init(string: T?) {
-        self.string = string
+    /// Creates a new instance of a formatted text with the given text.
+    init(text: T?) {
+        self.text = text
     }
 
-    /// Creates a new instance of a formatted multiline string using the ``FormatBuilder``.
+    /// Creates a new instance of a formatted multiline text using the ``FormatBuilder``.
     init(@FormatBuilder<T> format: () -> Formatted<T>) {
-        self.string = format().string
+        self.text = format().text
     }
 }
 
-extension Formatted: CustomStringConvertible where T: StringProtocol {
+extension Formatted: CustomStringConvertible where T == TextBuffer {
     var description: String {
-        "Format {\n\t\(self.string?.replacing("\n", with: "\n\t") ?? "\t.none")\n}"
+        "Format {\n\t\(self.text?.string.replacing("\n", with: "\n\t") ?? "\t.none")\n}"
     }
 }
 
 extension Collection {
 
-    /// Joins a collection of formatted multiline strings into one formatted multiline string.
-    func joined<T: StringProtocol>(
-        separator: T = ""
-    ) -> Formatted<String> where Element == Formatted<T> {
-        .init(string: .init(self.compactMap(\.string).joined(separator: separator)))
+    /// Joins a collection of formatted multiline texts into one formatted multiline text.
+    ///
+    /// The joined text is written into a single buffer, reserved up front.
+    func joined(
+        separator: String = ""
+    ) -> Formatted<TextBuffer> where Element == Formatted<TextBuffer> {
+        .init(text: TextBuffer(joining: self.compactMap(\.text), separator: separator))
     }
 }
 
@@ -139,176 +146,158 @@ extension Optional where Wrapped: StringProtocol {
     }
 }
 
-extension Result where Success == Formatted<String> {
-
-    /// Concatenates two formatted optional strings in a `Result` provided
-    /// both results are a success.
-    @usableFromInline
-    static func *? (lhs: Self, rhs: @autoclosure () -> Self) -> Self {
-        lift(lhs, rhs(), *?)
-    }
-}
-
-extension Formatted where T: StringProtocol {
-
-    /// Concatenates two formatted optional strings.
-    @inlinable
-    static func *? (lhs: Self, rhs: Self) -> Formatted<String> {
-        .init(string: lhs.string *? rhs.string)
-    }
-}
-
-extension Formatted {
-    /// Concatenates two formatted optional strings.
-    @inlinable
-    static func *? <Success: StringProtocol, Failure: Error>(lhs: Self, rhs: Self) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
-        switch (lhs.string, rhs.string) {
-        case let (.failure(failure), _),
-             let (_, .failure(failure)):
-            Formatted<Result<String, Failure>>(string: .failure(failure))
-        case (.none, _),
-             (_, .none):
-            Formatted<Result<String, Failure>>(string: .none)
-        case let (.success(lhs), .success(rhs)):
-            Formatted<Result<String, Failure>>(string: .success(lhs.appending(rhs)))
-        }
-    }
-}
-
-// MARK: - Formatted<String> Builder
+// MARK: - Formatted<TextBuffer> Builder
 
 @resultBuilder
 enum FormatBuilder<T> {}
 
 extension FormatBuilder {
-    static func buildBlock<Success: StringProtocol, Failure: Error>(_ components: Formatted<T>?...) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
+    static func buildBlock<Failure: Error>(_ components: Formatted<T>?...) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
         buildArray(components.compact())
     }
 
-    static func buildOptional<Success: StringProtocol, Failure: Error>(_ component: Formatted<T>?) -> Formatted<Result<Success, Failure>>
-        where T == Result<Success, Failure> {
-        component ?? Formatted(string: .none)
+    static func buildOptional<Failure: Error>(_ component: Formatted<T>?) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+        component ?? Formatted(text: .none)
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(_ expression: ()) -> Formatted<T>
-        where T == Result<Success, Failure> {
-        Formatted(string: .none)
+    static func buildExpression<Failure: Error>(_ expression: ()) -> Formatted<T>
+        where T == Result<TextBuffer, Failure> {
+        Formatted(text: .none)
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(
+    static func buildExpression<Failure: Error>(
         _ expression: Formatted<T>
-    ) -> Formatted<T> where T == Result<Success, Failure> {
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
         expression
     }
-    
-    static func buildExpression<Success: StringProtocol, Failure: Error>(
-        _ expression: Formatted<Success>?
-    ) -> Formatted<T> where T == Result<Success, Failure> {
-        Formatted(string: (expression?.string).map { .success($0) })
+
+    static func buildExpression<Failure: Error>(
+        _ expression: Formatted<TextBuffer>?
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
+        Formatted(text: (expression?.text).map { .success($0) })
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(
-        _ expression: Success?
-    ) -> Formatted<T> where T == Result<Success, Failure> {
-        Formatted(string: expression.map { .success($0) })
+    static func buildExpression<Failure: Error>(
+        _ expression: TextBuffer?
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
+        Formatted(text: expression.map { .success($0) })
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(
+    static func buildExpression<Failure: Error>(
+        _ expression: String?
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
+        Formatted(text: expression.map { .success(TextBuffer($0)) })
+    }
+
+    static func buildExpression<Failure: Error>(
         _ expression: Failure
-    ) -> Formatted<T> where T == Result<Success, Failure> {
-        Formatted(string: .failure(expression))
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
+        Formatted(text: .failure(expression))
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(
-        _ expression: Result<Success, Failure>?
-    ) -> Formatted<T> where T == Result<Success, Failure> {
-        Formatted(string: expression)
+    static func buildExpression<Failure: Error>(
+        _ expression: Result<TextBuffer, Failure>?
+    ) -> Formatted<T> where T == Result<TextBuffer, Failure> {
+        Formatted(text: expression)
     }
 
-    static func buildEither<Success: StringProtocol, Failure: Error>(first component: Formatted<T>?) -> Formatted<Result<Success, Failure>>
-        where T == Result<Success, Failure> {
-        component ?? Formatted(string: .none)
+    static func buildEither<Failure: Error>(first component: Formatted<T>?) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+        component ?? Formatted(text: .none)
     }
 
-    static func buildEither<Success: StringProtocol, Failure: Error>(second component: Formatted<T>?) -> Formatted<T>
-        where T == Result<Success, Failure> {
-        component ?? Formatted(string: .none)
+    static func buildEither<Failure: Error>(second component: Formatted<T>?) -> Formatted<T>
+        where T == Result<TextBuffer, Failure> {
+        component ?? Formatted(text: .none)
     }
 
-    static func buildArray<Success: StringProtocol, Failure: Error>(_ components: [Formatted<T>]) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
-        if let failure = components.compactMap(\.string?.failure).first {
-            return .init(string: .failure(failure))
+    static func buildArray<Failure: Error>(_ components: [Formatted<T>]) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+        var buffers: [TextBuffer] = []
+        buffers.reserveCapacity(components.count)
+        for component in components {
+            switch component.text {
+            case let .failure(failure)?:
+                return .init(text: .failure(failure))
+            case let .success(buffer)?:
+                buffers.append(buffer)
+            case .none:
+                continue
+            }
         }
-        return Formatted(string: .success(components.compactMap(\.string?.success).joined(separator: "\n")))
+        return Formatted(text: .success(TextBuffer(joining: buffers, separator: "\n")))
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(_ expression: Report.Map?) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
-        Formatted(string: (expression?.description).map { .success($0) })
+    static func buildExpression<Failure: Error>(_ expression: Report.Map?) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+        Formatted(text: (expression?.description).map { .success(TextBuffer($0)) })
     }
 
-    static func buildExpression<Success: StringProtocol, Failure: Error>(_ expression: Diagnostic?) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
-        Formatted(string: (expression?.description).map { .success($0) })
+    static func buildExpression<Failure: Error>(_ expression: Diagnostic?) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+        Formatted(text: (expression?.description).map { .success(TextBuffer($0)) })
     }
-    
-    static func buildExpression<S: CustomStringConvertible, Success: StringProtocol, Failure: Error>(_ expression: [S]?) -> Formatted<Result<String, Failure>>
-        where T == Result<Success, Failure> {
-            Formatted(string: (expression?.map(\.description).joined(separator: "\n")).map { .success($0) })
+
+    static func buildExpression<S: CustomStringConvertible, Failure: Error>(_ expression: [S]?) -> Formatted<Result<TextBuffer, Failure>>
+        where T == Result<TextBuffer, Failure> {
+            Formatted(text: expression.map { .success(TextBuffer(lines: $0)) })
     }
 }
 
-extension FormatBuilder where T: StringProtocol {
-    static func buildBlock(_ components: Formatted<T>?...) -> Formatted<String> {
+extension FormatBuilder where T == TextBuffer {
+    static func buildBlock(_ components: Formatted<T>?...) -> Formatted<TextBuffer> {
         components.compact().joined(separator: "\n")
     }
 
     static func buildOptional(_ component: Formatted<T>?) -> Formatted<T> {
-        component ?? .init(string: .none)
+        component ?? .init(text: .none)
     }
 
     static func buildEither(first component: Formatted<T>?) -> Formatted<T> {
-        component ?? .init(string: .none)
+        component ?? .init(text: .none)
     }
 
     static func buildEither(second component: Formatted<T>?) -> Formatted<T> {
-        component ?? .init(string: .none)
+        component ?? .init(text: .none)
     }
 
-    static func buildArray(_ components: [Formatted<T>]) -> Formatted<String> {
+    static func buildArray(_ components: [Formatted<T>]) -> Formatted<TextBuffer> {
         components.joined(separator: "\n")
     }
 
     static func buildExpression(_ expression: ()) -> Formatted<T> {
-        .init(string: .none)
+        .init(text: .none)
     }
 
     static func buildExpression(_ expression: T?) -> Formatted<T> {
-        .init(string: expression)
+        .init(text: expression)
+    }
+
+    static func buildExpression(_ expression: String?) -> Formatted<T> {
+        .init(text: expression.map { TextBuffer($0) })
     }
 
-    static func buildExpression(_ expression: [T]?) -> Formatted<String> {
-        .init(string: expression?.joined(separator: "\n"))
+    static func buildExpression(_ expression: [String]?) -> Formatted<TextBuffer> {
+        .init(text: expression.map { TextBuffer(lines: $0) })
     }
 
     static func buildExpression(_ expression: Formatted<T>?) -> Formatted<T> {
-        expression ?? .init(string: .none)
+        expression ?? .init(text: .none)
     }
 
-    static func buildExpression(_ expression: Report.Map?) -> Formatted<String> {
-        .init(string: expression?.description)
+    static func buildExpression(_ expression: Report.Map?) -> Formatted<TextBuffer> {
+        .init(text: (expression?.description).map { TextBuffer($0) })
     }
 
-    static func buildExpression(_ expression: Diagnostic?) -> Formatted<String> {
-        .init(string: expression?.description)
+    static func buildExpression(_ expression: Diagnostic?) -> Formatted<TextBuffer> {
+        .init(text: (expression?.description).map { TextBuffer($0) })
     }
 
     static func buildExpression<S>(
         _ expression: [S]?
-    ) -> Formatted<String> where S: CustomStringConvertible {
-        .init(string: expression?.map(\.description).joined(separator: "\n"))
+    ) -> Formatted<TextBuffer> where S: CustomStringConvertible {
+        .init(text: expression.map { TextBuffer(lines: $0) })
     }
 }
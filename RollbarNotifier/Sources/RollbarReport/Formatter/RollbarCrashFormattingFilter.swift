@@ -23,14 +23,14 @@ public class RollbarCrashFormattingFilter: NSObject, RollbarCrashReportFilter {
         onCompletion complete: RollbarCrashReportFilterCompletion?
     ) -> () {
         let formattedResults = (reports ?? []).map { report in
-            validated(report).map(format)
+            validated(report).map { format(CrashReport($0)) }
         }.map {
-            $0.flatMap { formatted -> Result<Formatted<String>, NSError> in
-                switch formatted.string {
+            $0.flatMap { formatted -> Result<Formatted<TextBuffer>, NSError> in
+                switch formatted.text {
                 case .none:
-                    .success(Formatted(string: nil))
-                case let .success(string):
-                    .success(Formatted(string: string))
+                    .success(Formatted(text: nil))
+                case let .success(text):
+                    .success(Formatted(text: text))
                 case let .failure(error):
                     .failure(error)
                 }
@@ -38,7 +38,7 @@ public class RollbarCrashFormattingFilter: NSObject, RollbarCrashReportFilter {
         }
 
         complete?(
-            /*reports:*/formattedResults.compactMap(\.success?.string).map(NSString.init),
+            /*reports:*/formattedResults.compactMap(\.success?.text?.string).map(NSString.init),
             /*didFinish:*/formattedResults.allSatisfy(\.isSuccess),
             /*error:*/formattedResults.first(where: \.isFailure)?.failure)
     }
@@ -69,14 +69,12 @@ public class RollbarCrashFormattingFilter: NSObject, RollbarCrashReportFilter {
 fileprivate extension RollbarCrashFormattingFilter {
 
     /// Returns a formatted string with the formatted crash report.
-    func format(_ report: Report) -> Formatted<Result<String, NSError>> {
+    func format(_ report: CrashReport) -> Formatted<Result<TextBuffer, NSError>> {
         .init {
             header(for: report, system: report.system)
             error(for: report)
             diagnostics(for: report, exception: report.exception)
-            for thread in report.crash.threads {
-                threadInfo(for: thread, process: report.system.processName)
-            }
+            threads(for: report.crash.threads, process: report.system.processName)
             if let crashedThread = report.crash.crashedThread {
                 cpuState(for: crashedThread, cpu: report.system.cpu)
             }
@@ -85,7 +83,7 @@ fileprivate extension RollbarCrashFormattingFilter {
             if let recrash = report.recrashReport {
                 "\nHandler crashed while reporting:\n"
                 error(for: recrash)
-                if let process = recrash.report?.processName,
+                if let process = recrash.info?.processName,
                    let recrashedThread = recrash.crash.crashedThread
                 {
                     threadInfo(for: recrashedThread, process: process)
@@ -118,9 +116,9 @@ fileprivate extension RollbarCrashFormattingFilter {
     /// OS Version:          iOS 16.3 (20D47)
     /// Report Version:      104
     /// ```
-    func header(for report: Report, system: Report.Map) -> Formatted<String> {
+    func header(for report: CrashReport, system: CrashReport.System) -> Formatted<TextBuffer> {
         .init {
-            "Incident Identifier: " *? report.reportId.uuidString
+            "Incident Identifier: " *? (report.info?.id ?? .empty).uuidString
             "CrashReporter Key:   " *? system.deviceAppHash
             "Hardware Model:      " *? system.machine
             "Process:             " *? system.processName *? " [" *? system.processId *? "]"
@@ -130,7 +128,7 @@ fileprivate extension RollbarCrashFormattingFilter {
             "Code Type:           " *? system.cpu.typeName
             "Parent Process:      " *? system.parentProcessName *? " [" *? system.parentProcessId *? "]"
             ""
-            "Date/Time:           " *? report.reportTimestamp?.iso8601String
+            "Date/Time:           " *? report.info?.timestamp?.iso8601String
             "OS Version:          " *? system.systemName *? " " *? system.systemVersion *? " (" *? system.osVersion *? ")"
             "Report Version:      104"
         }
@@ -145,7 +143,7 @@ fileprivate extension RollbarCrashFormattingFilter {
     /// Exception Codes:    0x0000000000000000, 0x0000000000000000
     /// Termination Reason: SIGNAL 6
     /// ```
-    func error(for report: Report) -> Formatted<String> {
+    func error(for report: CrashReport) -> Formatted<TextBuffer> {
         let error = report.crash.error
         let (mach, signal) = (error?.mach, error?.signal)
 
@@ -184,7 +182,7 @@ fileprivate extension RollbarCrashFormattingFilter {
     ///     ...
     /// }
     /// ```
-    func diagnostics(for report: Report, exception: Report.Map?) -> Formatted<Result<String, NSError>> {
+    func diagnostics(for report: CrashReport, exception: CrashReport.Exception?) -> Formatted<Result<TextBuffer, NSError>> {
         .init {
             "\nApplication Specific Information:"
             "*** Terminating app due to uncaught exception '" *? exception?.name *? "' , reason: '" *? exception?.reason *? "'"
@@ -229,7 +227,7 @@ fileprivate extension RollbarCrashFormattingFilter {
             if let stats = report.system.appStats {
                 "\nApplication Stats:"
                 "{"
-                for stat in stats.sorted(by: their(\.key)) {
+                for stat in stats {
                     "\t\(stat.key): \(stat.value)"
                 }
                 "}"
@@ -237,23 +235,61 @@ fileprivate extension RollbarCrashFormattingFilter {
         }
     }
 
+    /// Formats every thread of a crash together with their stack traces.
+    ///
+    /// All the threads are written into a single buffer, sized for their frames up front.
+    func threads(for threads: [CrashReport.Thread], process: String) -> Formatted<Result<TextBuffer, NSError>> {
+        let lineCount = threads.reduce(0) { $0 + $1.backtraceContents.count + 3 }
+        var text = TextBuffer(capacity: lineCount * Self.estimatedLineLength)
+
+        for (n, thread) in threads.enumerated() {
+            if n > 0 { text.write("\n") }
+            if let error = writeThread(thread, process: process, into: &text) {
+                return .init(text: .failure(error))
+            }
+        }
+
+        return .init(text: .success(text))
+    }
+
     /// Formats a thread together with its stack trace.
+    func threadInfo(for thread: CrashReport.Thread, process: String) -> Formatted<Result<TextBuffer, NSError>> {
+        var text = TextBuffer(capacity: (thread.backtraceContents.count + 3) * Self.estimatedLineLength)
+
+        if let error = writeThread(thread, process: process, into: &text) {
+            return .init(text: .failure(error))
+        }
+
+        return .init(text: .success(text))
+    }
+
+    /// Writes a thread together with its stack trace, preceded by an empty line.
     ///
     /// Example:
     /// ```
+    ///
     /// Thread 3 name:  com.apple.uikit.eventfetch-thread
     /// Thread 3:
     /// 0   libsystem_kernel.dylib          0x00000001b05422ac mach_msg2_trap + 8
     /// ...
     /// 11  libsystem_pthread.dylib         0x00000001b059e4e4 _pthread_start + 116
     /// ```
-    func threadInfo(for thread: Report.Map, process: String) -> Formatted<Result<String, NSError>> {
-        .init {
-            ""
-            "Thread \(thread.index)" *? " name:  " *? thread.threadName
-            "Thread \(thread.index)\(thread.crashed ? " Crashed:" : ":")"
-            backtrace(for: thread.backtraceContents, process: process)
+    ///
+    /// - Returns: The error that stopped the stack trace from being written, if any.
+    func writeThread(_ thread: CrashReport.Thread, process: String, into text: inout TextBuffer) -> NSError? {
+        text.write("\n")
+        if let threadName = thread.threadName {
+            text.write("Thread ")
+            text.write(thread.index)
+            text.write(" name:  ")
+            text.write(threadName)
+            text.write("\n")
         }
+        text.write("Thread ")
+        text.write(thread.index)
+        text.write(thread.crashed ? " Crashed:" : ":")
+        text.write("\n")
+        return writeBacktrace(thread.backtraceContents, process: process, into: &text)
     }
 
     /// Formats a backtrace.
@@ -264,41 +300,75 @@ fileprivate extension RollbarCrashFormattingFilter {
     /// ...
     /// 11  libsystem_pthread.dylib         0x00000001b059e4e4 _pthread_start + 116
     /// ```
-    func backtrace(for backtrace: [Frame], process: String) -> Formatted<Result<String, NSError>> {
-        .init {
-            for (n, frame) in backtrace.enumerated() {
-                let index = "\(n)".pad(3)
-
-                switch frame {
-                case let .instruction(addr):
-                    "\(index) \("?".pad(31)) \(addr) ? + \(addr.value)"
-
-                case let .symbolicated(frame) where frame.object.name == process:
-                    let preamble = "\(index) \(frame.object.name.pad(31)) \(frame.instructionAddr)"
-                    if let offset = frame.instructionAddr - frame.object.addr.value {
-                        "\(preamble) \(frame.object.addr) + \(offset.value)"
-                    } else {
-                        .invalidAddress()
-                    }
-
-                case let .symbolicated(frame):
-                    let preamble = "\(index) \(frame.object.name.pad(31)) \(frame.instructionAddr)"
-                    if let offset = frame.instructionAddr - frame.symbol.addr.value {
-                        "\(preamble) \(frame.symbol.name) + \(offset.value)"
-                    } else {
-                        .invalidAddress()
-                    }
-
-                case let .unsymbolicated(frame):
-                    let preamble = "\(index) \(frame.object.name.pad(31)) \(frame.instructionAddr)"
-                    if let offset = frame.instructionAddr - frame.object.addr.value {
-                        "\(preamble) \(frame.object.addr) + \(offset.value)"
-                    } else {
-                        .invalidAddress()
-                    }
+    ///
+    /// Frames are the bulk of a report, so they're written straight into a single buffer
+    /// rather than going through the DSL one `String` at a time.
+    func backtrace(for backtrace: [Frame], process: String) -> Formatted<Result<TextBuffer, NSError>> {
+        var text = TextBuffer(capacity: backtrace.count * Self.estimatedLineLength)
+
+        if let error = writeBacktrace(backtrace, process: process, into: &text) {
+            return .init(text: .failure(error))
+        }
+
+        return .init(text: .success(text))
+    }
+
+    /// Writes a backtrace, one frame per line.
+    ///
+    /// - Returns: The error that stopped the backtrace from being written, if any.
+    func writeBacktrace(_ backtrace: [Frame], process: String, into text: inout TextBuffer) -> NSError? {
+        for (n, frame) in backtrace.enumerated() {
+            if n > 0 { text.write("\n") }
+            text.write(UInt(n), pad: 3)
+            text.write(" ")
+
+            switch frame {
+            case let .instruction(addr):
+                text.write("?", pad: 31)
+                text.write(" ")
+                text.write(addr)
+                text.write(" ? + ")
+                text.write(addr.value)
+
+            case let .symbolicated(frame) where frame.object.name == process:
+                guard let offset = frame.instructionAddr - frame.object.addr.value else {
+                    return NSError.invalidAddress()
+                }
+                text.write(frame.object.name, pad: 31)
+                text.write(" ")
+                text.write(frame.instructionAddr)
+                text.write(" ")
+                text.write(frame.object.addr)
+                text.write(" + ")
+                text.write(offset.value)
+
+            case let .symbolicated(frame):
+                guard let offset = frame.instructionAddr - frame.symbol.addr.value else {
+                    return NSError.invalidAddress()
                 }
+                text.write(frame.object.name, pad: 31)
+                text.write(" ")
+                text.write(frame.instructionAddr)
+                text.write(" ")
+                text.write(frame.symbol.name)
+                text.write(" + ")
+                text.write(offset.value)
+
+            case let .unsymbolicated(frame):
+                guard let offset = frame.instructionAddr - frame.object.addr.value else {
+                    return NSError.invalidAddress()
+                }
+                text.write(frame.object.name, pad: 31)
+                text.write(" ")
+                text.write(frame.instructionAddr)
+                text.write(" ")
+                text.write(frame.object.addr)
+                text.write(" + ")
+                text.write(offset.value)
             }
         }
+
+        return nil
     }
 
     /// Formats a thread's registers.
@@ -317,12 +387,12 @@ fileprivate extension RollbarCrashFormattingFilter {
     ///     sp: 0x000000016f048bf0   pc: 0x000000018b87eac4 cpsr: 0x60000000
     ///    far: 0x000000016b2dfff0  esr: 0xf2000001 (Breakpoint) brk 1
     /// ```
-    func cpuState(for thread: Report.Map, cpu: CPU) -> Formatted<String> {
+    func cpuState(for thread: CrashReport.Thread, cpu: CPU) -> Formatted<TextBuffer> {
         .init {
             "\nThread \(thread.index) crashed with \(cpu.typeName) Thread State:"
 
             for chunk in cpu.registers.chunks(of: 4) {
-                chunk.map { "\($0.pad(-6)): " *? thread.registersState[$0] }
+                chunk.map { "\($0.pad(-6)): " *? thread.register($0) }
                     .compact().joined(separator: " ")
             }
         }
@@ -338,25 +408,42 @@ fileprivate extension RollbarCrashFormattingFilter {
     /// ...
     /// 0x01b05ad000 - 0x01b05adfff  libsystem_sim_pthread_host.dylib arm64  <2544ef58c14d30b1a9fcce9d35e10cb0> /Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform/Library/Developer/CoreSimulator/Profiles/Runtimes/iOS.simruntime/Contents/Resources/RuntimeRoot/usr/lib/system/libsystem_sim_pthread_host.dylib
     /// ```
-    func binaryImages(for report: Report) -> Formatted<String>? {
-        guard case let .success(binaryImages) = report.binaryImages else {
+    func binaryImages(for report: CrashReport) -> Formatted<TextBuffer>? {
+        guard report.binaryImages.isSuccess else {
             return nil
         }
-        return Formatted {
-            "\nBinary Images:"
-            for img in binaryImages.sorted(by: their(\.addr.start)) {
-                let cpu = img.cpu.subtypeName
-                let uuid = img.uuid.uuidString.replacingOccurrences(of: "-", with: "").lowercased()
-                let isMain = img.path == report.system.bundleExecutablePath ? "+" : " "
-                "\(img.addr.start) - \(img.addr.end) \(isMain)\(img.name) \(cpu)  <\(uuid)> \(img.path.absoluteString)"
-            }
+        let executablePath = report.system.bundleExecutablePath
+        var text = TextBuffer(capacity: (report.images.images.count + 1) * Self.estimatedLineLength * 2)
+
+        text.write("\nBinary Images:\n")
+        for (n, img) in report.images.images.enumerated() {
+            if n > 0 { text.write("\n") }
+            text.write(img.addr.start)
+            text.write(" - ")
+            text.write(img.addr.end)
+            text.write(img.path == executablePath ? " +" : "  ")
+            text.write(img.name)
+            text.write(" ")
+            text.write(img.cpu.subtypeName)
+            text.write("  <")
+            text.write(compact: img.uuid)
+            text.write("> ")
+            text.write(img.path.absoluteString)
         }
+
+        return Formatted(text: text)
     }
 }
 
+fileprivate extension RollbarCrashFormattingFilter {
+
+    /// A rough length of a formatted frame line, used to reserve output space.
+    static let estimatedLineLength = 128
+}
+
 fileprivate extension Report {
 
-    static var requiredKeys = [
+    static let requiredKeys = [
         "crash",
         "report",
         "system",
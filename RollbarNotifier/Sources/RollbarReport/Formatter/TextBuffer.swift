@@ -0,0 +1,159 @@
+import Foundation
+
+/// A UTF-8 byte buffer that formatted text is streamed into.
+///
+/// Writing into a buffer with enough reserved capacity doesn't allocate, and that includes
+/// the space-padded columns and zero-padded hexadecimal addresses crash reports are made of.
+/// Padding follows `StringProtocol.pad(_:with:)` exactly, so the output is byte-for-byte
+/// the same as building it out of `String`s.
+struct TextBuffer: TextOutputStream {
+    /// The UTF-8 encoded contents of this buffer.
+    private(set) var utf8: [UInt8] = []
+
+    /// Creates an empty buffer with room for the given number of bytes.
+    init(capacity: Int = 0) {
+        self.utf8.reserveCapacity(capacity)
+    }
+
+    /// Creates a new buffer holding the given string.
+    init(_ string: String) {
+        self.utf8.reserveCapacity(string.utf8.count)
+        self.write(string)
+    }
+
+    /// Creates a new buffer by joining the given buffers with the given separator.
+    ///
+    /// The whole result is reserved up front, so joining allocates only once.
+    init(joining buffers: [TextBuffer], separator: String) {
+        self.init(capacity: buffers.reduce(separator.utf8.count * max(buffers.count - 1, 0)) { $0 + $1.count })
+        for (n, buffer) in buffers.enumerated() {
+            if n > 0 { self.write(separator) }
+            self.write(buffer)
+        }
+    }
+
+    /// Creates a new buffer holding the given strings, one per line.
+    ///
+    /// The whole result is reserved up front, so this allocates only once.
+    init(lines strings: [String]) {
+        self.init(capacity: strings.reduce(max(strings.count - 1, 0)) { $0 + $1.utf8.count })
+        for (n, string) in strings.enumerated() {
+            if n > 0 { self.write("\n") }
+            self.write(string)
+        }
+    }
+
+    /// Creates a new buffer holding the descriptions of the given values, one per line.
+    init<S: Sequence>(lines values: S) where S.Element: CustomStringConvertible {
+        self.init(capacity: values.underestimatedCount)
+        for (n, value) in values.enumerated() {
+            if n > 0 { self.write("\n") }
+            self.write(value.description)
+        }
+    }
+
+    /// The number of bytes in this buffer.
+    var count: Int { self.utf8.count }
+
+    /// The contents of this buffer as a `String`.
+    var string: String { String(decoding: self.utf8, as: UTF8.self) }
+
+    /// Reserves enough space to store the given number of bytes.
+    mutating func reserveCapacity(_ capacity: Int) {
+        self.utf8.reserveCapacity(capacity)
+    }
+
+    /// Appends the given string.
+    mutating func write(_ string: String) {
+        let utf8 = string.utf8
+        if utf8.withContiguousStorageIfAvailable({ self.utf8.append(contentsOf: $0) }) == nil {
+            self.utf8.append(contentsOf: utf8)
+        }
+    }
+
+    /// Appends the contents of another buffer.
+    mutating func write(_ buffer: TextBuffer) {
+        self.utf8.append(contentsOf: buffer.utf8)
+    }
+
+    /// Appends the given ASCII character the given number of times.
+    mutating func write(_ ascii: Unicode.Scalar, count: Int) {
+        self.utf8.append(contentsOf: repeatElement(UInt8(ascii: ascii), count: count))
+    }
+
+    /// Appends the given string padded with spaces, as in `string.pad(len)`.
+    ///
+    /// Use negative values to produce a left-padded string.
+    mutating func write(_ string: String, pad len: Int) {
+        let padding = abs(abs(len) - string.count)
+        if len < 0 { self.write(" ", count: padding) }
+        self.write(string)
+        if len >= 0 { self.write(" ", count: padding) }
+    }
+
+    /// Appends the given integer in decimal, padded with spaces, as in `"\(value)".pad(len)`.
+    mutating func write(_ value: UInt, pad len: Int = 0) {
+        let digits = Self.digitCount(value, radix: 10)
+        let padding = len == 0 ? 0 : abs(abs(len) - digits)
+        if len < 0 { self.write(" ", count: padding) }
+        self.writeDigits(value, radix: 10, count: digits)
+        if len > 0 { self.write(" ", count: padding) }
+    }
+
+    /// Appends the given signed integer in decimal, as in `"\(value)"`.
+    mutating func write(_ value: Int) {
+        if value < 0 { self.write("-") }
+        self.writeDigits(value.magnitude, radix: 10, count: Self.digitCount(value.magnitude, radix: 10))
+    }
+
+    /// Appends the given address, as in `address.description`.
+    mutating func write(_ address: Address) {
+        let digits = Self.digitCount(address.value, radix: 16)
+        self.write("0x")
+        self.write("0", count: abs(address.size * 2 - digits))
+        self.writeDigits(address.value, radix: 16, count: digits)
+    }
+
+    /// Appends the given UUID as 32 lowercase hexadecimal digits without dashes.
+    mutating func write(compact uuid: UUID) {
+        var bytes = uuid.uuid
+        withUnsafeBytes(of: &bytes) { bytes in
+            for byte in bytes {
+                self.writeDigits(UInt(byte), radix: 16, count: 2)
+            }
+        }
+    }
+
+    /// Appends the given number of trailing digits of a value in the given radix.
+    private mutating func writeDigits(_ value: UInt, radix: UInt, count: Int) {
+        let start = self.utf8.count
+        self.utf8.append(contentsOf: repeatElement(UInt8(ascii: "0"), count: count))
+
+        var value = value
+        var index = start + count
+        while value > 0 && index > start {
+            index -= 1
+            let digit = UInt8(value % radix)
+            self.utf8[index] = digit < 10 ? UInt8(ascii: "0") + digit : UInt8(ascii: "a") + digit - 10
+            value /= radix
+        }
+    }
+
+    /// Returns the number of digits needed to write the given value in the given radix.
+    private static func digitCount(_ value: UInt, radix: UInt) -> Int {
+        var count = 1
+        var value = value / radix
+        while value > 0 {
+            count += 1
+            value /= radix
+        }
+        return count
+    }
+}
+
+extension TextBuffer: CustomStringConvertible {
+
+    var description: String {
+        self.string
+    }
+}
@@ -0,0 +1,48 @@
+import Foundation
+
+/// The binary images of a crash report, sorted by address so that the image an
+/// address falls into can be found by binary search.
+///
+/// Reports routinely carry hundreds of images and thousands of frames, so the index
+/// is built once per report and shared by everything that needs to map addresses
+/// back to images, making each lookup O(log images) instead of a linear scan.
+struct BinaryImageIndex {
+    /// The binary images, sorted by their starting address.
+    let images: [BinaryImage]
+
+    /// An empty index, for reports without valid binary images.
+    static let empty = BinaryImageIndex([])
+
+    /// Returns a new index over the given binary images.
+    init(_ images: [BinaryImage]) {
+        self.images = images.sorted(by: their(\.addr.start))
+    }
+
+    /// Returns the binary image whose address range contains the given address,
+    /// or `nil` if the address doesn't belong to any image.
+    ///
+    /// Images aren't expected to overlap. If they do, the one starting closest
+    /// below the address wins.
+    func image(containing address: Address) -> BinaryImage? {
+        let value = address.value
+
+        // Find the first image starting past the address; its predecessor is the candidate.
+        var low = 0
+        var high = self.images.count
+        while low < high {
+            let mid = low + (high - low) / 2
+            if self.images[mid].addr.start.value <= value {
+                low = mid + 1
+            } else {
+                high = mid
+            }
+        }
+
+        guard low > 0 else {
+            return nil
+        }
+
+        let image = self.images[low - 1]
+        return value <= image.addr.end.value ? image : nil
+    }
+}
@@ -0,0 +1,337 @@
+import Darwin.POSIX
+import Foundation
+
+/// A typed crash report, decoded once from a raw `Report` dictionary.
+///
+/// Every `Report` accessor walks nested dictionaries, splits dotted keys and casts
+/// dynamically on each access. A `CrashReport` pays that cost once, up front, and
+/// keeps threads, frames, images and registers in plain arrays so that consumers
+/// like the formatter can read them as many times as they need.
+struct CrashReport {
+    /// The report section, `root.report`.
+    let info: Info?
+
+    /// The system section, `root.system`.
+    let system: System
+
+    /// The process section, `root.process`.
+    let process: Process?
+
+    /// The crash section, `root.crash`.
+    let crash: Crash
+
+    /// The binary images loaded at the time of the crash, or an error if any
+    /// of them is invalid.
+    let binaryImages: Result<[BinaryImage], NSError>
+
+    /// The binary images indexed by address, or an empty index if any of them is invalid.
+    let images: BinaryImageIndex
+
+    /// The report of the crash that happened while handling the original crash.
+    var recrashReport: CrashReport? { self.recrash?.value }
+
+    private let recrash: Indirect<CrashReport>?
+
+    /// Decodes a new `CrashReport` from the given raw `Report`.
+    init(_ report: Report) {
+        self.info = report.report.map { Info($0) }
+        self.system = System(report.system)
+        self.process = report.process.map { Process($0) }
+        self.crash = Crash(report.crash)
+        let binaryImages = report.binaryImages
+        self.binaryImages = binaryImages
+        self.images = binaryImages.success.map { BinaryImageIndex($0) } ?? .empty
+        self.recrash = report.recrashReport.map { Indirect(CrashReport($0)) }
+    }
+
+    /// Allows `CrashReport` to hold another `CrashReport`.
+    private final class Indirect<T> {
+        let value: T
+
+        init(_ value: T) {
+            self.value = value
+        }
+    }
+}
+
+// MARK: - Report | root
+
+extension CrashReport {
+
+    var crashType: Report.CrashType {
+        self.crash.error?.type ?? .unknown
+    }
+
+    /// The first thread in `crash.threads` flagged as crashed.
+    var crashedThread: Thread? {
+        self.crash.threads.first(where: \.crashed)
+    }
+
+    var exception: Exception? {
+        self.crash.error?.nsexception
+        ?? self.process?.lastDeallocedNSException
+        ?? self.crash.error?.cppException
+        ?? self.crash.error?.userReported
+    }
+
+    var exceptionType: Report.ExceptionType? {
+        guard let error = self.crash.error else {
+            return .none
+        }
+
+        if error.nsexception != nil { return .ns }
+        else if self.isZombieNSException { return .zombie }
+        else if error.cppException != nil { return .cpp }
+        else if error.userReported != nil { return .user }
+        else { return .none }
+    }
+
+    private var isZombieNSException: Bool {
+        let mach = self.crash.error?.mach
+
+        guard
+            mach?.exceptionName == "EXC_BAD_ACCESS" && mach?.codeName == "KERN_INVALID_ADDRESS",
+            let address = self.process?.lastDeallocedNSException?.address,
+            let crashedThread = self.crashedThread
+        else {
+            return false
+        }
+
+        return crashedThread.registers.contains { $0.value == address }
+    }
+}
+
+// MARK: - Info | root.report
+
+extension CrashReport {
+
+    struct Info {
+        let id: UUID
+        let timestamp: Timestamp?
+        let version: String
+        let processName: String
+
+        init(_ info: Report.Map) {
+            self.id = info[String.self, "id"].flatMap(UUID.init(uuidString:)) ?? .empty
+            self.timestamp = info[String.self, "timestamp"].flatMap(Timestamp.init(rfc3339String:))
+            self.version = info[any: "version", default: "unknown"]
+            self.processName = info.processName
+        }
+    }
+}
+
+// MARK: - System | root.system
+
+extension CrashReport {
+
+    struct System {
+        /// Application stats, sorted by key.
+        let appStats: [(key: String, value: Any)]?
+
+        let bundleIdentifier: String?
+        let bundleVersion: String?
+        let bundleShortVersion: String?
+        let bundleExecutablePath: URL?
+
+        let processName: String
+        let processId: Int?
+        let parentProcessName: String
+        let parentProcessId: Int?
+
+        let deviceAppHash: String?
+        let systemName: String?
+        let systemVersion: String?
+        let osVersion: String?
+        let machine: String?
+
+        let cpu: CPU
+
+        init(_ system: Report.Map) {
+            self.appStats = system.appStats?.sorted(by: their(\.key))
+            self.bundleIdentifier = system.bundleIdentifier
+            self.bundleVersion = system.bundleVersion
+            self.bundleShortVersion = system.bundleShortVersion
+            self.bundleExecutablePath = system.bundleExecutablePath
+            self.processName = system.processName
+            self.processId = system.processId
+            self.parentProcessName = system.parentProcessName
+            self.parentProcessId = system.parentProcessId
+            self.deviceAppHash = system.deviceAppHash
+            self.systemName = system.systemName
+            self.systemVersion = system.systemVersion
+            self.osVersion = system.osVersion
+            self.machine = system.machine
+            self.cpu = system.cpu
+        }
+    }
+}
+
+// MARK: - Process | root.process
+
+extension CrashReport {
+
+    struct Process {
+        let lastDeallocedNSException: Exception?
+
+        init(_ process: Report.Map) {
+            self.lastDeallocedNSException = process.lastDeallocedNSException.map { Exception($0) }
+        }
+    }
+}
+
+// MARK: - Crash | root.crash
+
+extension CrashReport {
+
+    struct Crash {
+        let error: ErrorInfo?
+        let threads: [Thread]
+
+        /// The thread stored under `crash.crashed_thread`, as recrash reports do.
+        let crashedThread: Thread?
+
+        let diagnosis: String?
+        let diagnostics: [Diagnostic]
+
+        init(_ crash: Report.Map) {
+            self.error = crash.error.map { ErrorInfo($0) }
+            self.threads = crash.threads.map { Thread($0) }
+            self.crashedThread = crash[Report.Map.self, "crashed_thread"].map { Thread($0) }
+            self.diagnosis = crash.diagnosis
+            self.diagnostics = crash.diagnostics
+        }
+    }
+}
+
+// MARK: - Error | root.crash.error
+
+extension CrashReport {
+
+    struct ErrorInfo {
+        let type: Report.CrashType
+        let address: Address?
+        let mach: Mach?
+        let signal: Signal?
+        let nsexception: Exception?
+        let cppException: Exception?
+        let userReported: Exception?
+
+        init(_ error: Report.Map) {
+            self.type = error[String.self, "type"].flatMap(Report.CrashType.init(rawValue:)) ?? .unknown
+            self.address = error.address
+            self.mach = error.mach.map { Mach($0) }
+            self.signal = error.signal.map { Signal($0) }
+            self.nsexception = error[Report.Map.self, "nsexception"].map { Exception($0) }
+            self.cppException = error[Report.Map.self, "cpp_exception"].map { Exception($0) }
+            self.userReported = error[Report.Map.self, "user_reported"].map { Exception($0) }
+        }
+    }
+
+    struct Mach {
+        let exceptionName: String
+        let codeName: String
+        let code: Address?
+        let subcode: Address?
+
+        init(_ mach: Report.Map) {
+            self.exceptionName = mach.exceptionName
+            self.codeName = mach.codeName
+            self.code = mach.code
+            self.subcode = mach.subcode
+        }
+    }
+
+    struct Signal {
+        let signalName: String
+        let signalCode: Int?
+
+        init(_ signal: Report.Map) {
+            self.signalName = signal.signalName
+            self.signalCode = signal.signalCode
+        }
+    }
+}
+
+// MARK: - Exception | root.crash.error.exception
+
+extension CrashReport {
+
+    struct Exception {
+        let name: String?
+        let reason: String?
+        let address: Address?
+        let referencedObject: Report.Map?
+        let lineOfCode: String?
+        let userBacktrace: [String]?
+        let backtraceContents: [Frame]
+
+        init(_ exception: Report.Map) {
+            self.name = exception.name
+            self.reason = exception.reason
+            self.address = exception.address
+            self.referencedObject = exception.referencedObject
+            self.lineOfCode = exception.lineOfCode
+            self.userBacktrace = exception.userBacktrace
+            self.backtraceContents = exception.backtraceContents
+        }
+    }
+}
+
+// MARK: - Threads | root.crash.threads[n]
+
+extension CrashReport {
+
+    struct Thread {
+        let index: Int
+        let name: String?
+        let dispatchQueue: String?
+        let crashed: Bool
+        let backtraceContents: [Frame]
+        let registers: [Register]
+        let stack: StackDump?
+        let notableAddresses: Report.Map?
+
+        init(_ thread: Report.Map) {
+            self.index = thread.index
+            self.name = thread.name
+            self.dispatchQueue = thread.dispatchQueue
+            self.crashed = thread.crashed
+            self.backtraceContents = thread.backtraceContents
+            self.registers = thread.basicRegisters.map {
+                Register(name: $0.key, value: .memory($0.value as? UInt ?? 0))
+            }
+            self.stack = thread.stack.map { StackDump($0) }
+            self.notableAddresses = thread.notableAddresses
+        }
+
+        var threadName: String? {
+            switch (self.name, self.dispatchQueue) {
+            case (.some(let name), _): return name
+            case (_, .some(let name)): return "Dispatch queue: \(name)"
+            case _: return .none
+            }
+        }
+
+        /// Returns the value of the register with the given name.
+        func register(_ name: String) -> Address? {
+            self.registers.first(where: { $0.name == name })?.value
+        }
+    }
+
+    struct Register {
+        let name: String
+        let value: Address
+    }
+
+    struct StackDump {
+        let dumpStart: Address?
+        let dumpEnd: Address?
+        let contents: String?
+
+        init(_ stack: Report.Map) {
+            self.dumpStart = stack.dumpStart
+            self.dumpEnd = stack.dumpEnd
+            self.contents = stack.contents
+        }
+    }
+}
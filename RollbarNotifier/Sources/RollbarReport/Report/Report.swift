@@ -4,7 +4,8 @@ import Foundation
 /// A `Report` is just a dictionary where its keys are a `String` and its values `Any`.
 ///
 /// The typealias provides no type guarantees and its only purpose is to provide context at
-/// the point of use.
+/// the point of use. Accessors re-walk the dictionary on every call, decode a `CrashReport`
+/// when the same values are read repeatedly.
 @usableFromInline
 typealias Report = [String: Any]
 
@@ -55,28 +56,6 @@ extension Report {
         self[any: "index", default: -1]
     }
 
-    var crashType: CrashType {
-        self.crash.error?[any: "type"].flatMap(CrashType.init) ?? .unknown
-    }
-
-    var exception: Map? {
-        self[any: "crash.error.nsexception"]
-        ?? self[any: "process.last_dealloced_nsexception"]
-        ?? self[any: "crash.error.cpp_exception"]
-        ?? self[any: "crash.error.user_reported"]
-    }
-
-    var exceptionType: ExceptionType? {
-        guard let error = self.crash.error?.keys else {
-            return .none
-        }
-
-        if error.contains("nsexception") { return .ns }
-        else if self.isZombieNSException { return .zombie }
-        else if error.contains("cpp_exception") { return .cpp }
-        else if error.contains("user_reported") { return .user }
-        else { return .none }
-    }
 }
 
 // MARK: - System | root.system
@@ -121,11 +100,6 @@ extension Report {
         get { self[any: "diagnostics", default: []].compactMap(Diagnostic.init) }
         set { self["diagnostics"] = newValue.map(\.rawValue) }
     }
-
-    var crashedThread: Map? {
-        self.crash.threads.first(where: \.crashed)
-        ?? self[any: "crashed_thread"]
-    }
 }
 
 // MARK: - Error | root.crash.error
@@ -167,22 +141,12 @@ extension Report {
         self[any: "crashed", default: false]
     }
 
-    var threadName: String? {
-        switch (self.name, self.dispatchQueue) {
-        case (.some(let name), _): return name
-        case (_, .some(let name)): return "Dispatch queue: \(name)"
-        case _: return .none
-        }
-    }
-
     var dispatchQueue: String? {
         self[any: "dispatch_queue"]
     }
 
-    var registersState: [AnyHashable: Address] {
-        self[Map.self, "registers.basic", default: [:]].mapValues {
-            .memory($0 as? UInt ?? 0)
-        }
+    var basicRegisters: Map {
+        self[any: "registers.basic", default: [:]]
     }
 
     var stack: Map? { self[any: "stack"]}
@@ -197,25 +161,6 @@ extension Report {
     }
 }
 
-// MARK: -
-
-extension Report {
-
-    fileprivate var isZombieNSException: Bool {
-        let mach = self.crash.error?.mach
-
-        guard
-            mach?.exceptionName == "EXC_BAD_ACCESS" && mach?.codeName == "KERN_INVALID_ADDRESS",
-            let address = self.process?.lastDeallocedNSException?.address,
-            let crashedThread = self.crash.threads.first(where: \.crashed)
-        else {
-            return false
-        }
-
-        return crashedThread.registersState.values.contains(address)
-    }
-}
-
 extension Dictionary where Key == String, Value: Any {
 
     @usableFromInline
@@ -0,0 +1,196 @@
+//
+//  RollbarCrashAppStateTests.c
+//
+//  Plain C tests of the memory-mapped app state record, runnable on Linux with `make test`.
+//  Every launch of the app runs in a child process, so nothing but the record survives it.
+//
+
+#include "RollbarCrashMonitor_AppState.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** What a launch does once the state is loaded. */
+typedef enum
+{
+    LaunchEnd_Terminate,
+    LaunchEnd_Crash,
+} LaunchEnd;
+
+/** The persisted state a launch is expected to start with. */
+typedef struct
+{
+    bool crashedLastLaunch;
+    int launchesSinceLastCrash;
+    int sessionsSinceLastCrash;
+} ExpectedState;
+
+static char g_statePath[256];
+static char g_legacyStatePath[256];
+
+
+/** Run one launch of the app in a child process.
+ *
+ * @param backgroundings How many times the app goes to the background and back.
+ *
+ * @return true if the launch saw the expected state.
+ */
+static bool launch(ExpectedState expected, int backgroundings, LaunchEnd end)
+{
+    fflush(stderr);
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        // only this launch's own checks decide its exit status:
+        g_failures = 0;
+        rcstate_notifyObjCLoad();
+        rcstate_initialize(g_statePath, g_legacyStatePath);
+        rcm_appstate_getAPI()->setEnabled(true);
+
+        const RollbarCrash_AppState* state = rcstate_currentState();
+        CHECK(state->crashedLastLaunch == expected.crashedLastLaunch);
+        CHECK(state->launchesSinceLastCrash == expected.launchesSinceLastCrash);
+        CHECK(state->sessionsSinceLastCrash == expected.sessionsSinceLastCrash);
+
+        for(int i = 0; i < backgroundings; i++)
+        {
+            rcstate_notifyAppActive(false);
+            rcstate_notifyAppInForeground(false);
+            rcstate_notifyAppInForeground(true);
+            rcstate_notifyAppActive(true);
+        }
+        CHECK(state->sessionsSinceLaunch == 1 + backgroundings);
+
+        if(end == LaunchEnd_Crash)
+        {
+            rcstate_notifyAppCrash();
+        }
+        else
+        {
+            rcstate_notifyAppTerminate();
+        }
+        // no exit handlers, no flushing: the process just goes away, as it does on a crash:
+        _exit(g_failures > 0 ? 1 : 0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/** Overwrite part of the state file. */
+static void patchStateFile(long offset, const void* bytes, size_t length)
+{
+    FILE* file = fopen(g_statePath, "r+b");
+    CHECK(file != NULL);
+    if(file != NULL)
+    {
+        fseek(file, offset, SEEK_SET);
+        fwrite(bytes, 1, length, file);
+        fclose(file);
+    }
+}
+
+/** Corrupt the slot holding the latest generation, as an update torn by the process dying would. */
+static void tearLatestSlot(void)
+{
+    // header: magic (4 bytes), version (2), slot size (2), then two slots starting with their generation:
+    FILE* file = fopen(g_statePath, "rb");
+    CHECK(file != NULL);
+    if(file == NULL)
+    {
+        return;
+    }
+    uint16_t slotSize = 0;
+    uint64_t generations[2] = {0};
+    fseek(file, 6, SEEK_SET);
+    fread(&slotSize, sizeof(slotSize), 1, file);
+    for(int i = 0; i < 2; i++)
+    {
+        fseek(file, 8 + i * slotSize, SEEK_SET);
+        fread(&generations[i], sizeof(generations[i]), 1, file);
+    }
+    fclose(file);
+
+    const int latest = generations[1] > generations[0] ? 1 : 0;
+    const uint8_t garbage = 0xA5;
+    patchStateFile(8 + latest * slotSize + 8, &garbage, 1);
+}
+
+static void removeStateFiles(void)
+{
+    unlink(g_statePath);
+    unlink(g_legacyStatePath);
+}
+
+
+static void testStatePersistsAcrossLaunches(void)
+{
+    removeStateFiles();
+    CHECK(launch((ExpectedState){false, 1, 1}, 2, LaunchEnd_Terminate));
+    CHECK(launch((ExpectedState){false, 2, 4}, 0, LaunchEnd_Terminate));
+    CHECK(launch((ExpectedState){false, 3, 5}, 1, LaunchEnd_Crash));
+    // a crash starts the counts over:
+    CHECK(launch((ExpectedState){true, 1, 1}, 0, LaunchEnd_Terminate));
+    CHECK(launch((ExpectedState){false, 2, 2}, 0, LaunchEnd_Terminate));
+}
+
+static void testTornUpdateKeepsThePreviousState(void)
+{
+    removeStateFiles();
+    CHECK(launch((ExpectedState){false, 1, 1}, 0, LaunchEnd_Terminate));
+    CHECK(launch((ExpectedState){false, 2, 2}, 0, LaunchEnd_Crash));
+    tearLatestSlot();
+    // the crash was the torn update, so the state from before it is used:
+    CHECK(launch((ExpectedState){false, 3, 3}, 0, LaunchEnd_Terminate));
+}
+
+static void testIncompatibleRecordIsReset(void)
+{
+    removeStateFiles();
+    CHECK(launch((ExpectedState){false, 1, 1}, 0, LaunchEnd_Crash));
+    const uint16_t version = 99;
+    patchStateFile(4, &version, sizeof(version));
+    CHECK(launch((ExpectedState){false, 1, 1}, 0, LaunchEnd_Terminate));
+    CHECK(launch((ExpectedState){false, 2, 2}, 0, LaunchEnd_Terminate));
+}
+
+static void testLegacyStateIsMigrated(void)
+{
+    removeStateFiles();
+    FILE* file = fopen(g_legacyStatePath, "w");
+    CHECK(file != NULL);
+    if(file == NULL)
+    {
+        return;
+    }
+    fputs("{\"version\":1,\"crashedLastLaunch\":false,\"activeDurationSinceLastCrash\":12.5,"
+          "\"backgroundDurationSinceLastCrash\":3,\"launchesSinceLastCrash\":5,\"sessionsSinceLastCrash\":7}",
+          file);
+    fclose(file);
+
+    CHECK(launch((ExpectedState){false, 6, 8}, 0, LaunchEnd_Terminate));
+    CHECK(access(g_legacyStatePath, F_OK) != 0);
+    CHECK(launch((ExpectedState){false, 7, 9}, 0, LaunchEnd_Terminate));
+}
+
+
+int main(void)
+{
+    const char* directory = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    snprintf(g_statePath, sizeof(g_statePath), "%s/RollbarCrashAppStateTests-%d.bin", directory, (int)getpid());
+    snprintf(g_legacyStatePath, sizeof(g_legacyStatePath), "%s/RollbarCrashAppStateTests-%d.json", directory, (int)getpid());
+
+    testStatePersistsAcrossLaunches();
+    testTornUpdateKeepsThePreviousState();
+    testIncompatibleRecordIsReset();
+    testLegacyStateIsMigrated();
+
+    removeStateFiles();
+    return reportChecks("app state");
+}
@@ -0,0 +1,117 @@
+//
+//  RollbarCrashArenaTests.c
+//
+//  Plain C tests of the crash scratch arena, runnable on Linux with `make test`.
+//
+
+#include "RollbarCrashArena.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ARENA_SIZE 4096
+
+
+static void testAllocatesNothingBeforeInitialization(void)
+{
+    rcarena_begin();
+    CHECK(rcarena_alloc(16) == NULL);
+    rcarena_end();
+}
+
+static void testAllocationsAreAlignedAndZeroed(void)
+{
+    rcarena_begin();
+    uint8_t* first = rcarena_alloc(3);
+    uint8_t* second = rcarena_alloc(40);
+    CHECK(first != NULL && second != NULL);
+    CHECK(((uintptr_t)first % 16) == 0);
+    CHECK(((uintptr_t)second % 16) == 0);
+    CHECK(second - first == 16);
+    for(int i = 0; i < 40; i++)
+    {
+        CHECK(second[i] == 0);
+    }
+    memset(second, 0xAB, 40);
+    rcarena_end();
+
+    rcarena_begin();
+    uint8_t* reused = rcarena_alloc(64);
+    CHECK(reused == first);
+    for(int i = 0; i < 64; i++)
+    {
+        CHECK(reused[i] == 0);
+    }
+    rcarena_end();
+}
+
+static void testExhaustionReturnsNull(void)
+{
+    rcarena_begin();
+    CHECK(rcarena_alloc(ARENA_SIZE + 1) == NULL);
+    CHECK(rcarena_alloc(ARENA_SIZE - 32) != NULL);
+    CHECK(rcarena_alloc(32) != NULL);
+    CHECK(rcarena_alloc(1) == NULL);
+    rcarena_end();
+
+    rcarena_begin();
+    CHECK(rcarena_alloc(ARENA_SIZE) != NULL);
+    rcarena_end();
+}
+
+static void testNestedScopesRewindOnlyAtTheOuterEnd(void)
+{
+    rcarena_begin();
+    char* outer = rcarena_alloc(16);
+    rcarena_begin();
+    char* inner = rcarena_alloc(16);
+    rcarena_end();
+    char* afterInner = rcarena_alloc(16);
+    CHECK(inner == outer + 16);
+    CHECK(afterInner == inner + 16);
+    rcarena_end();
+
+    rcarena_begin();
+    CHECK(rcarena_alloc(16) == outer);
+    rcarena_end();
+}
+
+static void testStrdupCopiesTheString(void)
+{
+    rcarena_begin();
+    const char* original = "EXC_BAD_ACCESS";
+    char* copy = rcarena_strdup(original);
+    CHECK_STRING(original, copy);
+    CHECK(copy != original);
+    CHECK(rcarena_strdup("") != NULL);
+    rcarena_end();
+}
+
+static void testUnbalancedEndIsIgnored(void)
+{
+    rcarena_end();
+    rcarena_begin();
+    char* first = rcarena_alloc(16);
+    rcarena_end();
+    rcarena_begin();
+    CHECK(rcarena_alloc(16) == first);
+    rcarena_end();
+}
+
+
+int main(void)
+{
+    testAllocatesNothingBeforeInitialization();
+    CHECK(rcarena_initialize(ARENA_SIZE));
+    CHECK(rcarena_initialize(ARENA_SIZE * 2));
+
+    testAllocationsAreAlignedAndZeroed();
+    testExhaustionReturnsNull();
+    testNestedScopesRewindOnlyAtTheOuterEnd();
+    testStrdupCopiesTheString();
+    testUnbalancedEndIsIgnored();
+
+    return reportChecks("crash arena");
+}
@@ -0,0 +1,116 @@
+//
+//  RollbarCrashDiagnosisTests.c
+//
+//  Plain C tests of the crash diagnosis rules, runnable on Linux with `make test`.
+//
+
+#include "RollbarCrashDiagnosis.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static char* g_fixture;
+static int g_fixtureLength;
+
+static char* loadFile(const char* path, int* length)
+{
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char* data = malloc((size_t)size);
+    if(data != NULL && fread(data, 1, (size_t)size, file) != (size_t)size)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *length = (int)size;
+    return data;
+}
+
+/** A copy of the fixture with one exception name swapped for another of the same length. */
+static char* fixtureWithExceptionName(const char* exceptionName)
+{
+    static const char field[] = "\"exception_name\" : \"EXC_BREAKPOINT\"";
+    char* report = malloc((size_t)g_fixtureLength + 1);
+    memcpy(report, g_fixture, (size_t)g_fixtureLength);
+    report[g_fixtureLength] = '\0';
+    char* name = strstr(report, field);
+    if(name != NULL && strlen(exceptionName) == strlen("EXC_BREAKPOINT"))
+    {
+        memcpy(name + strlen("\"exception_name\" : \""), exceptionName, strlen(exceptionName));
+    }
+    return report;
+}
+
+
+static void testBreakpointHasNoDiagnosis(void)
+{
+    char* diagnosis = NULL;
+    char* recrashDiagnosis = NULL;
+    CHECK(rcdiag_diagnoseReport(g_fixture, g_fixtureLength, &diagnosis, &recrashDiagnosis));
+    CHECK_STRING(NULL, diagnosis);
+    CHECK_STRING(NULL, recrashDiagnosis);
+    free(diagnosis);
+    free(recrashDiagnosis);
+}
+
+static void testBadAccessIsGarbagePointer(void)
+{
+    char* report = fixtureWithExceptionName("EXC_BAD_ACCESS");
+    char* diagnosis = NULL;
+    CHECK(rcdiag_diagnoseReport(report, g_fixtureLength, &diagnosis, NULL));
+    CHECK_STRING("Attempted to dereference garbage pointer 0x18b87eac4.\n"
+                 "Originated at or in a subcall of Example.forceUnwrapNil()", diagnosis);
+    free(diagnosis);
+    free(report);
+}
+
+static void testArithmeticIsMathError(void)
+{
+    char* report = fixtureWithExceptionName("EXC_ARITHMETIC");
+    char* diagnosis = NULL;
+    CHECK(rcdiag_diagnoseReport(report, g_fixtureLength, &diagnosis, NULL));
+    CHECK_STRING("Math error (usually caused from division by 0).\n"
+                 "Originated at or in a subcall of Example.forceUnwrapNil()", diagnosis);
+    free(diagnosis);
+    free(report);
+}
+
+static void testTruncatedReportIsStillDiagnosed(void)
+{
+    char* report = fixtureWithExceptionName("EXC_BAD_ACCESS");
+    char* diagnosis = NULL;
+    CHECK(!rcdiag_diagnoseReport(report, g_fixtureLength - 16, &diagnosis, NULL));
+    CHECK(diagnosis != NULL && strncmp(diagnosis, "Attempted to dereference", 24) == 0);
+    free(diagnosis);
+    free(report);
+}
+
+
+int main(int argc, const char* argv[])
+{
+    const char* fixturePath = argc > 1 ? argv[1] : "../RollbarReportTests/Assets/crash.json";
+    g_fixture = loadFile(fixturePath, &g_fixtureLength);
+    if(g_fixture == NULL)
+    {
+        fprintf(stderr, "Could not load %s\n", fixturePath);
+        return 1;
+    }
+
+    testBreakpointHasNoDiagnosis();
+    testBadAccessIsGarbagePointer();
+    testArithmeticIsMathError();
+    testTruncatedReportIsStillDiagnosed();
+
+    free(g_fixture);
+    return reportChecks("crash diagnosis");
+}
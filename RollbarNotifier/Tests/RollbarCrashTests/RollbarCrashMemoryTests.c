@@ -0,0 +1,118 @@
+//
+//  RollbarCrashMemoryTests.c
+//
+//  Plain C tests of safe memory reads and the page cache, runnable on Linux with `make test`.
+//  Pages are remapped between reads to stand in for an app that carries on after a report.
+//
+
+#include "RollbarCrashMemory.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define PAGE_SIZE 4096
+
+/** The page under test, followed by a page that is never readable. */
+static char* g_page;
+
+
+static void mapPage(int protection)
+{
+    if(g_page == NULL)
+    {
+        g_page = mmap(NULL, PAGE_SIZE * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    mmap(g_page, PAGE_SIZE, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if(protection & PROT_WRITE)
+    {
+        memset(g_page, 'a', PAGE_SIZE);
+    }
+}
+
+
+static void testReadsWithoutTheCache(void)
+{
+    char buffer[16];
+    mapPage(PROT_READ | PROT_WRITE);
+    CHECK(rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    CHECK(buffer[0] == 'a');
+    CHECK(rcmem_maxReadableBytes(g_page + PAGE_SIZE - 8, 16) == 8);
+
+    mapPage(PROT_NONE);
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    CHECK(!rcmem_isMemoryReadable(g_page, 1));
+}
+
+static void testBatchReadsEachRegionOnItsOwn(void)
+{
+    char readable[PAGE_SIZE];
+    memset(readable, 'b', sizeof(readable));
+    mapPage(PROT_NONE);
+
+    char buffers[3][8];
+    RollbarCrashMemoryCopy copies[3] =
+    {
+        {.src = readable, .dst = buffers[0], .byteCount = 8},
+        {.src = g_page, .dst = buffers[1], .byteCount = 8},
+        {.src = readable + 8, .dst = buffers[2], .byteCount = 8},
+    };
+    CHECK(rcmem_copySafelyBatch(copies, 3) == 2);
+    CHECK(copies[0].wasCopied && !copies[1].wasCopied && copies[2].wasCopied);
+    CHECK(buffers[0][0] == 'b' && buffers[2][7] == 'b');
+}
+
+/** While enabled, the cache is trusted over the real mapping: that's what saves the system calls. */
+static void testCacheRemembersPages(void)
+{
+    char buffer[16];
+    mapPage(PROT_NONE);
+    rcmem_enablePageCache();
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+
+    mapPage(PROT_READ | PROT_WRITE);
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    rcmem_disablePageCache();
+}
+
+static void testDisablingForgetsRememberedPages(void)
+{
+    char buffer[16];
+
+    // a page that was unreadable during one report is read again in the next:
+    mapPage(PROT_NONE);
+    rcmem_enablePageCache();
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    rcmem_disablePageCache();
+    mapPage(PROT_READ | PROT_WRITE);
+    rcmem_enablePageCache();
+    CHECK(rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    CHECK(buffer[0] == 'a');
+    rcmem_disablePageCache();
+
+    // a page that was readable during one report is probed again, not trusted, once it's gone:
+    rcmem_enablePageCache();
+    CHECK(rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    rcmem_disablePageCache();
+    mapPage(PROT_NONE);
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    rcmem_enablePageCache();
+    CHECK(!rcmem_copySafely(g_page, buffer, sizeof(buffer)));
+    RollbarCrashMemoryCopy copy = {.src = g_page, .dst = buffer, .byteCount = 8};
+    CHECK(rcmem_copySafelyBatch(&copy, 1) == 0);
+    rcmem_disablePageCache();
+}
+
+
+int main(void)
+{
+    testReadsWithoutTheCache();
+    testBatchReadsEachRegionOnItsOwn();
+    testCacheRemembersPages();
+    testDisablingForgetsRememberedPages();
+
+    munmap(g_page, PAGE_SIZE * 2);
+    return reportChecks("memory");
+}
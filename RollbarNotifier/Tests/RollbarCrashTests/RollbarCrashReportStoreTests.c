@@ -0,0 +1,145 @@
+//
+//  RollbarCrashReportStoreTests.c
+//
+//  Plain C tests of paging through the report store, runnable on Linux with `make test`.
+//
+
+#include "RollbarCrashReportStore.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define REPORT_COUNT 10
+
+static char g_reportsPath[256];
+
+/** Report IDs as written, deliberately not in order. */
+static const int64_t g_reportIDs[REPORT_COUNT] = {0x70, 0x10, 0x90, 0x30, 0xa0, 0x20, 0x50, 0x80, 0x40, 0x60};
+
+
+static void writeFile(const char* name)
+{
+    char path[RollbarCrashCRS_MAX_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s", g_reportsPath, name);
+    FILE* file = fopen(path, "w");
+    if(file != NULL)
+    {
+        fputs("{}", file);
+        fclose(file);
+    }
+}
+
+static void writeReports(void)
+{
+    for(int i = 0; i < REPORT_COUNT; i++)
+    {
+        char name[100];
+        snprintf(name, sizeof(name), "Test-report-%016llx.json", (long long)g_reportIDs[i]);
+        writeFile(name);
+    }
+    // files that aren't this app's reports are never listed:
+    writeFile("Other-report-0000000000000005.json");
+    writeFile("notes.txt");
+}
+
+/** Page through every report, checking that all pages come back complete and in order. */
+static void checkPaging(int pageSize)
+{
+    int64_t page[REPORT_COUNT + 1];
+    int64_t afterID = 0;
+    int64_t expectedID = 0x10;
+    int pageCount = 0;
+    for(;;)
+    {
+        int count = rccrs_getReportIDsAfter(afterID, page, pageSize);
+        if(count == 0)
+        {
+            break;
+        }
+        pageCount++;
+        int remaining = REPORT_COUNT - (int)(expectedID / 0x10 - 1);
+        CHECK(count == (remaining < pageSize ? remaining : pageSize));
+        for(int i = 0; i < count; i++)
+        {
+            CHECK(page[i] == expectedID);
+            expectedID += 0x10;
+        }
+        afterID = page[count - 1];
+        if(pageCount > REPORT_COUNT)
+        {
+            break;
+        }
+    }
+    CHECK(expectedID == 0x10 * (REPORT_COUNT + 1));
+    CHECK(pageCount == (REPORT_COUNT + pageSize - 1) / pageSize);
+}
+
+
+static void testPagesOfEverySize(void)
+{
+    checkPaging(1);
+    checkPaging(3);
+    // exactly fills the last page:
+    checkPaging(5);
+    checkPaging(REPORT_COUNT);
+    checkPaging(REPORT_COUNT + 1);
+}
+
+static void testCursorBoundaries(void)
+{
+    int64_t page[REPORT_COUNT];
+
+    // a cursor between two IDs starts at the next one:
+    CHECK(rccrs_getReportIDsAfter(0x35, page, 2) == 2);
+    CHECK(page[0] == 0x40 && page[1] == 0x50);
+
+    // the cursor itself is never listed again:
+    CHECK(rccrs_getReportIDsAfter(0x90, page, REPORT_COUNT) == 1);
+    CHECK(page[0] == 0xa0);
+
+    CHECK(rccrs_getReportIDsAfter(0xa0, page, REPORT_COUNT) == 0);
+    CHECK(rccrs_getReportIDsAfter(INT64_MAX, page, REPORT_COUNT) == 0);
+}
+
+static void testEmptyPages(void)
+{
+    int64_t page[1] = {-1};
+    CHECK(rccrs_getReportIDsAfter(0, page, 0) == 0);
+    CHECK(rccrs_getReportIDsAfter(0, page, -1) == 0);
+    CHECK(page[0] == -1);
+}
+
+static void testDeletedReportsLeaveThePage(void)
+{
+    int64_t page[REPORT_COUNT];
+    rccrs_deleteReportWithID(0x10);
+    rccrs_deleteReportWithID(0x20);
+    CHECK(rccrs_getReportIDsAfter(0, page, 2) == 2);
+    CHECK(page[0] == 0x30 && page[1] == 0x40);
+
+    rccrs_deleteAllReports();
+    CHECK(rccrs_getReportIDsAfter(0, page, REPORT_COUNT) == 0);
+}
+
+
+int main(void)
+{
+    const char* directory = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    snprintf(g_reportsPath, sizeof(g_reportsPath), "%s/RollbarCrashReportStoreTests-%d", directory, (int)getpid());
+
+    rccrs_setMaxReportCount(REPORT_COUNT + 2);
+    rccrs_initialize("Test", g_reportsPath);
+    writeReports();
+
+    testPagesOfEverySize();
+    testCursorBoundaries();
+    testEmptyPages();
+    testDeletedReportsLeaveThePage();
+
+    rmdir(g_reportsPath);
+    return reportChecks("report store");
+}
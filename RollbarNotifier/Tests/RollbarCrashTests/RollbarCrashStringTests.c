@@ -0,0 +1,204 @@
+//
+//  RollbarCrashStringTests.c
+//
+//  Plain C tests of the UTF-8 string check, runnable on Linux with `make test`.
+//  The 16-byte fast path must agree with the byte by byte check it skips ahead of.
+//  `make test` also builds these tests without SSE2, to cover the portable fallback.
+//
+
+#include "RollbarCrashString.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_SIZE 96
+
+
+/** The check as it was before the fast path: one character at a time. */
+static bool scalarIsNullTerminatedUTF8String(const void* memory, int minLength, int maxLength)
+{
+    static const int continuationByteCount[0x40] =
+    {
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+        2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+        3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 0, 0,
+    };
+    const unsigned char* ptr = memory;
+    const unsigned char* const end = ptr + maxLength;
+
+    for(; ptr < end; ptr++)
+    {
+        unsigned char ch = *ptr;
+        if(ch == 0)
+        {
+            return (ptr - (const unsigned char*)memory) >= minLength;
+        }
+        if(ch & 0x80)
+        {
+            if((ch & 0xc0) != 0xc0)
+            {
+                return false;
+            }
+            int continuationBytes = continuationByteCount[ch & 0x3f];
+            if(continuationBytes == 0 || ptr + continuationBytes >= end)
+            {
+                return false;
+            }
+            for(int i = 0; i < continuationBytes; i++)
+            {
+                ptr++;
+                if((*ptr & 0xc0) != 0x80)
+                {
+                    return false;
+                }
+            }
+        }
+        else if(ch < 0x20 && ch != '\t' && ch != '\n' && ch != '\r')
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/** Check both implementations against each other, and against the expected result. */
+static void checkString(const unsigned char* buffer, int minLength, int maxLength, bool expected, const char* what)
+{
+    bool fast = rcstring_isNullTerminatedUTF8String(buffer, minLength, maxLength);
+    bool scalar = scalarIsNullTerminatedUTF8String(buffer, minLength, maxLength);
+    if(fast != expected || scalar != expected)
+    {
+        fprintf(stderr, "%s (min %d, max %d): expected %d, got %d (scalar %d)\n",
+                what, minLength, maxLength, expected, fast, scalar);
+        g_failures++;
+    }
+}
+
+/** Fill a buffer with ASCII text, and put a sequence at the given offset, followed by NUL. */
+static int textWithSequence(unsigned char* buffer, int offset, const char* sequence, int sequenceLength)
+{
+    memset(buffer, 'a', BUFFER_SIZE);
+    memcpy(buffer + offset, sequence, (size_t)sequenceLength);
+    buffer[offset + sequenceLength] = '\0';
+    return offset + sequenceLength;
+}
+
+
+static void testPlainASCII(void)
+{
+    unsigned char buffer[BUFFER_SIZE];
+    for(int length = 0; length < BUFFER_SIZE - 1; length++)
+    {
+        memset(buffer, 'x', BUFFER_SIZE);
+        buffer[length] = '\0';
+        checkString(buffer, length, BUFFER_SIZE, true, "ASCII");
+        checkString(buffer, length + 1, BUFFER_SIZE, false, "ASCII shorter than the minimum");
+        checkString(buffer, 0, length, false, "ASCII without NUL within the maximum");
+        checkString(buffer, 0, length + 1, true, "ASCII with NUL at the maximum");
+    }
+}
+
+static void testPrintableControlCharacters(void)
+{
+    unsigned char buffer[BUFFER_SIZE];
+    for(int offset = 0; offset < 40; offset++)
+    {
+        int length = textWithSequence(buffer, offset, "\t\r\n", 3);
+        checkString(buffer, 0, BUFFER_SIZE, true, "tab, CR and LF");
+        buffer[offset + 1] = '\x01';
+        checkString(buffer, 0, BUFFER_SIZE, false, "control character");
+        buffer[offset + 1] = '\x7f';
+        checkString(buffer, length, BUFFER_SIZE, true, "DEL");
+    }
+}
+
+static void testMultiByteSequences(void)
+{
+    static const char* const sequences[] = {"\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xf8\x88\x80\x80\x80"};
+    unsigned char buffer[BUFFER_SIZE];
+    for(int s = 0; s < 4; s++)
+    {
+        int sequenceLength = (int)strlen(sequences[s]);
+        for(int offset = 0; offset < 40; offset++)
+        {
+            int length = textWithSequence(buffer, offset, sequences[s], sequenceLength);
+            checkString(buffer, length, BUFFER_SIZE, true, "multi-byte sequence");
+            checkString(buffer, 0, length, false, "multi-byte sequence without NUL within the maximum");
+        }
+    }
+}
+
+static void testInvalidSequences(void)
+{
+    unsigned char buffer[BUFFER_SIZE];
+    for(int offset = 0; offset < 40; offset++)
+    {
+        textWithSequence(buffer, offset, "\x80", 1);
+        checkString(buffer, 0, BUFFER_SIZE, false, "stray continuation byte");
+        textWithSequence(buffer, offset, "\xc3\x28", 2);
+        checkString(buffer, 0, BUFFER_SIZE, false, "bad continuation byte");
+        textWithSequence(buffer, offset, "\xe2\x82\x28", 3);
+        checkString(buffer, 0, BUFFER_SIZE, false, "bad last continuation byte");
+        textWithSequence(buffer, offset, "\xfe\x80", 2);
+        checkString(buffer, 0, BUFFER_SIZE, false, "invalid lead byte");
+    }
+}
+
+static void testTruncatedSequences(void)
+{
+    unsigned char buffer[BUFFER_SIZE];
+    for(int offset = 0; offset < 40; offset++)
+    {
+        // cut short by the terminator:
+        textWithSequence(buffer, offset, "\xe2\x82", 2);
+        checkString(buffer, 0, BUFFER_SIZE, false, "sequence cut short by NUL");
+        textWithSequence(buffer, offset, "\xf0", 1);
+        checkString(buffer, 0, BUFFER_SIZE, false, "lead byte before NUL");
+
+        // cut short by the maximum length:
+        textWithSequence(buffer, offset, "\xf0\x9f\x98\x80", 4);
+        checkString(buffer, 0, offset + 3, false, "sequence cut short by the maximum");
+        checkString(buffer, 0, offset + 4, false, "sequence ending at the maximum");
+        checkString(buffer, 0, offset + 5, true, "sequence and NUL within the maximum");
+    }
+}
+
+static void testRandomText(void)
+{
+    // mostly ASCII, so that runs long enough for the fast path come up often:
+    static const unsigned char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 \t\n\r"
+                                            "\x01\x7f\x80\xbf\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\xfe";
+    unsigned char buffer[BUFFER_SIZE];
+    srand(42);
+    for(int i = 0; i < 200000; i++)
+    {
+        int rare = rand() % 4 == 0;
+        for(int j = 0; j < BUFFER_SIZE; j++)
+        {
+            int range = (rare || rand() % 64 == 0) ? (int)sizeof(alphabet) - 1 : 36;
+            buffer[j] = alphabet[rand() % range];
+        }
+        buffer[rand() % BUFFER_SIZE] = '\0';
+        int maxLength = 1 + rand() % BUFFER_SIZE;
+        int minLength = rand() % 8;
+        bool expected = scalarIsNullTerminatedUTF8String(buffer, minLength, maxLength);
+        checkString(buffer, minLength, maxLength, expected, "random text");
+    }
+}
+
+
+int main(void)
+{
+    testPlainASCII();
+    testPrintableControlCharacters();
+    testMultiByteSequences();
+    testInvalidSequences();
+    testTruncatedSequences();
+    testRandomText();
+
+    return reportChecks("UTF-8 string");
+}
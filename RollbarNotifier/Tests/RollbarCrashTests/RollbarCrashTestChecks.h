@@ -0,0 +1,51 @@
+//
+//  RollbarCrashTestChecks.h
+//
+//  Assertions shared by the plain C tests in this directory.
+//  A failed check is reported and counted; the test carries on.
+//
+
+#ifndef HDR_RollbarCrashTestChecks_h
+#define HDR_RollbarCrashTestChecks_h
+
+#include <stdio.h>
+#include <string.h>
+
+static int g_failures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_failures++; \
+        } \
+    } while(0)
+
+#define CHECK_STRING(expected, actual) \
+    do \
+    { \
+        const char* expected_ = (expected); \
+        const char* actual_ = (actual); \
+        if(expected_ == NULL ? actual_ != NULL : actual_ == NULL || strcmp(expected_, actual_) != 0) \
+        { \
+            fprintf(stderr, "%s:%d: expected \"%s\", got \"%s\"\n", __FILE__, __LINE__, \
+                    expected_ ? expected_ : "(null)", actual_ ? actual_ : "(null)"); \
+            g_failures++; \
+        } \
+    } while(0)
+
+/** Prints the outcome and returns the process exit status. */
+static inline int reportChecks(const char* suiteName)
+{
+    if(g_failures > 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("All %s tests passed\n", suiteName);
+    return 0;
+}
+
+#endif // HDR_RollbarCrashTestChecks_h
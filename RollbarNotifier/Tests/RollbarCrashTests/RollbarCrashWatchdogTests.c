@@ -0,0 +1,142 @@
+//
+//  RollbarCrashWatchdogTests.c
+//
+//  Plain C tests of the heartbeat watchdog, runnable on Linux with `make test`.
+//  The test's main thread plays the watched run loop: it beats, waits and stalls on cue.
+//
+
+#include "RollbarCrashWatchdog.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHECK_INTERVAL 0.01
+
+static _Atomic(int) g_stalledCount;
+static _Atomic(int) g_stallEndedCount;
+static _Atomic(double) g_lastStallDuration;
+
+
+static double onStalled(__unused double stallDuration, __unused void* userData)
+{
+    atomic_fetch_add(&g_stalledCount, 1);
+    return 0;
+}
+
+static void onStallEnded(double stallDuration, __unused void* userData)
+{
+    atomic_store(&g_lastStallDuration, stallDuration);
+    atomic_fetch_add(&g_stallEndedCount, 1);
+}
+
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+/** Run the synthetic loop, beating every millisecond. */
+static void beatFor(RollbarCrashWatchdog* watchdog, double seconds)
+{
+    double end = now() + seconds;
+    while(now() < end)
+    {
+        rcwd_heartbeat(watchdog);
+        usleep(1000);
+    }
+}
+
+static void resetCounts(void)
+{
+    atomic_store(&g_stalledCount, 0);
+    atomic_store(&g_stallEndedCount, 0);
+}
+
+static int histogramTotal(RollbarCrashWatchdog* watchdog)
+{
+    uint64_t buckets[RollbarCrashWatchdog_HISTOGRAM_BUCKETS];
+    rcwd_getStallHistogram(watchdog, buckets);
+    int total = 0;
+    for(int i = 0; i < RollbarCrashWatchdog_HISTOGRAM_BUCKETS; i++)
+    {
+        total += (int)buckets[i];
+    }
+    return total;
+}
+
+
+static void testLoopThatNeverBeatIsNotStalled(RollbarCrashWatchdog* watchdog)
+{
+    usleep(100000);
+    CHECK(atomic_load(&g_stalledCount) == 0);
+}
+
+static void testBeatingLoopIsNotStalled(RollbarCrashWatchdog* watchdog)
+{
+    beatFor(watchdog, 0.1);
+    CHECK(atomic_load(&g_stalledCount) == 0);
+    CHECK(atomic_load(&g_stallEndedCount) == 0);
+}
+
+static void testWaitingIsNotStalling(RollbarCrashWatchdog* watchdog)
+{
+    rcwd_willWait(watchdog);
+    usleep(200000);
+    rcwd_didWake(watchdog);
+    beatFor(watchdog, 0.05);
+    CHECK(atomic_load(&g_stalledCount) == 0);
+    CHECK(atomic_load(&g_stallEndedCount) == 0);
+}
+
+static void testStallIsReportedOnceItEnds(RollbarCrashWatchdog* watchdog)
+{
+    // busy, but not beating:
+    usleep(300000);
+    CHECK(atomic_load(&g_stalledCount) > 0);
+    CHECK(atomic_load(&g_stallEndedCount) == 0);
+
+    beatFor(watchdog, 0.05);
+    CHECK(atomic_load(&g_stallEndedCount) == 1);
+    double stallDuration = atomic_load(&g_lastStallDuration);
+    CHECK(stallDuration >= 0.28 && stallDuration < 0.512);
+
+    // bucket 4 holds stalls from 256ms up to 512ms:
+    uint64_t buckets[RollbarCrashWatchdog_HISTOGRAM_BUCKETS];
+    rcwd_getStallHistogram(watchdog, buckets);
+    CHECK(buckets[4] == 1);
+    CHECK(histogramTotal(watchdog) == 1);
+}
+
+static void testStopWakesTheMonitor(RollbarCrashWatchdog* watchdog)
+{
+    rcwd_setCheckInterval(watchdog, 60);
+    double start = now();
+    rcwd_stop(watchdog);
+    CHECK(now() - start < 1);
+
+    // nothing is watched once stopped:
+    resetCounts();
+    rcwd_heartbeat(watchdog);
+    usleep(100000);
+    CHECK(atomic_load(&g_stalledCount) == 0);
+}
+
+
+int main(void)
+{
+    RollbarCrashWatchdog watchdog;
+    RollbarCrashWatchdogCallbacks callbacks = {onStalled, onStallEnded, NULL};
+    rcwd_init(&watchdog, callbacks, CHECK_INTERVAL);
+    CHECK(rcwd_start(&watchdog));
+
+    testLoopThatNeverBeatIsNotStalled(&watchdog);
+    testBeatingLoopIsNotStalled(&watchdog);
+    testWaitingIsNotStalling(&watchdog);
+    testStallIsReportedOnceItEnds(&watchdog);
+    testStopWakesTheMonitor(&watchdog);
+
+    return reportChecks("watchdog");
+}
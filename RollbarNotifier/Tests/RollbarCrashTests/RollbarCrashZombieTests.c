@@ -0,0 +1,197 @@
+//
+//  RollbarCrashZombieTests.c
+//
+//  Plain C tests of the zombie cache, runnable on Linux with `make test`.
+//  A tiny fake of the Objective-C runtime stands in for the real one: objects are
+//  structs starting with their class, and dealloc is called through the hooked method.
+//
+
+#include "RollbarCrashMonitor_Zombie.h"
+#include "RollbarCrashObjC.h"
+#include "RollbarCrashTestChecks.h"
+
+#include <objc/runtime.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define OBJECT_COUNT 4096
+
+struct objc_method
+{
+    IMP imp;
+};
+
+struct objc_class
+{
+    const char* name;
+    Class superclass;
+    struct objc_method dealloc;
+};
+
+/** A fake object, as big and as aligned as a real one. */
+typedef struct
+{
+    struct objc_object header;
+    char ivars[8];
+} __attribute__((aligned(16))) FakeObject;
+
+static void originalDealloc(__unused id self, __unused SEL _cmd) {}
+
+static struct objc_class g_NSObject = {"NSObject", NULL, {(IMP)originalDealloc}};
+static struct objc_class g_NSProxy = {"NSProxy", NULL, {(IMP)originalDealloc}};
+static struct objc_class g_NSException = {"NSException", &g_NSObject, {(IMP)originalDealloc}};
+static struct objc_class g_Foo = {"Foo", &g_NSObject, {(IMP)originalDealloc}};
+static struct objc_class g_Bar = {"Bar", &g_NSObject, {(IMP)originalDealloc}};
+
+static FakeObject g_objects[OBJECT_COUNT];
+
+
+// ============================================================================
+#pragma mark - Fake runtime -
+// ============================================================================
+
+Class objc_getClass(const char* name)
+{
+    Class classes[] = {&g_NSObject, &g_NSProxy, &g_NSException};
+    for(size_t i = 0; i < sizeof(classes) / sizeof(*classes); i++)
+    {
+        if(strcmp(classes[i]->name, name) == 0)
+        {
+            return classes[i];
+        }
+    }
+    return NULL;
+}
+
+Class object_getClass(id object) { return object->isa; }
+const char* class_getName(Class cls) { return cls->name; }
+Class class_getSuperclass(Class cls) { return cls->superclass; }
+Method class_getInstanceMethod(Class cls, __unused SEL name) { return &cls->dealloc; }
+SEL sel_registerName(const char* name) { return (SEL)name; }
+IMP method_getImplementation(Method method) { return method->imp; }
+
+IMP method_setImplementation(Method method, IMP imp)
+{
+    IMP previous = method->imp;
+    method->imp = imp;
+    return previous;
+}
+
+// Deallocated exceptions are never introspected here.
+bool rcobjc_isValidObject(__unused const void* object) { return false; }
+bool rcobjc_ivarNamed(__unused const void* const classPtr, __unused const char* name, __unused RollbarCrashObjCIvar* dst) { return false; }
+bool rcobjc_ivarValue(__unused const void* objectPtr, __unused int ivarIndex, __unused void* dst) { return false; }
+int rcobjc_copyStringContents(__unused const void* string, __unused char* dst, __unused int maxLength) { return 0; }
+
+/** Deallocate an object the way the runtime would, through NSObject's hooked dealloc. */
+static void dealloc(FakeObject* object, Class class)
+{
+    object->header.isa = class;
+    typedef void (*DeallocFunction)(id, SEL);
+    ((DeallocFunction)g_NSObject.dealloc.imp)(&object->header, sel_registerName("dealloc"));
+}
+
+
+// ============================================================================
+#pragma mark - Tests -
+// ============================================================================
+
+static void testNothingIsFoundBeforeInstalling(void)
+{
+    dealloc(&g_objects[0], &g_Foo);
+    CHECK(rczombie_className(&g_objects[0]) == NULL);
+}
+
+static void testHitAndMiss(void)
+{
+    dealloc(&g_objects[0], &g_Foo);
+    CHECK_STRING("Foo", rczombie_className(&g_objects[0]));
+    CHECK(rczombie_className(&g_objects[1]) == NULL);
+    CHECK(rczombie_className(NULL) == NULL);
+
+    // an address that's reused is remembered as its latest object:
+    dealloc(&g_objects[0], &g_Bar);
+    CHECK_STRING("Bar", rczombie_className(&g_objects[0]));
+}
+
+static void testOldObjectsAreEvicted(int cacheSize)
+{
+    for(int i = 0; i < OBJECT_COUNT; i++)
+    {
+        dealloc(&g_objects[i], (i & 1) ? &g_Bar : &g_Foo);
+    }
+
+    // each set keeps the last objects it received, and with this many objects
+    // every set has received more than it can keep:
+    int hits = 0;
+    for(int i = 0; i < OBJECT_COUNT; i++)
+    {
+        const char* className = rczombie_className(&g_objects[i]);
+        if(className != NULL)
+        {
+            CHECK_STRING((i & 1) ? "Bar" : "Foo", className);
+            hits++;
+        }
+    }
+    CHECK(hits == cacheSize);
+    CHECK(rczombie_className(&g_objects[0]) == NULL);
+    CHECK(rczombie_className(&g_objects[OBJECT_COUNT - 1]) != NULL);
+}
+
+static atomic_bool g_deallocating;
+
+static void* deallocRepeatedly(__unused void* context)
+{
+    for(int round = 0; round < 200; round++)
+    {
+        for(int i = 0; i < OBJECT_COUNT; i++)
+        {
+            dealloc(&g_objects[i], (i & 1) ? &g_Bar : &g_Foo);
+        }
+    }
+    atomic_store(&g_deallocating, false);
+    return NULL;
+}
+
+static void testReadersNeverSeeTornEntries(void)
+{
+    pthread_t thread;
+    atomic_store(&g_deallocating, true);
+    pthread_create(&thread, NULL, deallocRepeatedly, NULL);
+    while(atomic_load(&g_deallocating))
+    {
+        for(int i = 0; i < OBJECT_COUNT; i++)
+        {
+            const char* className = rczombie_className(&g_objects[i]);
+            if(className != NULL && strcmp(className, (i & 1) ? "Bar" : "Foo") != 0)
+            {
+                fprintf(stderr, "object %d found as %s\n", i, className);
+                g_failures++;
+                atomic_store(&g_deallocating, false);
+                break;
+            }
+        }
+    }
+    pthread_join(thread, NULL);
+}
+
+
+int main(void)
+{
+    // 48 objects make 16 sets of 3:
+    static const int cacheSize = 48;
+
+    testNothingIsFoundBeforeInstalling();
+    rczombie_setCacheSize(cacheSize);
+    rcm_zombie_getAPI()->setEnabled(true);
+    // too late to change the size now:
+    rczombie_setCacheSize(cacheSize * 2);
+
+    testHitAndMiss();
+    testOldObjectsAreEvicted(cacheSize);
+    testReadersNeverSeeTornEntries();
+
+    return reportChecks("zombie cache");
+}
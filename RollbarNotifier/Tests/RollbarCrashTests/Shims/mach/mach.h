@@ -0,0 +1,13 @@
+//
+//  mach.h
+//
+//  Just enough of <mach/mach.h> for the crash monitor headers to compile on Linux.
+//
+
+#ifndef HDR_RollbarCrashTests_mach_h
+#define HDR_RollbarCrashTests_mach_h
+
+typedef unsigned int mach_msg_type_number_t;
+typedef unsigned int* thread_act_array_t;
+
+#endif // HDR_RollbarCrashTests_mach_h
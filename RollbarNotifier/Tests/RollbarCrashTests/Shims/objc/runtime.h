@@ -0,0 +1,33 @@
+//
+//  runtime.h
+//
+//  Just enough of <objc/runtime.h> for the zombie monitor to compile on Linux.
+//  The tests that use it implement these functions over their own fake classes.
+//
+
+#ifndef HDR_RollbarCrashTests_objc_runtime_h
+#define HDR_RollbarCrashTests_objc_runtime_h
+
+#include <stddef.h>
+
+typedef struct objc_class* Class;
+typedef struct objc_object
+{
+    Class isa;
+}* id;
+typedef struct objc_selector* SEL;
+typedef void (*IMP)(void);
+typedef struct objc_method* Method;
+
+#define nil NULL
+
+Class objc_getClass(const char* name);
+Class object_getClass(id object);
+const char* class_getName(Class cls);
+Class class_getSuperclass(Class cls);
+Method class_getInstanceMethod(Class cls, SEL name);
+SEL sel_registerName(const char* name);
+IMP method_getImplementation(Method method);
+IMP method_setImplementation(Method method, IMP imp);
+
+#endif // HDR_RollbarCrashTests_objc_runtime_h
@@ -8,6 +8,8 @@
 #import <XCTest/XCTest.h>
 #import "../../Sources/RollbarNotifier/RollbarPayloadRepository.h"
 
+#import <sqlite3.h>
+
 @import UnitTesting;
 
 @interface RollbarPayloadRepositoryTests : XCTestCase
@@ -42,6 +44,7 @@
     XCTAssertFalse([repo checkIfTableExists_Unknown]);
     XCTAssertTrue ([repo checkIfTableExists_Destinations]);
     XCTAssertTrue ([repo checkIfTableExists_Payloads]);
+    XCTAssertTrue ([repo checkIfTableExists_Configs]);
 }
 
 - (void)testAddDestination {
@@ -406,6 +409,203 @@
     XCTAssertEqual(0, [repo getPayloadsWithOffset:2 andLimit:0].count);
 }
 
+- (void)testGetPayloadsAfterID {
+    
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepository];
+    [self insertPayloadMocks:repo];
+    NSString *destinationID = [repo getDestinationWithEndpoint:@"EP_001"
+                                                 andAccesToken:@"AT_005"][@"id"];
+    
+    // oldest first:
+    NSArray<NSDictionary<NSString *, NSString *> *> *payloads = [repo getPayloadsAfterID:@"0" andLimit:2];
+    XCTAssertEqual(2, payloads.count);
+    XCTAssertEqualObjects(@"PL_001", payloads[0][@"payload_json"]);
+    XCTAssertEqualObjects(@"PL_002", payloads[1][@"payload_json"]);
+    
+    payloads = [repo getPayloadsAfterID:payloads[1][@"id"] andLimit:5];
+    XCTAssertEqual(2, payloads.count);
+    XCTAssertEqualObjects(@"PL_003", payloads[0][@"payload_json"]);
+    XCTAssertEqualObjects(@"PL_004", payloads[1][@"payload_json"]);
+    XCTAssertEqual(0, [repo getPayloadsAfterID:payloads[1][@"id"] andLimit:5].count);
+    
+    payloads = [repo getPayloadsWithDestinationID:destinationID afterID:@"0" andLimit:2];
+    XCTAssertEqual(2, payloads.count);
+    payloads = [repo getPayloadsWithDestinationID:destinationID afterID:payloads[1][@"id"] andLimit:2];
+    XCTAssertEqual(1, payloads.count);
+    XCTAssertEqualObjects(@"PL_003", payloads[0][@"payload_json"]);
+}
+
+- (void)testPayloadCounts {
+    
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepository];
+    XCTAssertEqual(0, [repo getPayloadCount]);
+    [self insertPayloadMocks:repo];
+    NSString *destinationID = [repo getDestinationWithEndpoint:@"EP_001"
+                                                 andAccesToken:@"AT_005"][@"id"];
+    XCTAssertEqual(4, [repo getPayloadCount]);
+    XCTAssertEqual(3, [repo getPayloadCountWithDestinationID:destinationID]);
+    
+    NSDictionary<NSString *, NSString *> *payload =
+    [repo addPayload:@"PL_005" withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertEqual(5, [repo getPayloadCount]);
+    XCTAssertEqual(4, [repo getPayloadCountWithDestinationID:destinationID]);
+    
+    XCTAssertTrue([repo removePayloadByID:payload[@"id"]]);
+    XCTAssertTrue([repo removePayloadByID:payload[@"id"]]);
+    XCTAssertEqual(4, [repo getPayloadCount]);
+    XCTAssertEqual(3, [repo getPayloadCountWithDestinationID:destinationID]);
+    
+    // a fresh connection counts the same:
+    XCTAssertTrue([repo flush]);
+    RollbarPayloadRepository *other = [RollbarPayloadRepository persistentRepository];
+    XCTAssertEqual(4, [other getPayloadCount]);
+    XCTAssertEqual(3, [other getPayloadCountWithDestinationID:destinationID]);
+    
+    [repo removePayloadsOlderThan:[NSDate distantFuture]];
+    XCTAssertEqual(0, [repo getPayloadCount]);
+    XCTAssertEqual(0, [repo getPayloadCountWithDestinationID:destinationID]);
+}
+
+- (void)testPayloadData {
+    
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepository];
+    [self insertPayloadMocks:repo];
+    NSString *destinationID = [repo getDestinationWithEndpoint:@"EP_001"
+                                                 andAccesToken:@"AT_005"][@"id"];
+    
+    NSData *payloadData = [@"{\"data\":{\"body\":\"PL_005\"}}" dataUsingEncoding:NSUTF8StringEncoding];
+    NSDictionary<NSString *, id> *payload =
+    [repo addPayloadData:payloadData withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertNotNil(payload[@"id"]);
+    
+    // payloads stored as data come back byte for byte, the ones stored as strings stay strings:
+    XCTAssertEqualObjects(payloadData, [repo getPayloadByID:payload[@"id"]][@"payload_json"]);
+    NSArray<NSDictionary<NSString *, id> *> *payloads = [repo getAllPayloadsWithDestinationID:destinationID];
+    XCTAssertEqual(4, payloads.count);
+    XCTAssertEqualObjects(@"PL_001", payloads[0][@"payload_json"]);
+    XCTAssertEqualObjects(payloadData, payloads[3][@"payload_json"]);
+    XCTAssertEqualObjects(@"C_001", payloads[3][@"config_json"]);
+    XCTAssertEqual(5, [repo getPayloadCount]);
+    
+    // empty data is still stored as data, not as NULL:
+    NSDictionary<NSString *, id> *emptyPayload =
+    [repo addPayloadData:[NSData data] withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertNotNil(emptyPayload[@"id"]);
+    XCTAssertEqualObjects([NSData data], [repo getPayloadByID:emptyPayload[@"id"]][@"payload_json"]);
+    XCTAssertEqual(6, [repo getPayloadCount]);
+}
+
+- (void)testGroupCommit {
+    
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepository];
+    NSString *destinationID = [repo getIDofDestinationWithEndpoint:@"EP_001" andAccesToken:@"AT_001"];
+    repo.groupCommitSize = 3;
+    XCTAssertFalse(repo.hasPendingWrites);
+    
+    [repo addPayload:@"PL_001" withConfig:@"C_001" andDestinationID:destinationID];
+    [repo addPayload:@"PL_002" withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertTrue(repo.hasPendingWrites);
+    XCTAssertEqual(2, [repo getPayloadCount]);
+    
+    // a full group commits by itself:
+    NSDictionary<NSString *, NSString *> *dataFields =
+    [repo addPayload:@"PL_003" withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertFalse(repo.hasPendingWrites);
+    
+    [repo removePayloadByID:dataFields[@"id"]];
+    XCTAssertTrue(repo.hasPendingWrites);
+    XCTAssertTrue([repo flush]);
+    XCTAssertFalse(repo.hasPendingWrites);
+    XCTAssertEqual(2, [repo getPayloadCount]);
+    
+    XCTAssertTrue([repo flush]);
+}
+
+- (void)testSharedConfigs {
+    
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepository];
+    NSString *destinationID = [repo getIDofDestinationWithEndpoint:@"EP_001" andAccesToken:@"AT_001"];
+    
+    NSNumber *configID = [repo getIDofConfig:@"C_001"];
+    XCTAssertNotNil(configID);
+    XCTAssertEqualObjects(configID, [repo getIDofConfig:[@"C_00" stringByAppendingString:@"1"]]);
+    XCTAssertNotEqualObjects(configID, [repo getIDofConfig:@"C_002"]);
+    
+    [repo addPayload:@"PL_001" withConfig:@"C_001" andDestinationID:destinationID];
+    [repo addPayload:@"PL_002" withConfig:@"C_001" andDestinationID:destinationID];
+    XCTAssertTrue([repo flush]);
+    for (NSDictionary<NSString *, NSString *> *payload in [repo getAllPayloads]) {
+        XCTAssertEqualObjects(@"C_001", payload[@"config_json"]);
+    }
+    
+    // only configs still referenced by payloads survive:
+    XCTAssertTrue([repo removeUnusedConfigs]);
+    XCTAssertEqualObjects(configID, [repo getIDofConfig:@"C_001"]);
+    XCTAssertTrue([repo removeAllPayloads]);
+    XCTAssertTrue([repo removeUnusedConfigs]);
+    XCTAssertNotNil([repo getIDofConfig:@"C_001"]);
+}
+
+- (void)testInlineConfigsMigration {
+    
+    NSString *storePath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"rollbar_inline_configs.db"];
+    [[NSFileManager defaultManager] removeItemAtPath:storePath error:nil];
+    
+    // a store as written before configs were deduplicated:
+    sqlite3 *db;
+    XCTAssertEqual(SQLITE_OK, sqlite3_open([storePath UTF8String], &db));
+    XCTAssertEqual(SQLITE_OK, sqlite3_exec(db,
+        "CREATE TABLE destinations (id INTEGER NOT NULL PRIMARY KEY, endpoint TEXT NOT NULL, access_token TEXT NOT NULL, CONSTRAINT unique_destination UNIQUE(endpoint, access_token));"
+        "CREATE TABLE payloads (id INTEGER NOT NULL PRIMARY KEY, config_json TEXT NOT NULL, payload_json TEXT NOT NULL, created_at INTEGER NOT NULL, destination_key INTEGER NOT NULL, FOREIGN KEY(destination_key) REFERENCES destinations(id) ON UPDATE CASCADE ON DELETE CASCADE);"
+        "INSERT INTO destinations (endpoint, access_token) VALUES ('EP_001', 'AT_001');"
+        "INSERT INTO payloads (config_json, payload_json, created_at, destination_key) VALUES ('C_001', 'PL_001', 1, 1);"
+        "INSERT INTO payloads (config_json, payload_json, created_at, destination_key) VALUES ('C_002', 'PL_002', 2, 1);"
+        "INSERT INTO payloads (config_json, payload_json, created_at, destination_key) VALUES ('C_001', 'PL_003', 3, 1);",
+        NULL, NULL, NULL));
+    sqlite3_close(db);
+    
+    // opening the store migrates it, and every payload keeps its config:
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository persistentRepositoryWithPath:storePath];
+    NSString *destinationID = [repo getIDofDestinationWithEndpoint:@"EP_001" andAccesToken:@"AT_001"];
+    XCTAssertEqualObjects(@"1", destinationID);
+    NSArray<NSDictionary<NSString *, id> *> *payloads = [repo getAllPayloadsWithDestinationID:destinationID];
+    XCTAssertEqual(3, payloads.count);
+    XCTAssertEqualObjects(@"PL_001", payloads[0][@"payload_json"]);
+    XCTAssertEqualObjects(@"C_001", payloads[0][@"config_json"]);
+    XCTAssertEqualObjects(@"PL_002", payloads[1][@"payload_json"]);
+    XCTAssertEqualObjects(@"C_002", payloads[1][@"config_json"]);
+    XCTAssertEqualObjects(@"PL_003", payloads[2][@"payload_json"]);
+    XCTAssertEqualObjects(@"C_001", payloads[2][@"config_json"]);
+    XCTAssertEqual(2, [self countConfigsInStore:storePath]);
+    
+    // migrated configs have placeholder hashes, so their first reuse stores them once more,
+    // but from then on new payloads share configs again:
+    [repo addPayload:@"PL_004" withConfig:@"C_001" andDestinationID:destinationID];
+    [repo addPayload:@"PL_005" withConfig:@"C_003" andDestinationID:destinationID];
+    XCTAssertTrue([repo flush]);
+    repo = [RollbarPayloadRepository persistentRepositoryWithPath:storePath];
+    [repo addPayload:@"PL_006" withConfig:@"C_001" andDestinationID:destinationID];
+    [repo addPayload:@"PL_007" withConfig:@"C_003" andDestinationID:destinationID];
+    XCTAssertTrue([repo flush]);
+    XCTAssertEqual(4, [self countConfigsInStore:storePath]);
+    
+    payloads = [repo getAllPayloadsWithDestinationID:destinationID];
+    XCTAssertEqual(7, payloads.count);
+    XCTAssertEqualObjects(@"C_001", payloads[5][@"config_json"]);
+    XCTAssertEqualObjects(@"C_003", payloads[6][@"config_json"]);
+    
+    // once the migrated payloads are gone, so are their placeholder configs:
+    XCTAssertTrue([repo removePayloadByID:payloads[0][@"id"]]);
+    XCTAssertTrue([repo removePayloadByID:payloads[1][@"id"]]);
+    XCTAssertTrue([repo removePayloadByID:payloads[2][@"id"]]);
+    XCTAssertTrue([repo removeUnusedConfigs]);
+    XCTAssertTrue([repo flush]);
+    XCTAssertEqual(2, [self countConfigsInStore:storePath]);
+    
+    repo = nil;
+    [[NSFileManager defaultManager] removeItemAtPath:storePath error:nil];
+}
+
 #pragma mark - Payloads performance tests
 
 - (void)testAddGetRemovePayloadPerformance {
@@ -511,8 +711,86 @@
     }];
 }
 
+#pragma mark - Payloads throughput benchmarks
+
+static const NSUInteger kThroughputPayloadCount = 2000;
+
+- (NSString *)throughputPayload {
+    
+    // a few kilobytes of JSON with quotes, like a real payload:
+    return [@"" stringByPaddingToLength:4096 withString:@"{\"message\":\"Don't panic\"}," startingAtIndex:0];
+}
+
+- (void)testPayloadInsertDeleteThroughput {
+    
+    // in memory, so that statement parsing and planning isn't hidden behind fsyncs:
+    RollbarPayloadRepository *repo = [RollbarPayloadRepository inMemoryRepository];
+    NSString *destinationID = [repo getIDofDestinationWithEndpoint:@"EP_001" andAccesToken:@"AT_001"];
+    NSString *payload = [self throughputPayload];
+    
+    [self measureBlock:^{
+        NSMutableArray<NSString *> *payloadIDs = [NSMutableArray arrayWithCapacity:kThroughputPayloadCount];
+        for (NSUInteger i = 0; i < kThroughputPayloadCount; i++) {
+            NSString *payloadID = [repo addPayload:payload withConfig:@"C_001" andDestinationID:destinationID][@"id"];
+            XCTAssertNotNil(payloadID);
+            if (payloadID) {
+                [payloadIDs addObject:payloadID];
+            }
+        }
+        XCTAssertEqual(kThroughputPayloadCount, payloadIDs.count);
+        XCTAssertEqual(kThroughputPayloadCount, [repo getPayloadCount]);
+        for (NSString *payloadID in payloadIDs) {
+            XCTAssertTrue([repo removePayloadByID:payloadID]);
+        }
+        XCTAssertEqual(0, [repo getPayloadCount]);
+    }];
+}
+
+- (void)testAdHocSqlInsertDeleteThroughput {
+    
+    // the baseline: SQL literals built per call and run through sqlite3_exec,
+    // the way the repository used to work.
+    sqlite3 *db;
+    XCTAssertEqual(SQLITE_OK, sqlite3_open(":memory:", &db));
+    XCTAssertEqual(SQLITE_OK, sqlite3_exec(db, "CREATE TABLE payloads (id INTEGER NOT NULL PRIMARY KEY, config_json TEXT NOT NULL, payload_json TEXT NOT NULL, created_at INTEGER NOT NULL, destination_key INTEGER NOT NULL)", NULL, NULL, NULL));
+    NSString *payload = [self throughputPayload];
+    
+    [self measureBlock:^{
+        NSMutableArray<NSString *> *payloadIDs = [NSMutableArray arrayWithCapacity:kThroughputPayloadCount];
+        for (NSUInteger i = 0; i < kThroughputPayloadCount; i++) {
+            NSString *escapedPayload = [payload stringByReplacingOccurrencesOfString:@"'" withString:@"''"];
+            NSString *sql = [NSString stringWithFormat:
+              @"INSERT INTO payloads (config_json, payload_json, destination_key, created_at) VALUES ('%@', '%@', '%@', '%ld')",
+              @"C_001", escapedPayload, @"1", (long)[[NSDate date] timeIntervalSince1970]];
+            XCTAssertEqual(SQLITE_OK, sqlite3_exec(db, [sql UTF8String], NULL, NULL, NULL));
+            [payloadIDs addObject:[NSString stringWithFormat:@"%lli", sqlite3_last_insert_rowid(db)]];
+        }
+        for (NSString *payloadID in payloadIDs) {
+            NSString *sql = [NSString stringWithFormat: @"DELETE FROM payloads WHERE id = '%@'", payloadID];
+            XCTAssertEqual(SQLITE_OK, sqlite3_exec(db, [sql UTF8String], NULL, NULL, NULL));
+            XCTAssertEqual(1, sqlite3_changes(db));
+        }
+    }];
+    sqlite3_close(db);
+}
+
 #pragma mark - mocking helpers
 
+- (int)countConfigsInStore:(NSString *)storePath {
+    
+    sqlite3 *db;
+    sqlite3_stmt *statement;
+    int count = -1;
+    XCTAssertEqual(SQLITE_OK, sqlite3_open_v2([storePath UTF8String], &db, SQLITE_OPEN_READONLY, NULL));
+    XCTAssertEqual(SQLITE_OK, sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM configs", -1, &statement, NULL));
+    if (sqlite3_step(statement) == SQLITE_ROW) {
+        count = sqlite3_column_int(statement, 0);
+    }
+    sqlite3_finalize(statement);
+    sqlite3_close(db);
+    return count;
+}
+
 - (void)insertDestinationMocks:(RollbarPayloadRepository *)repo {
     
     [repo addDestinationWithEndpoint:@"EP_001" andAccesToken:@"AT_001"];
@@ -58,6 +58,86 @@
     XCTAssertFalse([record canPostWithConfig:config]);
 }
 
+- (void)testDestinationRecordLocalWindow {
+    
+    RollbarRegistry *registry = [RollbarRegistry new];
+    RollbarMutableConfig *config = [RollbarConfig mutableConfigWithAccessToken:@"AT1"
+                                                                   environment:@"Env1"];
+    config.loggingOptions.maximumReportsPerMinute = 2;
+    
+    RollbarDestinationRecord *record = [registry getRecordForConfig:config];
+    XCTAssertTrue([record canPostWithConfig:config]);
+    
+    [record recordPostReply:[RollbarPayloadPostReply greenReply] withConfig:config];
+    XCTAssertNotNil(record.nextLocalWindowStart);
+    XCTAssertEqual(1, record.localWindowCount);
+    XCTAssertTrue([record canPostWithConfig:config]);
+    
+    // the local limit holds posting back until the next local window:
+    [record recordPostReply:[RollbarPayloadPostReply greenReply] withConfig:config];
+    XCTAssertEqual(2, record.localWindowCount);
+    XCTAssertFalse([record canPostWithConfig:config]);
+    XCTAssertEqualObjects(record.nextLocalWindowStart, record.nextEarliestPost);
+    XCTAssertEqual(NSOrderedDescending, [record.nextEarliestPost compare:[NSDate date]]);
+}
+
+- (void)testDestinationRecordPostsInFlight {
+    
+    RollbarRegistry *registry = [RollbarRegistry new];
+    RollbarMutableConfig *config = [RollbarConfig mutableConfigWithAccessToken:@"AT1"
+                                                                   environment:@"Env1"];
+    config.loggingOptions.maximumReportsPerMinute = 2;
+    
+    RollbarDestinationRecord *record = [registry getRecordForConfig:config];
+    
+    // posts waiting for their replies already count against the local window:
+    [record reservePost];
+    XCTAssertEqual(1, record.postsInFlightCount);
+    XCTAssertTrue([record canPostWithConfig:config]);
+    [record reservePost];
+    XCTAssertEqual(2, record.postsInFlightCount);
+    XCTAssertFalse([record canPostWithConfig:config]);
+    
+    [record releasePost];
+    [record recordPostReply:[RollbarPayloadPostReply greenReply] withConfig:config];
+    XCTAssertEqual(1, record.postsInFlightCount);
+    XCTAssertEqual(1, record.localWindowCount);
+    XCTAssertFalse([record canPostWithConfig:config]);
+    
+    [record releasePost];
+    [record recordPostReply:[RollbarPayloadPostReply greenReply] withConfig:config];
+    XCTAssertEqual(0, record.postsInFlightCount);
+    XCTAssertEqual(2, record.localWindowCount);
+    XCTAssertFalse([record canPostWithConfig:config]);
+}
+
+- (void)testDestinationRecordNoReplyWithPostsInFlight {
+    
+    RollbarRegistry *registry = [RollbarRegistry new];
+    RollbarMutableConfig *config = [RollbarConfig mutableConfigWithAccessToken:@"AT1"
+                                                                   environment:@"Env1"];
+    config.loggingOptions.maximumReportsPerMinute = 10;
+    
+    RollbarDestinationRecord *record = [registry getRecordForConfig:config];
+    for (NSUInteger i = 0; i < 4; i++) {
+        [record reservePost];
+    }
+    
+    // a post without a reply holds the destination back, but the others are still in flight:
+    [record releasePost];
+    [record recordPostReply:nil withConfig:config];
+    XCTAssertEqual(3, record.postsInFlightCount);
+    XCTAssertFalse([record canPostWithConfig:config]);
+    
+    // and each of them is released once, as its reply comes in:
+    for (NSUInteger i = 0; i < 3; i++) {
+        [record releasePost];
+        [record recordPostReply:[RollbarPayloadPostReply greenReply] withConfig:config];
+    }
+    XCTAssertEqual(0, record.postsInFlightCount);
+    XCTAssertEqual(3, record.localWindowCount);
+}
+
 #pragma mark - registry records tests
 
 - (void)testRegistryRecords {
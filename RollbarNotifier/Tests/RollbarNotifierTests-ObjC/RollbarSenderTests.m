@@ -10,6 +10,11 @@
 
 #import "../../Sources/RollbarNotifier/RollbarSender.h"
 #import "../../Sources/RollbarNotifier/RollbarPayloadFactory.h"
+#import "../../Sources/RollbarNotifier/RollbarPayloadPostReply.h"
+#import "../../Sources/RollbarNotifier/RollbarThread.h"
+#import "RollbarStandInServer.h"
+
+#import <zlib.h>
 
 @import RollbarNotifier;
 
@@ -62,6 +67,150 @@
     XCTAssertNotNil(reply);
 }
 
+#pragma mark - tests of concurrent sending
+
+- (void)testSendingToStandInServerSequentially {
+    
+    [self sendToStandInServerWithRequestsInFlight:1];
+}
+
+- (void)testSendingToStandInServerConcurrently {
+    
+    [self sendToStandInServerWithRequestsInFlight:8];
+}
+
+- (void)sendToStandInServerWithRequestsInFlight:(NSUInteger)requestsInFlight {
+    
+    static NSUInteger const payloadsCount = 200;
+    
+    RollbarStandInServer *server = [[RollbarStandInServer alloc] initWithResponseDelay:0.02];
+    XCTAssertTrue([server start]);
+    
+    RollbarMutableConfig *config = [self getConfig_Live_Default];
+    config.destination.endpoint = server.endpoint;
+    
+    NSData *payloadData = [[self getPayload_Message] serializeToJSONData];
+    RollbarSender *sender = [RollbarSender new];
+    
+    dispatch_semaphore_t slots = dispatch_semaphore_create(requestsInFlight);
+    dispatch_group_t group = dispatch_group_create();
+    NSMutableArray<NSNumber *> *latencies = [NSMutableArray arrayWithCapacity:payloadsCount];
+    __block NSUInteger greenRepliesCount = 0;
+    
+    CFAbsoluteTime started = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < payloadsCount; i++) {
+        
+        dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+        dispatch_group_enter(group);
+        CFAbsoluteTime posted = CFAbsoluteTimeGetCurrent();
+        [sender sendPayload:payloadData usingConfig:config completion:^(RollbarPayloadPostReply *reply) {
+            
+            CFAbsoluteTime latency = CFAbsoluteTimeGetCurrent() - posted;
+            XCTAssertNotNil(reply);
+            XCTAssertEqual(200, reply.statusCode);
+            XCTAssertGreaterThan(reply.remainingCount, 0);
+            @synchronized (latencies) {
+                [latencies addObject:@(latency)];
+                if (reply && (200 == reply.statusCode) && (reply.remainingCount > 0)) {
+                    greenRepliesCount++;
+                }
+            }
+            dispatch_semaphore_signal(slots);
+            dispatch_group_leave(group);
+        }];
+    }
+    XCTAssertEqual(0, dispatch_group_wait(group, dispatch_time(DISPATCH_TIME_NOW, 60 * NSEC_PER_SEC)));
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - started;
+    
+    [server stop];
+    
+    @synchronized (latencies) {
+        XCTAssertEqual(payloadsCount, greenRepliesCount);
+        XCTAssertEqual(payloadsCount, latencies.count);
+        XCTAssertEqual(payloadsCount, server.requestCount);
+        XCTAssertLessThanOrEqual(server.maximumRequestsInFlight, requestsInFlight);
+        
+        [latencies sortUsingSelector:@selector(compare:)];
+        NSLog(@"%lu requests in flight: %.1f payloads/s, p50 %.1f ms, p99 %.1f ms",
+              (unsigned long)requestsInFlight,
+              payloadsCount / elapsed,
+              latencies[latencies.count / 2].doubleValue * 1000,
+              latencies[(latencies.count * 99) / 100].doubleValue * 1000);
+    }
+}
+
+- (void)testRollbarThreadLimitsRequestsInFlight {
+    
+    static NSUInteger const payloadsCount = 40;
+    static NSUInteger const requestsInFlight = 3;
+    
+    RollbarStandInServer *server = [[RollbarStandInServer alloc] initWithResponseDelay:0.05];
+    XCTAssertTrue([server start]);
+    
+    RollbarMutableConfig *config = [self getConfig_Live_Default];
+    config.destination.endpoint = server.endpoint;
+    config.developerOptions.transmit = YES;
+    config.developerOptions.maximumRequestsInFlight = requestsInFlight;
+    config.loggingOptions.maximumReportsPerMinute = 5000;
+    [[RollbarInfrastructure sharedInstance] configureWith:config];
+    
+    RollbarThread *thread = [RollbarThread sharedInstance];
+    for (NSUInteger i = 0; i < payloadsCount; i++) {
+        [thread persistPayload:[self getPayload_Message] withConfig:config];
+    }
+    
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:60];
+    while (server.requestCount < payloadsCount && [deadline timeIntervalSinceNow] > 0) {
+        [NSThread sleepForTimeInterval:0.05];
+    }
+    [server stop];
+    
+    // the thread posts concurrently, but never more than the configured number of payloads at once:
+    XCTAssertEqual(payloadsCount, server.requestCount);
+    XCTAssertGreaterThan(server.maximumRequestsInFlight, 0);
+    XCTAssertLessThanOrEqual(server.maximumRequestsInFlight, requestsInFlight);
+}
+
+- (void)testCompressedSendingToStandInServer {
+    
+    RollbarStandInServer *server = [[RollbarStandInServer alloc] initWithResponseDelay:0];
+    XCTAssertTrue([server start]);
+    
+    RollbarMutableConfig *config = [self getConfig_Live_Default];
+    config.destination.endpoint = server.endpoint;
+    config.developerOptions.compressPayloads = YES;
+    config.developerOptions.payloadCompressionThreshold = 0;
+    
+    NSData *payloadData = [[self getPayload_CrashReport] serializeToJSONData];
+    RollbarSender *sender = [RollbarSender new];
+    
+    RollbarPayloadPostReply *reply = [sender sendPayload:payloadData usingConfig:config];
+    XCTAssertNotNil(reply);
+    XCTAssertEqual(200, reply.statusCode);
+    XCTAssertEqual(payloadData.length, sender.uncompressedBytesCount);
+    XCTAssertLessThan(sender.compressedBytesCount, sender.uncompressedBytesCount);
+    
+    // payloads below the threshold are posted as they are:
+    config.developerOptions.payloadCompressionThreshold = payloadData.length + 1;
+    NSUInteger compressedBytesCount = sender.compressedBytesCount;
+    reply = [sender sendPayload:payloadData usingConfig:config];
+    XCTAssertEqual(200, reply.statusCode);
+    XCTAssertEqual(2 * payloadData.length, sender.uncompressedBytesCount);
+    XCTAssertEqual(compressedBytesCount + payloadData.length, sender.compressedBytesCount);
+    
+    [server stop];
+    XCTAssertEqual(2, server.requestCount);
+    
+    // what went over the wire inflates back to the very same payload:
+    NSArray<RollbarStandInRequest *> *requests = server.requests;
+    XCTAssertEqual(2, requests.count);
+    XCTAssertEqualObjects(@"gzip", requests[0].headers[@"content-encoding"]);
+    XCTAssertEqual(compressedBytesCount, requests[0].body.length);
+    XCTAssertEqualObjects(payloadData, [self gunzip:requests[0].body]);
+    XCTAssertNil(requests[1].headers[@"content-encoding"]);
+    XCTAssertEqualObjects(payloadData, requests[1].body);
+}
+
 #pragma mark - performance tests
 
 - (void)testPerformanceRollbarSenderInstantiation{
@@ -131,4 +280,33 @@
         RollbarPayloadPostReply *reply = [sender sendPayload:payloadData usingConfig:[self getConfig_Live_Default]];
     }];
 }
+
+#pragma mark - helpers
+
+- (nullable NSData *)gunzip:(nonnull NSData *)data {
+    
+    z_stream stream = {0};
+    // 15 window bits plus 16 accepts only a gzip header and trailer:
+    if (Z_OK != inflateInit2(&stream, 15 + 16)) {
+        return nil;
+    }
+    
+    NSMutableData *inflated = [NSMutableData dataWithLength:data.length * 4];
+    stream.next_in = (Bytef *)data.bytes;
+    stream.avail_in = (uInt)data.length;
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.total_out >= inflated.length) {
+            inflated.length *= 2;
+        }
+        stream.next_out = (Bytef *)inflated.mutableBytes + stream.total_out;
+        stream.avail_out = (uInt)(inflated.length - stream.total_out);
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+    inflated.length = stream.total_out;
+    inflateEnd(&stream);
+    
+    return (result == Z_STREAM_END) ? inflated : nil;
+}
+
 @end
@@ -0,0 +1,52 @@
+//
+//  RollbarStandInServer.h
+//  
+//
+//  A minimal local HTTP server standing in for the Rollbar API in sender tests.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A request as the server received it.
+@interface RollbarStandInRequest : NSObject
+
+/// The request's header fields, keyed by their lowercased names.
+@property (readonly, nonnull) NSDictionary<NSString *, NSString *> *headers;
+
+/// The request's body, exactly as it was sent.
+@property (readonly, nonnull) NSData *body;
+
+@end
+
+@interface RollbarStandInServer : NSObject
+
+/// The port the server listens on, once started.
+@property (readonly) NSUInteger port;
+
+/// The endpoint to post payloads to, once started.
+@property (readonly, nonnull) NSString *endpoint;
+
+/// The number of requests answered so far.
+@property (readonly) NSUInteger requestCount;
+
+/// The requests received so far, in the order they arrived.
+@property (readonly, nonnull) NSArray<RollbarStandInRequest *> *requests;
+
+/// The most requests that were waiting for their responses at the same time.
+@property (readonly) NSUInteger maximumRequestsInFlight;
+
+/// Creates a server that answers every request with 200 OK after the given delay,
+/// like a remote server would after a round trip.
+- (instancetype)initWithResponseDelay:(NSTimeInterval)responseDelay NS_DESIGNATED_INITIALIZER;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Starts listening on a free port of the loopback interface.
+- (BOOL)start;
+
+- (void)stop;
+
+@end
+
+NS_ASSUME_NONNULL_END
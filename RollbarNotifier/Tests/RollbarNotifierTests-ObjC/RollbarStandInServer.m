@@ -0,0 +1,257 @@
+//
+//  RollbarStandInServer.m
+//  
+//
+//  A minimal local HTTP server standing in for the Rollbar API in sender tests.
+//
+
+#import "RollbarStandInServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static char const RESPONSE[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 30\r\n"
+    "x-rate-limit-limit: 100000\r\n"
+    "x-rate-limit-remaining: 100000\r\n"
+    "x-rate-limit-remaining-seconds: 60\r\n"
+    "\r\n"
+    "{\"err\":0,\"result\":{\"id\":null}}";
+
+@implementation RollbarStandInRequest
+
+- (instancetype)initWithHeaders:(nonnull NSDictionary<NSString *, NSString *> *)headers
+                           body:(nonnull NSData *)body {
+    
+    if (self = [super init]) {
+        self->_headers = headers;
+        self->_body = body;
+    }
+    return self;
+}
+
+@end
+
+@implementation RollbarStandInServer {
+    @private
+    NSTimeInterval _responseDelay;
+    int _listener;
+    dispatch_queue_t _queue;
+    dispatch_source_t _acceptSource;
+    NSMutableSet<dispatch_source_t> *_connections;
+    NSUInteger _requestCount;
+    NSMutableArray<RollbarStandInRequest *> *_requests;
+    NSUInteger _requestsInFlight;
+    NSUInteger _maximumRequestsInFlight;
+}
+
+- (instancetype)initWithResponseDelay:(NSTimeInterval)responseDelay {
+    
+    if (self = [super init]) {
+        self->_responseDelay = responseDelay;
+        self->_listener = -1;
+        self->_queue = dispatch_queue_create("com.rollbar.tests.standInServer", DISPATCH_QUEUE_SERIAL);
+        self->_connections = [NSMutableSet set];
+        self->_requests = [NSMutableArray array];
+        self->_endpoint = @"";
+    }
+    return self;
+}
+
+- (void)dealloc {
+    
+    [self stop];
+}
+
+- (NSUInteger)requestCount {
+    
+    __block NSUInteger count;
+    dispatch_sync(self->_queue, ^{
+        count = self->_requestCount;
+    });
+    return count;
+}
+
+- (nonnull NSArray<RollbarStandInRequest *> *)requests {
+    
+    __block NSArray<RollbarStandInRequest *> *requests;
+    dispatch_sync(self->_queue, ^{
+        requests = [self->_requests copy];
+    });
+    return requests;
+}
+
+- (NSUInteger)maximumRequestsInFlight {
+    
+    __block NSUInteger count;
+    dispatch_sync(self->_queue, ^{
+        count = self->_maximumRequestsInFlight;
+    });
+    return count;
+}
+
+- (BOOL)start {
+    
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        return NO;
+    }
+    
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    struct sockaddr_in address = {0};
+    address.sin_len = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0; // any free port
+    
+    socklen_t addressLength = sizeof(address);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(listener, SOMAXCONN) != 0
+        || getsockname(listener, (struct sockaddr *)&address, &addressLength) != 0) {
+        
+        close(listener);
+        return NO;
+    }
+    
+    self->_listener = listener;
+    self->_port = ntohs(address.sin_port);
+    self->_endpoint = [NSString stringWithFormat:@"http://127.0.0.1:%lu/api/1/item/", (unsigned long)self->_port];
+    
+    self->_acceptSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, listener, 0, self->_queue);
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(self->_acceptSource, ^{
+        int connection = accept(listener, NULL, NULL);
+        if (connection >= 0) {
+            [weakSelf serveConnection:connection];
+        }
+    });
+    dispatch_source_set_cancel_handler(self->_acceptSource, ^{
+        close(listener);
+    });
+    dispatch_resume(self->_acceptSource);
+    
+    return YES;
+}
+
+- (void)stop {
+    
+    if (self->_listener < 0) {
+        return;
+    }
+    self->_listener = -1;
+    
+    dispatch_sync(self->_queue, ^{
+        dispatch_source_cancel(self->_acceptSource);
+        for (dispatch_source_t connection in self->_connections) {
+            dispatch_source_cancel(connection);
+        }
+        [self->_connections removeAllObjects];
+    });
+}
+
+/// Reads requests off a keep-alive connection and answers each of them in order.
+/// Always called on the server's queue.
+- (void)serveConnection:(int)connection {
+    
+    int noSigPipe = 1;
+    setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+    
+    NSMutableData *buffer = [NSMutableData data];
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, connection, 0, self->_queue);
+    [self->_connections addObject:source];
+    
+    __weak typeof(self) weakSelf = self;
+    __weak dispatch_source_t weakSource = source;
+    dispatch_source_set_event_handler(source, ^{
+        char bytes[16 * 1024];
+        ssize_t length = read(connection, bytes, sizeof(bytes));
+        if (length <= 0) {
+            dispatch_source_t strongSource = weakSource;
+            if (strongSource) {
+                [weakSelf closeConnection:strongSource];
+            }
+            return;
+        }
+        
+        [buffer appendBytes:bytes length:length];
+        NSArray<RollbarStandInRequest *> *requests = [RollbarStandInServer consumeRequestsFromBuffer:buffer];
+        if (requests.count > 0) {
+            [weakSelf respondTo:requests onConnection:connection];
+        }
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+        close(connection);
+    });
+    dispatch_resume(source);
+}
+
+- (void)closeConnection:(nonnull dispatch_source_t)source {
+    
+    [self->_connections removeObject:source];
+    dispatch_source_cancel(source);
+}
+
+- (void)respondTo:(nonnull NSArray<RollbarStandInRequest *> *)receivedRequests onConnection:(int)connection {
+    
+    [self->_requests addObjectsFromArray:receivedRequests];
+    NSUInteger requests = receivedRequests.count;
+    self->_requestsInFlight += requests;
+    self->_maximumRequestsInFlight = MAX(self->_maximumRequestsInFlight, self->_requestsInFlight);
+    
+    dispatch_time_t when = dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self->_responseDelay * NSEC_PER_SEC));
+    dispatch_after(when, self->_queue, ^{
+        for (NSUInteger i = 0; i < requests; i++) {
+            write(connection, RESPONSE, sizeof(RESPONSE) - 1);
+        }
+        self->_requestCount += requests;
+        self->_requestsInFlight -= requests;
+    });
+}
+
+/// Removes every complete request from the start of the buffer and returns them.
++ (nonnull NSArray<RollbarStandInRequest *> *)consumeRequestsFromBuffer:(nonnull NSMutableData *)buffer {
+    
+    NSData *separator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+    NSMutableArray<RollbarStandInRequest *> *requests = [NSMutableArray array];
+    
+    while (YES) {
+        NSRange headerEnd = [buffer rangeOfData:separator options:0 range:NSMakeRange(0, buffer.length)];
+        if (headerEnd.location == NSNotFound) {
+            break;
+        }
+        
+        NSString *header = [[NSString alloc] initWithBytes:buffer.bytes
+                                                    length:headerEnd.location
+                                                  encoding:NSASCIIStringEncoding];
+        // the first line is the request line, the rest are header fields:
+        NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+        for (NSString *line in [header componentsSeparatedByString:@"\r\n"]) {
+            NSRange colon = [line rangeOfString:@":"];
+            if (colon.location != NSNotFound) {
+                NSString *name = [line substringToIndex:colon.location].lowercaseString;
+                headers[name] = [[line substringFromIndex:NSMaxRange(colon)]
+                                 stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+            }
+        }
+        NSUInteger contentLength = (NSUInteger)[headers[@"content-length"] integerValue];
+        
+        NSUInteger requestLength = NSMaxRange(headerEnd) + contentLength;
+        if (buffer.length < requestLength) {
+            break;
+        }
+        
+        NSData *body = [buffer subdataWithRange:NSMakeRange(NSMaxRange(headerEnd), contentLength)];
+        [requests addObject:[[RollbarStandInRequest alloc] initWithHeaders:headers body:body]];
+        [buffer replaceBytesInRange:NSMakeRange(0, requestLength) withBytes:NULL length:0];
+    }
+    
+    return requests;
+}
+
+@end
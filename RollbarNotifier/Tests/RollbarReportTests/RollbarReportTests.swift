@@ -4,11 +4,16 @@ import XCTest
 
 final class RollbarReportTests: XCTestCase {
 
-    func testRollbarReportDiagnostics() {
-        let report = Bundle.module
-            .url(forResource: "crash.json", withExtension: .none)
+    /// Loads and parses one of the JSON reports in Assets.
+    private func jsonFixture(_ name: String) -> Any? {
+        Bundle.module
+            .url(forResource: name, withExtension: .none)
             .flatMap { try? Data(contentsOf: $0) }
             .flatMap { try? JSONSerialization.jsonObject(with: $0) }
+    }
+
+    func testRollbarReportDiagnostics() {
+        let report = jsonFixture("crash.json")
 
         XCTAssertNotNil(report)
 
@@ -32,10 +37,7 @@ final class RollbarReportTests: XCTestCase {
     }
 
     func testRollbarReportFormatting() {
-        let diagnosedCrash = Bundle.module
-            .url(forResource: "diagnosed.json", withExtension: .none)
-            .flatMap { try! Data(contentsOf: $0) }
-            .flatMap { try! JSONSerialization.jsonObject(with: $0) }
+        let diagnosedCrash = jsonFixture("diagnosed.json")
 
         let expectReport = Bundle.module
             .url(forResource: "report.crash", withExtension: .none)
@@ -62,14 +64,87 @@ final class RollbarReportTests: XCTestCase {
             for line in zip(rs, ex) {
                 XCTAssertEqual(line.0, line.1)
             }
+
+            // Blank lines and padding must match too, byte for byte.
+            XCTAssertEqual(Array((report + "\n").utf8), Array(expectReport.utf8))
         }
     }
     
+    func testRollbarReportBinaryImageLookup() {
+        let diagnosedCrash = jsonFixture("diagnosed.json")
+
+        guard let report = diagnosedCrash as? Report,
+              case let .success(binaryImages) = report.binaryImages
+        else {
+            return XCTFail()
+        }
+
+        let index = CrashReport(report).images
+        XCTAssertEqual(index.images.count, binaryImages.count)
+
+        for image in binaryImages {
+            XCTAssertEqual(index.image(containing: .memory(image.addr.start.value))?.path, image.path)
+            XCTAssertEqual(index.image(containing: .memory(image.addr.end.value))?.path, image.path)
+        }
+
+        XCTAssertNil(index.image(containing: .memory(0)))
+        XCTAssertNil(index.image(containing: .memory(UInt.max)))
+        XCTAssertNil(BinaryImageIndex.empty.image(containing: .memory(0x1000)))
+    }
+
+    func testRollbarReportDecodingPerformance() {
+        let diagnosedCrash = jsonFixture("diagnosed.json")
+
+        guard let report = diagnosedCrash as? Report else {
+            return XCTFail()
+        }
+
+        measure {
+            for _ in 0..<10 {
+                XCTAssertEqual(CrashReport(report).crash.threads.count, 13)
+            }
+        }
+    }
+
+    func testRollbarReportFormattingPerformance() {
+        let diagnosedCrash = jsonFixture("diagnosed.json")
+
+        XCTAssertNotNil(diagnosedCrash)
+
+        let filter = RollbarCrashFormattingFilter()
+        measure {
+            for _ in 0..<10 {
+                filter.filterReports([diagnosedCrash!]) { reports, didComplete, error in
+                    XCTAssertTrue(didComplete)
+                    XCTAssertEqual(reports?.count, 1)
+                }
+            }
+        }
+    }
+
+    func testRollbarReportFormattingLargeReportPerformance() {
+        guard var report = jsonFixture("diagnosed.json") as? Report,
+              var crash = report["crash"] as? Report,
+              let threads = crash["threads"] as? [Any]
+        else {
+            return XCTFail()
+        }
+
+        // a report the size of a busy app's, with hundreds of threads:
+        crash["threads"] = Array(repeating: threads, count: 40).flatMap { $0 }
+        report["crash"] = crash
+
+        let filter = RollbarCrashFormattingFilter()
+        measure(metrics: [XCTClockMetric(), XCTMemoryMetric()]) {
+            filter.filterReports([report]) { reports, didComplete, error in
+                XCTAssertTrue(didComplete)
+                XCTAssertEqual(reports?.count, 1)
+            }
+        }
+    }
+
     func testRollbarReportFormattingDoesntCrash() {
-        let diagnosedCrash = Bundle.module
-            .url(forResource: "diagnosed_invalid.json", withExtension: .none)
-            .flatMap { try! Data(contentsOf: $0) }
-            .flatMap { try! JSONSerialization.jsonObject(with: $0) }
+        let diagnosedCrash = jsonFixture("diagnosed_invalid.json")
 
         XCTAssertNotNil(diagnosedCrash)
 
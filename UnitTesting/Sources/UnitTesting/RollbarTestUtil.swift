@@ -92,6 +92,9 @@ import RollbarCommon
     @objc public static func deletePayloadsStoreFile() {
         let filePath = RollbarTestUtil.getPayloadsStoreFilePath();
         RollbarTestUtil.deleteFile(filePath: filePath);
+        // a leftover write-ahead log would be replayed into the next store:
+        RollbarTestUtil.deleteFile(filePath: filePath + "-wal");
+        RollbarTestUtil.deleteFile(filePath: filePath + "-shm");
     }
     
     @objc public static func clearTelemetryFile() {